@@ -1,5 +1,6 @@
 #include <cassert>
 #include <cstdio>
+#include <cstring>
 #include <iostream>
 #include <fstream>
 #include <algorithm>
@@ -11,6 +12,10 @@ using namespace std;
 
 #define cout fout
 const bool DEBUG = false;
+// 是否进行尾调用优化: 尾调用直接复用当前函数的栈帧
+bool backTailCall = false;
+// 前端生成的只读全局变量, 由 main 在生成 IR 之后设置
+std::set<std::string> backReadOnlyGlobals;
 
 ofstream fout;
 
@@ -89,6 +94,57 @@ void Visit_Program(const koopa_raw_program_t &program) {
     
     // 访问所有函数
     Visit_Slice(program.funcs);
+
+    // 生成中端优化用到的运行时库函数
+    Emit_Runtime_Helpers(program);
+}
+
+// 生成运行时库函数 (只生成程序中声明了的)
+//   __memset_i32(a0 = dst, a1 = value, a2 = count)
+//   __memcpy_i32(a0 = dst, a1 = src, a2 = count), 按下标从小到大逐个复制, 每个元素先读后写
+// 都是每次处理 4 个元素的循环加上逐个处理剩余元素的循环, 只使用 a0~a2, t0, t1
+void Emit_Runtime_Helpers(const koopa_raw_program_t &program) {
+    for (size_t i = 0; i < program.funcs.len; i++) {
+        koopa_raw_function_t func = reinterpret_cast<koopa_raw_function_t>(program.funcs.buffer[i]);
+        if (func->bbs.len != 0) continue;
+        string name = func->name + 1;
+        if (name != "__memset_i32" && name != "__memcpy_i32") continue;
+        bool copy = name == "__memcpy_i32";
+
+        cout << "\n";
+        cout << "\t.text\n";
+        cout << "\t.globl " << name << "\n";
+        cout << name << ":\n";
+        cout << "\tli   t0, 4\n";
+        cout << "\tblt  a2, t0, " << name << "_tail\n";
+        cout << name << "_loop4:\n";
+        for (int k = 0; k < 4; k++) {
+            if (copy) {
+                cout << "\tlw   t1, " << k * 4 << "(a1)\n";
+                cout << "\tsw   t1, " << k * 4 << "(a0)\n";
+            } else {
+                cout << "\tsw   a1, " << k * 4 << "(a0)\n";
+            }
+        }
+        cout << "\taddi a0, a0, 16\n";
+        if (copy) cout << "\taddi a1, a1, 16\n";
+        cout << "\taddi a2, a2, -4\n";
+        cout << "\tbge  a2, t0, " << name << "_loop4\n";
+        cout << name << "_tail:\n";
+        cout << "\tblez a2, " << name << "_end\n";
+        if (copy) {
+            cout << "\tlw   t1, 0(a1)\n";
+            cout << "\tsw   t1, 0(a0)\n";
+            cout << "\taddi a1, a1, 4\n";
+        } else {
+            cout << "\tsw   a1, 0(a0)\n";
+        }
+        cout << "\taddi a0, a0, 4\n";
+        cout << "\taddi a2, a2, -1\n";
+        cout << "\tj    " << name << "_tail\n";
+        cout << name << "_end:\n";
+        cout << "\tret\n";
+    }
 }
 
 // 访问 raw slice
@@ -130,10 +186,14 @@ void Visit_Slice(const koopa_raw_slice_t &slice) {
 
 
 /*====================  函数部分 =======================*/ 
+// 按顺序排列时, 当前基本块之后的基本块
+koopa_raw_basic_block_t next_bb = NULL;
 // 当前函数已经使用的栈的大小(单位: 字节)
 int32_t use_stack = 0;
 // 进入当前函数时, 使用的栈的大小(单位: 字节)
 int32_t need_stack = 0;
+// 当前函数中保存参数的栈空间 => 是否只被 store 过函数参数
+std::map<koopa_raw_value_t, bool> param_slot;
 
 // 访问函数
 void Visit_Function(const koopa_raw_function_t &func) {
@@ -171,9 +231,17 @@ void Visit_Function(const koopa_raw_function_t &func) {
     // koopa_raw_slice_t params, 需要通过Slice进行进一步划分
     // Visit_Slice(func->params);
 
+    // 尾调用的实参可能从保存参数的栈空间中读出, 需要知道哪些栈空间只保存了函数参数
+    if (backTailCall) Find_Param_Slots(func);
+
     // 访问当前函数的所有基本块
     // koopa_raw_slice_t bbs, 需要通过Slice进行进一步划分
-    Visit_Slice(func->bbs);
+    // 记录下一个基本块, 跳转到下一个基本块时不需要输出 j
+    for (size_t i = 0; i < func->bbs.len; ++i) {
+        next_bb = i + 1 < func->bbs.len ? reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i + 1]) : NULL;
+        Visit_Basic_Block(reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]));
+    }
+    next_bb = NULL;
 
     // 判断当前函数的返回值
     // koopa_raw_type_t Return_Type = func->ty
@@ -304,7 +372,73 @@ void Visit_Basic_Block(const koopa_raw_basic_block_t &bb) {
 
     // 访问所有指令
     // koopa_raw_slice_t insts, 需要通过Slice进行进一步划分
-    Visit_Slice(bb->insts);
+    // 开启尾调用优化时, 尾调用和其后的 return 一起处理
+    for (size_t i = 0; i < bb->insts.len; ++i) {
+        koopa_raw_value_t value = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[i]);
+        if (backTailCall && Is_Tail_Call(bb, i)) {
+            Visit_Inst_Tail_Call(value, reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[i + 1]));
+            i++;
+            continue;
+        }
+        Visit_Inst(value);
+    }
+}
+
+// 判断基本块中第 i 条指令是否是可以复用栈帧的尾调用
+// 即: call 之后紧跟着 ret, 并且返回的就是 call 的结果 (或者没有返回值)
+bool Is_Tail_Call(const koopa_raw_basic_block_t &bb, size_t i) {
+    if (i + 2 != bb->insts.len) return false;
+    koopa_raw_value_t value = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[i]);
+    koopa_raw_value_t next = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[i + 1]);
+    if (value->kind.tag != KOOPA_RVT_CALL || next->kind.tag != KOOPA_RVT_RETURN) return false;
+    if (next->kind.data.ret.value != NULL && next->kind.data.ret.value != value) return false;
+
+    // 当前栈帧会在跳转之前释放, 因此实参不能指向当前栈帧中的局部数组
+    const koopa_raw_slice_t &args = value->kind.data.call.args;
+    if (args.len > 8) return false;
+    for (size_t j = 0; j < args.len; ++j) {
+        koopa_raw_value_t arg = reinterpret_cast<koopa_raw_value_t>(args.buffer[j]);
+        if (arg->ty->tag == KOOPA_RTT_POINTER && Points_Into_Frame(arg)) return false;
+    }
+    return true;
+}
+
+// 找出当前函数中所有 store 的值都是函数参数的局部变量
+// 内联之后, 被内联函数的参数栈空间中保存的可能是调用者的局部数组
+void Find_Param_Slots(const koopa_raw_function_t &func) {
+    param_slot.clear();
+    for (size_t i = 0; i < func->bbs.len; ++i) {
+        koopa_raw_basic_block_t bb = reinterpret_cast<koopa_raw_basic_block_t>(func->bbs.buffer[i]);
+        for (size_t j = 0; j < bb->insts.len; ++j) {
+            koopa_raw_value_t inst = reinterpret_cast<koopa_raw_value_t>(bb->insts.buffer[j]);
+            if (inst->kind.tag != KOOPA_RVT_STORE) continue;
+            koopa_raw_value_t dest = inst->kind.data.store.dest;
+            bool isArg = inst->kind.data.store.value->kind.tag == KOOPA_RVT_FUNC_ARG_REF;
+            auto it = param_slot.find(dest);
+            param_slot[dest] = isArg && (it == param_slot.end() || it->second);
+        }
+    }
+}
+
+// 判断指针是否可能指向当前栈帧
+bool Points_Into_Frame(koopa_raw_value_t value) {
+    while (true) {
+        switch (value->kind.tag) {
+            case KOOPA_RVT_GET_PTR: { value = value->kind.data.get_ptr.src; break; }
+            case KOOPA_RVT_GET_ELEM_PTR: { value = value->kind.data.get_elem_ptr.src; break; }
+            // 全局数组
+            case KOOPA_RVT_GLOBAL_ALLOC: return false;
+            // 保存在栈上的数组参数, 指向调用者的栈帧或者全局数组
+            // 其他的 load 读出的指针可能指向当前栈帧
+            case KOOPA_RVT_LOAD: {
+                auto it = param_slot.find(value->kind.data.load.src);
+                return it == param_slot.end() || !it->second;
+            }
+            case KOOPA_RVT_FUNC_ARG_REF: return false;
+            // 局部数组, 以及其他无法确定的情况
+            default: return true;
+        }
+    }
 }
 
 
@@ -394,38 +528,51 @@ int32_t Visit_Inst_Integer(const koopa_raw_integer_t &integer){
     return integer.value;
 }
 
+// 把 aggregate 展开为按顺序排列的元素
+void Flatten_Aggregate(const koopa_raw_aggregate_t &aggregate, vector<int32_t> &words){
+    koopa_raw_slice_t elems = aggregate.elems;
+    for(int i = 0; i < elems.len; i++){
+        // 当前slice的类型必须为value语句
+        if(elems.kind != KOOPA_RSIK_VALUE){
+            printf("[Flatten_Aggregate] elems.kind = %d\n", elems.kind);
+            assert(0);
+        }
+        koopa_raw_value_t value = reinterpret_cast<koopa_raw_value_t>(elems.buffer[i]);
+        koopa_raw_value_kind_t kind = value->kind;
+        if(kind.tag == KOOPA_RVT_INTEGER){
+            words.push_back(Visit_Inst_Integer(kind.data.integer));
+        } else if(kind.tag == KOOPA_RVT_AGGREGATE){
+            // 用 aggregate进行初始化, 是多维数组
+            Flatten_Aggregate(kind.data.aggregate, words);
+        } else if(kind.tag == KOOPA_RVT_ZERO_INIT){
+            words.insert(words.end(), Get_Array_Len(value->ty), 0);
+        } else{
+            printf("[Flatten_Aggregate] kind.tag = %d\n", kind.tag);
+            assert(0);
+        }
+    }
+}
+
 // 访问 aggregate 指令, 进行数组的初始化操作, 返回栈的起始地址 (tag = 3)
+// 连续的 0 合并为一条 .zero
 int32_t Visit_Inst_Aggregate(const koopa_raw_aggregate_t &aggregate){
     // printf("-----------Visit_Inst_Aggregate-----------\n");
     
     int32_t now_stack = use_stack;
-    // 取出 aggregate 中的元素
-    koopa_raw_slice_t elems = aggregate.elems;
-    // 遍历elems中的每一个元素
-    for(int i = 0; i < elems.len; i++){
-        // 当前elems的内容
-        auto ptr = elems.buffer[i];
-        
-        // 当前slice的类型必须为value语句
-        if (elems.kind == KOOPA_RSIK_VALUE){
-            koopa_raw_value_t value = reinterpret_cast<koopa_raw_value_t>(ptr);
-            koopa_raw_value_kind_t kind = value->kind;
-            if(kind.tag == KOOPA_RVT_INTEGER){
-                // 用 integer 进行初始化
-                cout << "\t.word " << Visit_Inst_Integer(kind.data.integer) << "\n";
-                use_stack += 4;
-            } else if(kind.tag == KOOPA_RVT_AGGREGATE){
-                // 用 aggregate进行初始化, 是多维数组
-                Visit_Inst_Aggregate(kind.data.aggregate);
-            } else{
-                printf("[Visit_Inst_Aggregate] kind.tag = %d\n", kind.tag);
-                assert(0);
-            }
-        } else {
-            printf("[Visit_Inst_Aggregate] elems.kind = %d\n", elems.kind);
-            assert(0);
+    vector<int32_t> words;
+    Flatten_Aggregate(aggregate, words);
+    for(size_t i = 0; i < words.size(); ){
+        if(words[i] != 0){
+            cout << "\t.word " << words[i] << "\n";
+            i++;
+            continue;
         }
+        size_t j = i;
+        while(j < words.size() && words[j] == 0) j++;
+        cout << "\t.zero " << 4 * (j - i) << "\n";
+        i = j;
     }
+    use_stack += 4 * words.size();
     return now_stack;
 }
 
@@ -483,7 +630,13 @@ int32_t Visit_Inst_Alloc(const koopa_raw_type_t &alloc_type){
 int32_t Visit_Inst_Global_Alloc(const koopa_raw_global_alloc_t &global_alloc, const char* name){
     // printf("----------- Visit_Inst_Global_Alloc -----------\n");
 
-    cout << "\t.data\n";
+    // 前端生成的只读数据放入 .rodata, 其他放入 .data
+    if(backReadOnlyGlobals.count(name)){
+        cout << "\t.section .rodata\n";
+        cout << "\t.align 2\n";
+    } else{
+        cout << "\t.data\n";
+    }
     koopa_raw_value_t init = global_alloc.init;
 
     // 变量的类型
@@ -924,7 +1077,7 @@ int32_t Visit_Inst_Branch(const koopa_raw_branch_t &branch){
 
     // 输出条件跳转语句
     cout << "\tbnez t0, " << true_bb->name + 1 << "\n";
-    cout << "\tj    " << false_bb->name + 1 << "\n";
+    if (false_bb != next_bb) cout << "\tj    " << false_bb->name + 1 << "\n";
     cout << "\n";
     return 0;
 }
@@ -936,7 +1089,8 @@ int32_t Visit_Inst_Jump(const koopa_raw_jump_t &jump){
     koopa_raw_basic_block_t target_bb = jump.target;
 	// koopa_raw_slice_t args = jump.args;
 
-    cout << "\tj    " << target_bb->name + 1 << "\n";
+    // 目标是下一个基本块时, 直接顺序执行
+    if (target_bb != next_bb) cout << "\tj    " << target_bb->name + 1 << "\n";
     cout << "\n";
     return 0;
 }
@@ -1015,6 +1169,48 @@ int32_t Visit_Inst_Call(const koopa_raw_call_t &call){
     return ret_type == KOOPA_RTT_INT32 ? use_stack-4 : 0;
 }
 
+// 访问尾调用: call 及其之后的 ret 指令
+// 参数放入 a0~a7 之后, 恢复 ra 并释放当前栈帧, 再直接跳转到被调用的函数, 由它返回到当前函数的调用者
+int32_t Visit_Inst_Tail_Call(const koopa_raw_value_t &value, const koopa_raw_value_t &ret){
+    // printf("-----------Visit_Inst_Tail_Call ----------\n");
+
+    koopa_raw_function_t callee = value->kind.data.call.callee;
+    koopa_raw_slice_t args = value->kind.data.call.args;
+
+    for (size_t i = 0; i < args.len; ++i) {
+        koopa_raw_value_t arg = reinterpret_cast<koopa_raw_value_t>(args.buffer[i]);
+        // 将arg放入ai寄存器中
+        if(arg->kind.tag == KOOPA_RVT_INTEGER){
+            // arg是整数指令
+            cout << "\tli   a" << i <<  ", " << Visit_Inst_Integer(arg->kind.data.integer) << "\n";
+        } else if(arg->kind.tag == KOOPA_RVT_FUNC_ARG_REF){
+            // arg是函数参数
+            int index = Visit_Inst_Func_Arg_Ref(arg->kind.data.func_arg_ref);
+            cout << "\tmv   a" << i <<  ", a" << index << "\n";
+        } else{
+            // 其他情况, arg一定在内存中, 此时没有压栈, 不需要调整偏移量
+            cout << "\tli   t3, " << Visit_Inst(arg) << "\n";
+            cout << "\tadd  t3, t3, sp\n";
+            cout << "\tlw   a" << i <<  ", 0(t3)\n";
+        }
+    }
+
+    // 取出返回地址
+    cout << "\tli   t3, " << need_stack-4 << "\n";
+    cout << "\tadd  t3, t3, sp\n";
+    cout << "\tlw   ra, 0(t3)\n";
+    // 恢复栈空间
+    cout << "\tli   t0, " << need_stack << "\n";
+    cout << "\tadd  sp, sp, t0\n";
+    // 跳转到被调用的函数
+    cout << "\ttail " << callee->name+1 << "\n";
+    cout << "\n";
+
+    // call 和 ret 都已经处理完毕
+    inst_to_index[ret] = 0;
+    return inst_to_index[value] = 0;
+}
+
 // 访问 return 指令 (tag = 16)
 int32_t Visit_Inst_Return(const koopa_raw_return_t &ret){
     // printf("-----------Visit_Inst_Return---------------\n");
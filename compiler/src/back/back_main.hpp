@@ -1,6 +1,14 @@
 #pragma once
+#include <set>
+#include <string>
+#include <vector>
 #include "koopa.h"
 
+// 是否进行尾调用优化 (-ftail-call)
+extern bool backTailCall;
+// 前端生成的只读全局变量 (常量数组, 数组初始化的模板), 放入 .rodata
+extern std::set<std::string> backReadOnlyGlobals;
+
 void back_main(const char input[], const char output[]);
 
 // 从文本IR中解析KoopaIR
@@ -14,6 +22,9 @@ void Visit_Program(const koopa_raw_program_t &program);
 // 访问 raw slice
 void Visit_Slice(const koopa_raw_slice_t &slice);
 
+// 生成中端优化用到的运行时库函数 (__memset_i32 / __memcpy_i32)
+void Emit_Runtime_Helpers(const koopa_raw_program_t &program);
+
 /*====================  指令部分 =======================*/ 
 // 访问函数
 void Visit_Function(const koopa_raw_function_t &func);
@@ -21,6 +32,12 @@ void Visit_Function(const koopa_raw_function_t &func);
 int32_t Get_Basic_Block_Need_Stack(const koopa_raw_basic_block_t &bbs);
 // 访问基本块
 void Visit_Basic_Block(const koopa_raw_basic_block_t &bb);
+// 判断基本块中第 i 条指令是否是可以复用栈帧的尾调用
+bool Is_Tail_Call(const koopa_raw_basic_block_t &bb, size_t i);
+// 找出当前函数中只保存函数参数的栈空间
+void Find_Param_Slots(const koopa_raw_function_t &func);
+// 判断指针是否可能指向当前栈帧
+bool Points_Into_Frame(koopa_raw_value_t value);
 
 
 /*====================  指令部分 =======================*/ 
@@ -28,6 +45,8 @@ void Visit_Basic_Block(const koopa_raw_basic_block_t &bb);
 int32_t Visit_Inst(const koopa_raw_value_t &value);
 // 访问 integer 指令, 返回整数值 (tag = 0)
 int32_t Visit_Inst_Integer(const koopa_raw_integer_t &integer);
+// 把 aggregate 展开为按顺序排列的元素
+void Flatten_Aggregate(const koopa_raw_aggregate_t &aggregate, std::vector<int32_t> &words);
 // 访问 aggregate 指令, 进行数组的初始化操作 (tag = 3)
 int32_t Visit_Inst_Aggregate(const koopa_raw_aggregate_t &aggregate);
 // 访问 func_arg_ref 指令, 返回是第x个参数 (tag = 4)
@@ -52,5 +71,7 @@ int32_t Visit_Inst_Branch(const koopa_raw_branch_t &branch);
 int32_t Visit_Inst_Jump(const koopa_raw_jump_t &jump);
 // 访问 call 指令 (tag = 15)
 int32_t Visit_Inst_Call(const koopa_raw_call_t &call);
+// 访问尾调用: call 及其之后的 ret 指令
+int32_t Visit_Inst_Tail_Call(const koopa_raw_value_t &value, const koopa_raw_value_t &ret);
 // 访问 return 指令 (tag = 16)
 int32_t Visit_Inst_Return(const koopa_raw_return_t &ret);
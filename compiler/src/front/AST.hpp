@@ -1,15 +1,158 @@
 #pragma once
 #include <iostream>
 #include <map>
+#include <set>
 #include <vector>
+#include <memory>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include "arena.hpp"
+#include "ir_writer.hpp"
+#include "value.hpp"
+#include "exp_pool.hpp"
 
 /**************** 符号表 ****************/
 
+// 标识符驻留表: lexer 把每个标识符换成一个从 0 开始的编号, 相同的标识符编号相同
+// 名字只在 astArena 中存储一份, 符号表以编号为键, 不再复制和比较字符串
+class Identifiers {
+public:
+    int Intern(const char *str, size_t len) {
+        if (2 * (names.size() + 1) > slots.size()) Rehash(slots.empty() ? 256 : slots.size() * 2);
+        uint32_t hash = Hash(str, len);
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+            int id = slots[i];
+            if (id == -1) {
+                id = names.size();
+                names.push_back(astArena.NewString(str, len));
+                lengths.push_back(len);
+                hashes.push_back(hash);
+                slots[i] = id;
+                return id;
+            }
+            if (hashes[id] == hash && lengths[id] == len && memcmp(names[id], str, len) == 0) return id;
+        }
+    }
+    int Intern(const char *str) {
+        return Intern(str, strlen(str));
+    }
+
+    const char *Name(int id) const {
+        return names[id];
+    }
+    int Size() const {
+        return names.size();
+    }
+
+    // 名字存放在 astArena 中, 需要与其一起清空
+    void Clear() {
+        names.clear();
+        lengths.clear();
+        hashes.clear();
+        slots.clear();
+    }
+
+private:
+    std::vector<const char *> names;
+    std::vector<size_t> lengths;
+    std::vector<uint32_t> hashes;
+    std::vector<int> slots;     // 开放定址 (线性探测) 的哈希表, -1 表示空位
+
+    // FNV-1a
+    static uint32_t Hash(const char *str, size_t len) {
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < len; i++) hash = (hash ^ (unsigned char)str[i]) * 16777619u;
+        return hash;
+    }
+
+    void Rehash(size_t size) {
+        slots.assign(size, -1);
+        for (size_t id = 0; id < names.size(); id++) {
+            size_t i = hashes[id] & (size - 1);
+            while (slots[i] != -1) i = (i + 1) & (size - 1);
+            slots[i] = id;
+        }
+    }
+};
+
+// 所有标识符, 定义在 SysY.y 中
+extern Identifiers identifiers;
+
+// 以标识符编号为键的哈希表: 开放定址 (线性探测), 键与值分别连续存放
+template <typename T>
+class IdMap {
+public:
+    T *Find(int key) {
+        if (count == 0) return nullptr;
+        size_t mask = keys.size() - 1;
+        for (size_t i = Slot(key); ; i = (i + 1) & mask) {
+            if (keys[i] == key) return &values[i];
+            if (keys[i] == -1) return nullptr;
+        }
+    }
+    const T *Find(int key) const {
+        return const_cast<IdMap *>(this)->Find(key);
+    }
+
+    // 插入新的键 (需要保证不存在), 返回对应的值
+    T &Insert(int key) {
+        if (2 * (count + 1) > keys.size()) Rehash(keys.empty() ? 16 : keys.size() * 2);
+        size_t mask = keys.size() - 1;
+        size_t i = Slot(key);
+        while (keys[i] != -1) i = (i + 1) & mask;
+        keys[i] = key;
+        values[i] = T();
+        count++;
+        return values[i];
+    }
+
+    size_t Size() const {
+        return count;
+    }
+
+    void Clear() {
+        keys.clear();
+        values.clear();
+        count = 0;
+    }
+
+private:
+    std::vector<int> keys;      // -1 表示空位
+    std::vector<T> values;
+    size_t count = 0;
+
+    // 编号是连续的小整数, 乘法散列后取高位分散到各个位置
+    size_t Slot(int key) const {
+        return ((uint32_t)key * 2654435769u) >> (32 - Log2(keys.size()));
+    }
+    static int Log2(size_t size) {
+        int bits = 0;
+        while (((size_t)1 << bits) < size) bits++;
+        return bits;
+    }
+
+    void Rehash(size_t size) {
+        std::vector<int> oldKeys(size, -1);
+        std::vector<T> oldValues(size);
+        oldKeys.swap(keys);
+        oldValues.swap(values);
+        size_t mask = size - 1;
+        for (size_t j = 0; j < oldKeys.size(); j++) {
+            if (oldKeys[j] == -1) continue;
+            size_t i = Slot(oldKeys[j]);
+            while (keys[i] != -1) i = (i + 1) & mask;
+            keys[i] = oldKeys[j];
+            values[i] = std::move(oldValues[j]);
+        }
+    }
+};
+
 class SymbolTable {
 public:
     struct Symbol {
-        enum Type { kConst, kVar, kFunc } type;
+        enum Type { kConst, kVar, kFunc, kConstArray } type;
         union { // XXX 每种类型的符号要存储的信息不同，且一个简单变量可能存不下，建议改为 struct
             int const_val;
             struct VarVal {
@@ -22,186 +165,173 @@ public:
                 bool *fParamIsArray; // DIRTY 参数是否为数组（指针）
             } func_val;
         } val;
+        // 常量数组: 编号与维数存放在 var_val 中, 另外记录各维长度与展开后的值
+        std::vector<int> const_array_dims;
+        std::shared_ptr<const std::vector<int> > const_array_vals;
     };
 
     SymbolTable() = default;
     ~SymbolTable() = default;
 
     void Clear() {
-        table.clear();
+        table.Clear();
+    }
+
+    // 查找符号, 不存在时返回 nullptr
+    const Symbol *Find(int name) const {
+        return table.Find(name);
     }
 
     // 插入常量符号定义
-    void AddConstSymbol(std::string name, int const_val) {
-        if (table.find(name) != table.end()) {
-            std::cerr << "SymbolTable::AddSymbol: symbol " << name << " already exists" << std::endl;
-            return;
-        }
-        Symbol symbol;
-        symbol.type = Symbol::kConst;
-        symbol.val.const_val = const_val;
-        table[name] = symbol;
+    void AddConstSymbol(int name, int const_val) {
+        Symbol *symbol = NewSymbol(name);
+        if (symbol == nullptr) return;
+        symbol->type = Symbol::kConst;
+        symbol->val.const_val = const_val;
     }
 
     // 插入变量符号定义
-    void AddVarSymbol(std::string name, int var_id, int var_dim) {
-        if (table.find(name) != table.end()) {
-            std::cerr << "SymbolTable::AddSymbol: symbol " << name << " already exists" << std::endl;
-            return;
-        }
-        Symbol symbol;
-        symbol.type = Symbol::kVar;
-        symbol.val.var_val.var_id = var_id;
-        symbol.val.var_val.var_dim = var_dim;
-        table[name] = symbol;
+    void AddVarSymbol(int name, int var_id, int var_dim) {
+        Symbol *symbol = NewSymbol(name);
+        if (symbol == nullptr) return;
+        symbol->type = Symbol::kVar;
+        symbol->val.var_val.var_id = var_id;
+        symbol->val.var_val.var_dim = var_dim;
+    }
+
+    // 插入常量数组符号定义
+    void AddConstArraySymbol(int name, int var_id, const std::vector<int> &dims, std::shared_ptr<const std::vector<int> > vals) {
+        Symbol *symbol = NewSymbol(name);
+        if (symbol == nullptr) return;
+        symbol->type = Symbol::kConstArray;
+        symbol->val.var_val.var_id = var_id;
+        symbol->val.var_val.var_dim = dims.size();
+        symbol->const_array_dims = dims;
+        symbol->const_array_vals = vals;
     }
 
     // 插入函数符号定义
-    void AddFuncSymbol(std::string name, int func_type, int fParamNum, bool *fParamIsArray) {
-        if (table.find(name) != table.end()) {
-            std::cerr << "SymbolTable::AddSymbol: symbol " << name << " already exists" << std::endl;
-            return;
-        }
-        Symbol symbol;
-        symbol.type = Symbol::kFunc;
-        symbol.val.func_val.func_type = func_type;
-        symbol.val.func_val.fParamNum = fParamNum;
-        symbol.val.func_val.fParamIsArray = fParamIsArray;
-        table[name] = symbol;
+    void AddFuncSymbol(int name, int func_type, int fParamNum, bool *fParamIsArray) {
+        Symbol *symbol = NewSymbol(name);
+        if (symbol == nullptr) return;
+        symbol->type = Symbol::kFunc;
+        symbol->val.func_val.func_type = func_type;
+        symbol->val.func_val.fParamNum = fParamNum;
+        symbol->val.func_val.fParamIsArray = fParamIsArray;
     }
 
     // 确认符号定义是否存在
-    bool HasSymbol(std::string name) {
-        return table.find(name) != table.end();
+    bool HasSymbol(int name) const {
+        return Find(name) != nullptr;
     }
 
-    Symbol::Type GetSymbolType(std::string name) {
-        if (table.find(name) == table.end()) {
-            std::cerr << "SymbolTable::GetSymbolType: symbol " << name << " not found" << std::endl;
-            return Symbol::kVar; // XXX 没有意义，只是为了不报错
+    int GetVarSymbolId(int name) const {
+        const Symbol *symbol = Find(name, "GetVarSymbolId");
+        if (symbol == nullptr) return 0;
+        if (symbol->type != Symbol::kVar && symbol->type != Symbol::kConstArray) {
+            std::cerr << "SymbolTable::GetVarSymbolId: symbol " << identifiers.Name(name) << " is not a var" << std::endl;
+            return 0;
         }
-        return table[name].type;
+        return symbol->val.var_val.var_id;
     }
 
-    int GetConstSymbolValue(std::string name) {
-        if (table.find(name) == table.end()) {
-            std::cerr << "SymbolTable::GetConstSymbolValue: symbol " << name << " not found" << std::endl;
-            return 0;
-        }
-        if (table[name].type != Symbol::kConst) {
-            std::cerr << "SymbolTable::GetConstSymbolValue: symbol " << name << " is not a const" << std::endl;
-            return 0;
-        }
-        return table[name].val.const_val;
+    int GetFuncSymbolType(int name) const {
+        const Symbol *symbol = FindFunc(name, "GetFuncSymbolType");
+        return symbol == nullptr ? 0 : symbol->val.func_val.func_type;
     }
 
-    int GetVarSymbolId(std::string name) {
-        if (table.find(name) == table.end()) {
-            std::cerr << "SymbolTable::GetVarSymbolId: symbol " << name << " not found" << std::endl;
-            return 0;
-        }
-        if (table[name].type != Symbol::kVar) {
-            std::cerr << "SymbolTable::GetVarSymbolId: symbol " << name << " is not a var" << std::endl;
-            return 0;
-        }
-        return table[name].val.var_val.var_id;
+    int GetFuncSymbolFParamNum(int name) const {
+        const Symbol *symbol = FindFunc(name, "GetFuncSymbolFParamNum");
+        return symbol == nullptr ? 0 : symbol->val.func_val.fParamNum;
     }
 
-    int GetVarSymbolDim(std::string name) {
-        if (table.find(name) == table.end()) {
-            std::cerr << "SymbolTable::GetVarSymbolDim: symbol " << name << " not found" << std::endl;
-            return 0;
-        }
-        if (table[name].type != Symbol::kVar) {
-            std::cerr << "SymbolTable::GetVarSymbolDim: symbol " << name << " is not a var" << std::endl;
-            return 0;
-        }
-        return table[name].val.var_val.var_dim;
+    bool *GetFuncSymbolFParamIsArray(int name) const {
+        const Symbol *symbol = FindFunc(name, "GetFuncSymbolFParamIsArray");
+        return symbol == nullptr ? nullptr : symbol->val.func_val.fParamIsArray;
     }
+private:
+    IdMap<Symbol> table;
 
-    int GetFuncSymbolType(std::string name) {
-        if (table.find(name) == table.end()) {
-            std::cerr << "SymbolTable::GetFuncSymbolType: symbol " << name << " not found" << std::endl;
-            return 0;
-        }
-        if (table[name].type != Symbol::kFunc) {
-            std::cerr << "SymbolTable::GetFuncSymbolType: symbol " << name << " is not a func" << std::endl;
-            return 0;
+    // 插入新符号, 已经存在时报错并返回 nullptr
+    Symbol *NewSymbol(int name) {
+        if (table.Find(name) != nullptr) {
+            std::cerr << "SymbolTable::AddSymbol: symbol " << identifiers.Name(name) << " already exists" << std::endl;
+            return nullptr;
         }
-        return table[name].val.func_val.func_type;
+        return &table.Insert(name);
     }
 
-    int GetFuncSymbolFParamNum(std::string name) {
-        if (table.find(name) == table.end()) {
-            std::cerr << "SymbolTable::GetFuncSymbolFParamNum: symbol " << name << " not found" << std::endl;
-            return 0;
-        }
-        if (table[name].type != Symbol::kFunc) {
-            std::cerr << "SymbolTable::GetFuncSymbolFParamNum: symbol " << name << " is not a func" << std::endl;
-            return 0;
+    const Symbol *Find(int name, const char *caller) const {
+        const Symbol *symbol = table.Find(name);
+        if (symbol == nullptr) {
+            std::cerr << "SymbolTable::" << caller << ": symbol " << identifiers.Name(name) << " not found" << std::endl;
         }
-        return table[name].val.func_val.fParamNum;
+        return symbol;
     }
 
-    bool *GetFuncSymbolFParamIsArray(std::string name) {
-        if (table.find(name) == table.end()) {
-            std::cerr << "SymbolTable::GetFuncSymbolFParamIsArray: symbol " << name << " not found" << std::endl;
-            return nullptr;
-        }
-        if (table[name].type != Symbol::kFunc) {
-            std::cerr << "SymbolTable::GetFuncSymbolFParamIsArray: symbol " << name << " is not a func" << std::endl;
+    const Symbol *FindFunc(int name, const char *caller) const {
+        const Symbol *symbol = Find(name, caller);
+        if (symbol != nullptr && symbol->type != Symbol::kFunc) {
+            std::cerr << "SymbolTable::" << caller << ": symbol " << identifiers.Name(name) << " is not a func" << std::endl;
             return nullptr;
         }
-        return table[name].val.func_val.fParamIsArray;
+        return symbol;
     }
-private:
-    std::map<std::string, Symbol> table;
 };
 
+// 嵌套作用域的符号表
+// 每个标识符对应一个定义的栈: top 记录标识符最内层的定义, 每个定义记录它遮蔽的外层定义
+// bindings 按定义的顺序存放所有可见的定义, 同时作为撤销日志: 退出作用域时按逆序恢复被遮蔽的定义
+// 查找只需一次哈希表查找, 退出作用域的代价与该作用域中定义的符号个数成正比
 class NestedSymbolTable {
 public:
     NestedSymbolTable() = default;
     ~NestedSymbolTable() = default;
 
     void AddTable() {
-        tables.emplace_back();
+        scopes.push_back(bindings.size());
     }
     void DropTable() {
-        if (tables.size() == 0) {
+        if (scopes.size() == 0) {
             std::cerr << "NestedSymbolTable::DropTable: no table to drop" << std::endl;
             return;
         }
-        tables.pop_back();
+        for (size_t i = bindings.size(); i > scopes.back(); i--) {
+            const Binding &binding = bindings[i - 1];
+            *top.Find(binding.name) = binding.shadowed;
+        }
+        bindings.resize(scopes.back());
+        scopes.pop_back();
     }
 
-    void AddConstSymbol(std::string name, int const_val) {
-        if (tables.size() == 0) {
-            std::cerr << "NestedSymbolTable::AddConstSymbol: no table to add" << std::endl;
-            return;
-        }
-        if (tables.back().HasSymbol(name)) { // 当前作用域不允许重复定义
-            std::cerr << "NestedSymbolTable::AddConstSymbol: symbol " << name << " already exists" << std::endl;
-            return;
-        }
-        tables.back().AddConstSymbol(name, const_val);
+    void AddConstSymbol(int name, int const_val) {
+        if (!CanAdd(name, "AddConstSymbol")) return;
+        SymbolTable::Symbol &symbol = Push(name);
+        symbol.type = SymbolTable::Symbol::kConst;
+        symbol.val.const_val = const_val;
     }
 
-    void AddVarSymbol(std::string name, int var_dim) {
-        if (tables.size() == 0) {
-            std::cerr << "NestedSymbolTable::AddVarSymbol: no table to add" << std::endl;
-            return;
-        }
-        if (tables.back().HasSymbol(name)) { // 当前作用域不允许重复定义
-            std::cerr << "NestedSymbolTable::AddVarSymbol: symbol " << name << " already exists" << std::endl;
-            return;
-        }
-        tables.back().AddVarSymbol(name, varSymbolCount[name] + 1, var_dim); // 从 1 开始，把 0（没有标号）留给全局变量
-        varSymbolCount[name]++;
+    void AddVarSymbol(int name, int var_dim) {
+        if (!CanAdd(name, "AddVarSymbol")) return;
+        SymbolTable::Symbol &symbol = Push(name);
+        symbol.type = SymbolTable::Symbol::kVar;
+        symbol.val.var_val.var_id = NextVarId(name); // 从 1 开始，把 0（没有标号）留给全局变量
+        symbol.val.var_val.var_dim = var_dim;
+    }
+
+    void AddConstArraySymbol(int name, const std::vector<int> &dims, std::shared_ptr<const std::vector<int> > vals) {
+        if (!CanAdd(name, "AddConstArraySymbol")) return;
+        SymbolTable::Symbol &symbol = Push(name);
+        symbol.type = SymbolTable::Symbol::kConstArray;
+        symbol.val.var_val.var_id = NextVarId(name); // 与变量共用编号
+        symbol.val.var_val.var_dim = dims.size();
+        symbol.const_array_dims = dims;
+        symbol.const_array_vals = vals;
     }
 
-    void AddFParamSymbol(std::string name, int func_val, int var_dim) {
+    void AddFParamSymbol(int name, int func_val, int var_dim) {
         if (fParamTable.HasSymbol(name)) { // 当前作用域不允许重复定义
-            std::cerr << "NestedSymbolTable::AddFParamSymbol: symbol " << name << " already exists" << std::endl;
+            std::cerr << "NestedSymbolTable::AddFParamSymbol: symbol " << identifiers.Name(name) << " already exists" << std::endl;
             return;
         }
         if (func_val != -1 && func_val != -2) {
@@ -215,1937 +345,932 @@ public:
         fParamTable.Clear();
     }
 
-    bool HasSymbol(std::string name) {
-        if (fParamTable.HasSymbol(name)) {
-            return true;
-        }
-        for (auto it = tables.rbegin(); it != tables.rend(); it++) {
-            if (it->HasSymbol(name)) {
-                return true;
-            }
-        }
-        return false;
+    // 查找符号: 先查找最内层的定义, 再查找函数形参 (函数体中的定义遮蔽同名的形参), 不存在时返回 nullptr
+    // 返回的指针在下一次插入符号之前有效
+    const SymbolTable::Symbol *Find(int name) const {
+        int index = Top(name);
+        return index != -1 ? &bindings[index].symbol : fParamTable.Find(name);
+    }
+
+    bool HasSymbol(int name) const {
+        return Find(name) != nullptr;
     }
 
-    SymbolTable::Symbol::Type GetSymbolType(std::string name) {
-        if (fParamTable.HasSymbol(name)) {
-            return fParamTable.GetSymbolType(name);
+    // 获取变量符号的编号，需要提前保证符号存在且类型为变量
+    int GetVarSymbolId(int name) const {
+        const SymbolTable::Symbol *symbol = Find(name);
+        if (symbol == nullptr) {
+            std::cerr << "NestedSymbolTable::GetVarSymbolId: symbol " << identifiers.Name(name) << " not found" << std::endl;
+            return 0;
         }
-        for (auto it = tables.rbegin(); it != tables.rend(); it++) {
-            if (it->HasSymbol(name)) {
-                return it->GetSymbolType(name);
-            }
+        if (symbol->type != SymbolTable::Symbol::kVar && symbol->type != SymbolTable::Symbol::kConstArray) {
+            std::cerr << "NestedSymbolTable::GetVarSymbolId: symbol " << identifiers.Name(name) << " is not a var" << std::endl;
+            return 0;
         }
-        std::cerr << "NestedSymbolTable::GetSymbolType: symbol " << name << " not found" << std::endl;
-        return SymbolTable::Symbol::kVar; // XXX 没有意义（因为此时说明不存在该 Symbol），只是为了不报错
+        return symbol->val.var_val.var_id;
     }
+private:
+    struct Binding {
+        int name;
+        int shadowed;               // 被遮蔽的外层定义在 bindings 中的下标, 没有时为 -1
+        SymbolTable::Symbol symbol;
+    };
 
-    // 获取常量符号的值，需要提前保证符号存在且类型为常量
-    int GetConstSymbolValue(std::string name) {
-        for (auto it = tables.rbegin(); it != tables.rend(); it++) {
-            if (it->HasSymbol(name)) {
-                return it->GetConstSymbolValue(name);
-            }
-        }
-        std::cerr << "NestedSymbolTable::GetConstSymbolValue: symbol " << name << " not found" << std::endl;
-        return 0;
+    std::vector<Binding> bindings;
+    std::vector<size_t> scopes;     // 每层作用域的第一个定义在 bindings 中的下标
+    IdMap<int> top;                 // 标识符 => 最内层的定义在 bindings 中的下标, 没有时为 -1
+    // 函数形参符号表，用于特殊处理函数形参
+    SymbolTable fParamTable;
+    // 变量符号的计数器，用于生成唯一的变量名
+    // 第一个变量名应该生成为 %ident_0，第二个应该为 %ident_1，以此类推
+    IdMap<int> varSymbolCount;
+
+    int Top(int name) const {
+        const int *index = top.Find(name);
+        return index == nullptr ? -1 : *index;
     }
 
-    // 获取变量符号的值，需要提前保证符号存在且类型为变量
-    int GetVarSymbolId(std::string name) {
-        if (fParamTable.HasSymbol(name)) {
-            return fParamTable.GetVarSymbolId(name);
+    // 当前作用域存在且没有同名符号时才能插入
+    bool CanAdd(int name, const char *caller) const {
+        if (scopes.size() == 0) {
+            std::cerr << "NestedSymbolTable::" << caller << ": no table to add" << std::endl;
+            return false;
         }
-        for (auto it = tables.rbegin(); it != tables.rend(); it++) {
-            if (it->HasSymbol(name)) {
-                return it->GetVarSymbolId(name);
-            }
+        if (Top(name) >= (int)scopes.back()) { // 当前作用域不允许重复定义
+            std::cerr << "NestedSymbolTable::" << caller << ": symbol " << identifiers.Name(name) << " already exists" << std::endl;
+            return false;
         }
-        std::cerr << "NestedSymbolTable::GetVarSymbolId: symbol " << name << " not found" << std::endl;
-        return 0;
+        return true;
     }
 
-    int GetVarSymbolDim(std::string name) {
-        if (fParamTable.HasSymbol(name)) {
-            return fParamTable.GetVarSymbolDim(name);
-        }
-        for (auto it = tables.rbegin(); it != tables.rend(); it++) {
-            if (it->HasSymbol(name)) {
-                return it->GetVarSymbolDim(name);
-            }
+    // 在当前作用域中加入一个定义, 遮蔽外层的同名定义
+    SymbolTable::Symbol &Push(int name) {
+        int *index = top.Find(name);
+        if (index == nullptr) {
+            index = &top.Insert(name);
+            *index = -1;
         }
-        std::cerr << "NestedSymbolTable::GetVarSymbolDim: symbol " << name << " not found" << std::endl;
-        return 0;
+        Binding binding{};
+        binding.name = name;
+        binding.shadowed = *index;
+        *index = bindings.size();
+        bindings.push_back(binding);
+        return bindings.back().symbol;
+    }
+
+    int NextVarId(int name) {
+        int *count = varSymbolCount.Find(name);
+        if (count == nullptr) count = &varSymbolCount.Insert(name);
+        return ++*count;
     }
-private:
-    std::vector<SymbolTable> tables;
-    // 函数形参符号表，用于特殊处理函数形参
-    SymbolTable fParamTable;
-    // 变量符号的计数器，用于生成唯一的变量名
-    // 第一个变量名应该生成为 %ident_0，第二个应该为 %ident_1，以此类推
-    std::map<std::string, int> varSymbolCount;
 };
 
 /**************** AST ****************/
 
+// 所有 AST 结点的类型, X(Name) 对应 NameAST
+#define AST_NODE_LIST(X) \
+    X(CompUnit) \
+    X(GlobalDef) \
+    X(FuncDef) \
+    X(FuncFParam) \
+    X(Block) \
+    X(BlockItem) \
+    X(Decl) \
+    X(ConstDecl) \
+    X(ConstInitVal) \
+    X(ConstDef) \
+    X(VarDecl) \
+    X(InitVal) \
+    X(VarDef) \
+    X(Stmt) \
+    X(MatchStmt) \
+    X(UnmatchStmt) \
+    X(OtherStmt) \
+    X(ConstExp) \
+    X(Exp)
+
+#define AST_FORWARD_DECL(Name) class Name##AST;
+AST_NODE_LIST(AST_FORWARD_DECL)
+#undef AST_FORWARD_DECL
+
+// 结点类型的标签, 遍历时按标签 switch 分派 (见 ast_visitor.hpp), 不需要每种遍历一个虚函数
+enum class ASTKind : uint8_t {
+#define AST_KIND_ENUM(Name) k##Name,
+    AST_NODE_LIST(AST_KIND_ENUM)
+#undef AST_KIND_ENUM
+};
+
 // 所有 AST 的基类
+// 语句, 声明与定义的 IR 由 IRLowering (见 ir_lowering.hpp) 生成, 表达式的 IR 由 BaseExpAST 的成员函数生成
 class BaseAST {
 public:
-    virtual ~BaseAST() = default;
-    virtual std::string PrintAST(std::string tab) const = 0;
-    // 输出到buffer中, 返回值为需要的信息
-    virtual std::string PrintIR(std::string tab, std::string &buffer) const = 0;
-
-    std::string NewTempSymbol() const{
-        static int count_var = 0;
-        std::string ret = "%" + std::to_string(count_var);
-        count_var++;
-        return ret;
-    }
-};
+    const ASTKind astKind;
 
-class BaseExpAST : public BaseAST {
-public:
-    virtual int CalcConstExp() const = 0;
-};
+    explicit BaseAST(ASTKind astKind) : astKind(astKind) {}
+    virtual ~BaseAST() = default;
 
-// CompUnit: 起始字符, 表示整个文件
-// CompUnit ::= GlobalDefs
-class CompUnitAST : public BaseAST {
-public:
-    // 用智能指针管理对象
-    std::unique_ptr<std::vector<std::unique_ptr<BaseAST> > > globalDefs;
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += tab + "CompUnitAST {\n";
-        for (auto &globalDef : *globalDefs) {
-            ans += tab + "\t" + globalDef->PrintAST(tab + "\t");
-        }
-        ans += tab + "}\n";
-        return ans;
+    // 生成 IR 时的编号, 属于一次编译, 由 ResetIRState 清零
+    struct IRState {
+        int tempCount = 0;
+        int labelCount = 0;
+    };
+    static IRState &State() {
+        static IRState state;
+        return state;
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        for (auto &globalDef : *globalDefs) {
-            globalDef->PrintIR(tab, buffer);
-        }
-        return "";
+    // 开始一次新的编译: 清空编号与函数之外的定义
+    static void ResetIRState() {
+        State() = IRState();
+        TopLevelDefs().clear();
+        ConstArrayDefs().clear();
+        ReadOnlyGlobals().clear();
     }
-};
-
-class GlobalDefAST : public BaseAST {
-public:
-    enum Kind {
-        kFuncDef,
-        kDecl
-    };
-    
-    Kind kind;
 
-    std::unique_ptr<BaseAST> funcDef;
-    std::unique_ptr<BaseAST> decl;
+    static Value NewTempSymbol() {
+        return Value::Temp(State().tempCount++);
+    }
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += tab + "GlobalDefAST {\n";
-        if (kind == kFuncDef) {
-            ans += tab + "\tfuncDef: " + funcDef->PrintAST(tab + "\t");
-        } else
-        if (kind == kDecl) {
-            ans += tab + "\tdecl: " + decl->PrintAST(tab + "\t");
-        } else {
-            std::cerr << "GlobalDefAST::PrintAST: unknown kind" << std::endl;
-        }
-        ans += tab + "}\n";
-        return ans;
+    // 保存元素地址的临时变量
+    static Value NewPtrSymbol() {
+        return Value::Ptr(State().tempCount++);
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        if (kind == kFuncDef) {
-            funcDef->PrintIR(tab, buffer);
-        } else
-        if (kind == kDecl) {
-            decl->PrintIR(tab, buffer);
-        } else {
-            std::cerr << "GlobalDefAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
+    // 短路求值等需要的基本块标号, 整个程序中唯一, name 需要是字符串常量
+    static Value NewLabelSymbol(const char *name) {
+        return Value::Label(name, State().labelCount++);
     }
-};
 
-// FuncDef: 函数定义
-// FuncDef ::= FuncType IDENT '(' [FuncFParams] ')' Block;
-/**
-*   翻译为:
-*   fun @IDENT (): [FuncType]{
-*       [Block]
-*   }
-*/
-class FuncDefAST : public BaseAST {
-public:
-    int funcType; // 0 表示 void, 1 表示 int
-    std::string ident;
-    // 函数参数列表
-    // XXX 没有在符号表中存参数列表，语义分析没有检查函数调用时参数是否匹配
-    std::unique_ptr<std::vector<std::unique_ptr<BaseAST> > > funcFParams;
-    std::unique_ptr<BaseAST> block;
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "FuncDefAST {\n";
-        ans += tab + "\tfuncType: " + std::to_string(funcType) + "\n";
-        ans += tab + "\tident: " + ident + "\n";
-        ans += tab + "\tfuncFParams: {";
-        if (funcFParams == nullptr) {
-            ans += "null";
-        } else {
-            for (auto &funcFParam : *funcFParams) {
-                ans += tab + "\t\t" + funcFParam->PrintAST(tab + "\t\t");
-            }
-        }
-        ans += tab + "\t}\n";
-        ans += tab + "\tblock: " + block->PrintAST(tab + "\t");
-        ans += tab + "}\n";
-        return ans;
-    }
-
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        std::string funcEntryLabel = "\%entry_" + ident;
-        std::vector<std::string> funcFParamIdents; // 存储 funcFParam 的 ident
-        std::vector<std::string> funcFParamTypes; // 存储 funcFParam 的 type
-        
-        // 函数的头部（函数名）
-        buffer += tab + "fun @" + ident + "(";
-
-        // 函数的参数
-        if (funcFParams == nullptr) {
-            buffer += "";
-        } else {
-            for (auto &funcFParam : *funcFParams) {
-                std::string tmp = funcFParam->PrintIR(tab, buffer);
-                auto splitPos = tmp.find("|");
-                funcFParamIdents.push_back(tmp.substr(0, splitPos));
-                funcFParamTypes.push_back(tmp.substr(splitPos+1, tmp.size() - (splitPos+1)));
-                if (funcFParam != funcFParams->back()) {
-                    buffer += ", ";
-                }
-            }
-        }
-        
-        // 函数的类型
-        buffer += ")";
-        if (funcType == 0) {
-            buffer += "";
-        } else
-        if (funcType == 1) {
-            buffer += ": i32";
-        } else {
-            std::cerr << "FuncDefAST::PrintIR: unknown funcType" << std::endl;
-        }
-        buffer += " {\n";
+    // if/while 语句的基本块标号, index 为 0 时没有后缀
+    static Value StmtLabel(const char *name, int index) {
+        return Value::Label(name, index == 0 ? -1 : index);
+    }
 
-        // 函数的入口
-        buffer += funcEntryLabel + ":\n";
+    // 需要放在函数之外的定义 (运行时库函数的声明, 数组初始化的模板, 常量数组), 由 front_main 输出在 IR 的开头
+    static std::string &TopLevelDefs() {
+        static std::string defs;
+        return defs;
+    }
 
-        // 特殊处理形参
-        // if (funcType == 1) {
-            for (int i = 0; i < funcFParamIdents.size(); i++) {
-                buffer += tab + "\t\%" + funcFParamIdents[i] + "fParam = alloc " + funcFParamTypes[i] + "\n";
-                buffer += tab + "\tstore @" + funcFParamIdents[i] + ", \%" + funcFParamIdents[i] + "fParam\n";
-            }
-        // }
-
-        // 函数的代码块
-        std::string blockRet = block->PrintIR(tab + '\t', buffer);
-        // void 函数没有 return 语句，需要手动加上 ret
-        // int 函数如果没有 return 语句，不会自动加 ret 0
-        if (funcType == 0 && blockRet != "return") {
-            buffer += tab + "\tret\n";
-        }
+    // 加入一条函数之外的定义, 每条定义只输出一次
+    static void AddTopLevelDef(const std::string &def) {
+        if (TopLevelDefs().find(def) == std::string::npos) TopLevelDefs() += def;
+    }
 
-        // 函数结尾
-        buffer += tab + "}\n";
-        return "";
+    // 前端生成的只读全局变量 (常量数组, 数组初始化的模板), 后端把它们放入 .rodata
+    // 用户的全局变量可能与它们的前缀 __const_ 相同, 因此不能按名字判断
+    static std::set<std::string> &ReadOnlyGlobals() {
+        static std::set<std::string> names;
+        return names;
     }
-};
 
-// FuncFParam: 函数参数
-// FuncFParam ::= Btype IDENT
-class FuncFParamAST : public BaseAST {
-public:
-    enum Kind {
-        kInt,
-        kIntArray
-    };
+    // 常量数组在 .rodata 中的定义, 只有存在不能在编译时求值的访问时才输出
+    static std::map<std::string, std::string> &ConstArrayDefs() {
+        static std::map<std::string, std::string> defs;
+        return defs;
+    }
 
-    Kind kind;
-    
-    int bType; // XXX bType 用数字实现，不太好，应该改成枚举
-    std::string ident;
-    std::unique_ptr<std::vector<std::unique_ptr<BaseExpAST> > > constArrayDims;
-
-    std::string PrintAST(std::string tab) const override {
-        // TODO
-        std::string ans = "";
-        ans += "FuncFParamAST {\n";
-        ans += tab + "\tbType: " + std::to_string(bType) + "\n";
-        ans += tab + "\tident: " + ident + "\n";
-        ans += tab + "}\n";
-        return ans;
-    }
-
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        std::string type;
-        if (kind == kInt) {
-            type = "i32";
-            buffer += "@" + ident + ": " + type; // XXX bType 目前只有 int
-            return ident + "|" + type;
-        } else
-        if (kind == kIntArray) {
-            type = "*";
-            if (constArrayDims == nullptr) {
-                type += "i32";
-            } else {
-                type.append(constArrayDims->size(), '[');
-                type += "i32";
-                for (auto it = constArrayDims->rbegin(); it != constArrayDims->rend(); it++) {
-                    type += ", " + (*it)->PrintIR(tab, buffer) + "]";
-                }
-            }
-            buffer += "@" + ident + ": " + type;
-            return ident + "|" + type;
-        } else {
-            std::cerr << "FuncFParamAST::PrintIR: unknown kind" << std::endl;
+    // 数组的类型, 如 dims = {2, 3} 时为 [[i32, 3], 2]
+    static std::string ArrayType(const std::vector<int> &dims) {
+        std::string type = "i32";
+        for (auto it = dims.rbegin(); it != dims.rend(); it++) {
+            type = "[" + type + ", " + std::to_string(*it) + "]";
         }
-        return "";
+        return type;
     }
-};
 
-// Block: 函数的结构体
-// Block :== '{' {BlockItem} '}'
-class BlockAST : public BaseAST {
-public:
-    std::unique_ptr<std::vector<std::unique_ptr<BaseAST> > > blockItems;
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "BlockAST {\n";
-        ans += tab + "\tblockItems: [\n";
-        if (blockItems == nullptr) {
-            ans += tab + "\t\tNULL\n";
-        } else {
-            for (auto &blockItem : *blockItems) {
-                ans += tab + "\t\t" + blockItem->PrintAST(tab + "\t\t");
-            }
+    // 常量初始化列表 {...}, 展开后的元素 values[begin, ...) 对应第 level 维及之后
+    static std::string Aggregate(const std::vector<int> &dims, size_t level, size_t begin, const std::vector<int> &values) {
+        if (level == dims.size()) return std::to_string(values[begin]);
+        size_t stride = 1;
+        for (size_t i = level + 1; i < dims.size(); i++) stride *= dims[i];
+        std::string ans = "{";
+        for (int i = 0; i < dims[level]; i++) {
+            if (i != 0) ans += ", ";
+            ans += Aggregate(dims, level + 1, begin + i * stride, values);
         }
-        ans += tab + "\t]\n";
-        ans += tab + "}\n";
-        return ans;
+        return ans + "}";
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        if (blockItems == nullptr) {
-            return "";
-        }
-        std::string ret;
-        for (auto &blockItem : *blockItems) {
-            ret = blockItem->PrintIR(tab, buffer);
-            // 如果是 return、break、continue 语句，提前返回
-            if (ret == "return" || ret == "break" || ret == "continue") {
-                break;
-            }
+    // 全局数组的初始值, 全为 0 时使用 zeroinit
+    static std::string ArrayInit(const std::vector<int> &dims, const std::vector<int> &values) {
+        for (int value : values) {
+            if (value != 0) return Aggregate(dims, 0, 0, values);
         }
-        return ret; // 返回最后一个语句的返回值，可能是 return、break、continue
+        return "zeroinit";
     }
 };
 
-class BlockItemAST : public BaseAST {
+class BaseExpAST : public BaseAST {
 public:
-    enum Kind {
-        kDecl,
-        kStmt
-    };
+    using BaseAST::BaseAST;
 
-    Kind kind;
+    virtual int CalcConstExp() const = 0;
+    // 是否可以在编译时求值 (只由常量和字面量组成)
+    virtual bool IsConstExp() const = 0;
 
-    std::unique_ptr<BaseAST> decl;
-    std::unique_ptr<BaseAST> stmt;
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "BlockItemAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kDecl:
-            ans += tab + "\tdecl: " + decl->PrintAST(tab + "\t");
-            break;
-        case kStmt:
-            ans += tab + "\tstmt: " + stmt->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "BlockItemAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
+    // 输出计算表达式的 IR, 返回表达式的值 (LVal 返回变量的地址)
+    virtual Value PrintValueIR(IRWriter &out) const = 0;
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        if (kind == kDecl) {
-            return decl->PrintIR(tab, buffer);
-        } else
-        if (kind == kStmt) {
-            return stmt->PrintIR(tab, buffer); // 可能会返回 "return"
-        } else {
-            std::cerr << "BlockItemAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
+    // 作为 if/while 的条件: 表达式非 0 时跳转到 trueLabel, 否则跳转到 falseLabel
+    // 默认先算出表达式的值再跳转, 逻辑运算重载该函数, 实现短路求值
+    virtual void PrintCondIR(IRWriter &out, const Value &trueLabel, const Value &falseLabel) const {
+        Value var = PrintValueIR(out);
+        out.Line() << "br " << var << ", " << trueLabel << ", " << falseLabel << "\n";
     }
 };
 
-class DeclAST : public BaseAST {
-public:
-    enum Kind {
-        kConstDecl,
-        kVarDecl
-    };
-    
-    Kind kind;
-    
-    std::unique_ptr<BaseAST> constDecl;
-    std::unique_ptr<BaseAST> varDecl;
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "DeclAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kConstDecl:
-            ans += tab + "\tconstDecl: " + constDecl->PrintAST(tab + "\t");
-            break;
-        case kVarDecl:
-            ans += tab + "\tvarDecl: " + varDecl->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "DeclAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
+// 子结点列表, 列表本身与其中的结点都分配在 astArena 中
+using ASTList = ArenaVector<BaseAST *>;
+using ExpASTList = ArenaVector<BaseExpAST *>;
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        if (kind == kConstDecl) {
-            // 常量的定义，不需要产生IR
-        } else
-        if (kind == kVarDecl) {
-            varDecl->PrintIR(tab, buffer);
-        } else {
-            std::cerr << "DeclAST::PrintIR: unknown kind" << std::endl;
-        }
-        
-        return "";
-    }
-};
+/**************** 表达式 ****************/
 
-class ConstDeclAST : public BaseAST {
+// Exp: 一个 SysY 表达式
+// Exp ::= LOrExp;
+// 表达式的结点存放在 expPool 中 (见 exp_pool.hpp), AST 中只保存根结点的下标
+// 优先级的每一层 (LOrExp -> ... -> PrimaryExp) 不再产生结点, 括号也不产生结点
+class ExpAST : public BaseExpAST {
 public:
-    /* enum BType {
-        kInt,
-    }; */
+    ExpId root;
 
-    int bType;
-    std::unique_ptr<std::vector<std::unique_ptr<BaseAST> > > constDefs; // XXX 也许不需要存储指针
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "ConstDeclAST {\n";
-        switch (bType) { // XXX 把switch改成if else，switch中不能定义变量
-        case 0:
-            ans += tab + "\tbType: int\n";
-            break;
-        default:
-            std::cerr << "ConstDeclAST::PrintAST: unknown bType" << std::endl;
-            break;
-        }
-        ans += tab + "\tconstDefs: [\n";
-        for (auto &constDef : *constDefs) {
-            ans += tab + "\t\t" + constDef->PrintAST(tab + "\t\t");
+    int CalcConstExp() const override {
+        const ExpNode &node = expPool[root];
+        if (!node.isConst) {
+            std::cerr << "ExpAST::CalcConstExp: exp is not a const" << std::endl;
         }
-        ans += tab + "\t]\n";
-        ans += tab + "}\n";
-        return ans;
-    }
-
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        // 常量的定义，不需要产生IR
-        return "";
+        return node.value;
     }
-};
-
-class ConstDefAST : public BaseAST {
-public:
-    std::string ident;
-    std::unique_ptr<BaseExpAST> constInitVal;
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "ConstDefAST {\n";
-        ans += tab + "\tident: " + ident + "\n";
-        ans += tab + "\tconstInitVal: " + constInitVal->PrintAST(tab + "\t");
-        ans += tab + "}\n";
-        return ans;
+    bool IsConstExp() const override {
+        return expPool[root].isConst;
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        // 常量的定义，不需要产生IR
-        return "";
-    }
-};
+    static const ASTKind KIND = ASTKind::kExp;
 
-class ConstInitValAST : public BaseExpAST {
-public:
-    std::unique_ptr<BaseExpAST> constExp;
+    ExpAST() : BaseExpAST(KIND) {}
 
-    int CalcConstExp() const override {
-        return constExp->CalcConstExp();
+    Value PrintValueIR(IRWriter &out) const override {
+        return PrintNodeIR(root, out);
     }
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "ConstInitValAST {\n";
-        ans += tab + "\tconstExp: " + constExp->PrintAST(tab + "\t");
-        ans += tab + "}\n";
-        return ans;
+    void PrintCondIR(IRWriter &out, const Value &trueLabel, const Value &falseLabel) const override {
+        PrintNodeCondIR(root, out, trueLabel, falseLabel);
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        std::string var = constExp->PrintIR(tab, buffer);
-        return var;
+    // 赋值的目标 (root 为 Ref 结点), 返回变量的地址
+    Value PrintAddrIR(IRWriter &out) const {
+        return PrintRefIR(root, out);
     }
-};
 
-class VarDeclAST : public BaseAST {
-public:
-    int bType;
-    std::unique_ptr<std::vector<std::unique_ptr<BaseAST> > > varDefs;
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "VarDeclAST {\n";
-        switch (bType) { // XXX 把switch改成if else，switch中不能定义变量
-        case 0:
-            ans += tab + "\tbType: int\n";
-            break;
-        default:
-            std::cerr << "VarDeclAST::PrintAST: unknown bType" << std::endl;
-            break;
-        }
-        ans += tab + "\tvarDefs: [\n";
-        for (auto &varDef : *varDefs) {
-            ans += tab + "\t\t" + varDef->PrintAST(tab + "\t\t");
+    // 输出计算结点 id 的 IR, 返回表达式的值
+    /**
+    *   翻译为:
+    *   1. Literal: 不产生 IR
+    *   2. Ref: var = load [Ref], 常量与数组指针不需要 load
+    *   3. Unary: +x 不产生 IR, now = sub 0, x, now = eq 0, x
+    *   4. Binary: now = op lhs, rhs, 逻辑运算见 PrintLogicIR
+    *   5. Call: [实参], now = call @f(...), void 函数没有返回值
+    */
+    static Value PrintNodeIR(ExpId id, IRWriter &out) {
+        static const char *ops[] = {
+            "", "", "sub", "eq",
+            "mul", "div", "mod", "add", "sub",
+            "lt", "gt", "le", "ge", "eq", "ne",
+        };
+        const ExpNode &node = expPool[id];
+        switch (node.kind) {
+        case ExpNode::kLiteral:
+            return Value::Const(node.value);
+        case ExpNode::kRef: {
+            Value lVarName = PrintRefIR(id, out);
+            if (!lVarName.IsAddr()) { // 不是需要 load 的变量 (常量, 数组指针)
+                return lVarName;
+            }
+            Value now = NewTempSymbol();
+            out.Line() << now << " = load " << lVarName << "\n";
+            return now;
         }
-        ans += tab + "\t]\n";
-        ans += tab + "}\n";
-        return ans;
-    }
-
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        for (auto &varDef : *varDefs) {
-            varDef->PrintIR(tab, buffer);
+        case ExpNode::kUnary: {
+            Value var = PrintNodeIR(node.lhs, out);
+            if (node.op == ExpNode::kPos) return var;
+            Value now = NewTempSymbol();
+            out.Line() << now << " = " << ops[node.op] << " 0, " << var << "\n";
+            return now;
         }
-        return "";
-    }
-};
-
-class VarDefAST : public BaseAST {
-public:
-    enum Kind {
-        kUnInit,
-        kArray, // 只实现了没有手动初始化的数组
-        kInit
-    };
-
-    Kind kind;
-
-    bool isGlobal;
-    std::string ident;
-    std::unique_ptr<BaseExpAST> initVal;
-    std::unique_ptr<std::vector<std::unique_ptr<BaseExpAST> > > constArrayDims; 
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "VarDefAST {\n";
-        ans += tab + "\tident: " + ident + "\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kUnInit:
-            ans += tab + "\tkind: unInit\n";
-            break;
-        case kArray:
-            ans += tab + "\tkind: array\n";
-            ans += tab + "\tconstArrayDims: [\n";
-            for (auto &constArrayDim : *constArrayDims) {
-                ans += tab + "\t\t" + constArrayDim->PrintAST(tab + "\t\t");
+        case ExpNode::kBinary: {
+            if (node.op == ExpNode::kAnd || node.op == ExpNode::kOr) {
+                return PrintLogicIR(id, out);
             }
-            ans += tab + "\t]\n";
-            break;
-        case kInit:
-            ans += tab + "\tkind: init\n";
-            ans += tab + "\tinitVal: " + initVal->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "VarDefAST::PrintAST: unknown kind" << std::endl;
-            break;
+            Value var1 = PrintNodeIR(node.lhs, out);
+            Value var2 = PrintNodeIR(node.rhs, out);
+            Value now = NewTempSymbol();
+            out.Line() << now << " = " << ops[node.op] << " " << var1 << ", " << var2 << "\n";
+            return now;
         }
-        ans += tab + "}\n";
-        return ans;
+        case ExpNode::kCall:
+            return PrintCallIR(expPool.calls[node.lhs], out);
+        }
+        std::cerr << "ExpAST::PrintNodeIR: unknown kind" << std::endl;
+        return Value();
+    }
+
+    // 结点 id 作为 if/while 的条件: 非 0 时跳转到 trueLabel, 否则跳转到 falseLabel
+    // 短路求值:
+    //     a && b: a 为真时跳转到 %land_rhs_N, 继续判断 b; 否则直接跳转到 falseLabel
+    //     a || b: a 为真时直接跳转到 trueLabel; 否则跳转到 %lor_rhs_N, 继续判断 b
+    //     !a: 交换两个跳转目标
+    // 其余结点先算出值再跳转
+    static void PrintNodeCondIR(ExpId id, IRWriter &out, const Value &trueLabel, const Value &falseLabel) {
+        const ExpNode &node = expPool[id];
+        if (node.kind == ExpNode::kBinary && node.op == ExpNode::kAnd) {
+            Value rhsLabel = NewLabelSymbol("land_rhs");
+            PrintNodeCondIR(node.lhs, out, rhsLabel, falseLabel);
+            out << rhsLabel << ":\n";
+            PrintNodeCondIR(node.rhs, out, trueLabel, falseLabel);
+        } else
+        if (node.kind == ExpNode::kBinary && node.op == ExpNode::kOr) {
+            Value rhsLabel = NewLabelSymbol("lor_rhs");
+            PrintNodeCondIR(node.lhs, out, trueLabel, rhsLabel);
+            out << rhsLabel << ":\n";
+            PrintNodeCondIR(node.rhs, out, trueLabel, falseLabel);
+        } else
+        if (node.kind == ExpNode::kUnary && node.op == ExpNode::kPos) {
+            PrintNodeCondIR(node.lhs, out, trueLabel, falseLabel);
+        } else
+        if (node.kind == ExpNode::kUnary && node.op == ExpNode::kNot) {
+            PrintNodeCondIR(node.lhs, out, falseLabel, trueLabel);
+        } else {
+            Value var = PrintNodeIR(id, out);
+            out.Line() << "br " << var << ", " << trueLabel << ", " << falseLabel << "\n";
+        }
+    }
+
+    // 逻辑运算作为值使用时 (例如 a = b && c), 通过短路跳转把 0/1 存入临时变量
+    /**
+    *   翻译为:
+    *   now = alloc i32
+    *   PrintNodeCondIR(%logic_true_N, %logic_false_N)
+    *   %logic_true_N:  store 1, now; jump %logic_end_N
+    *   %logic_false_N: store 0, now; jump %logic_end_N
+    *   %logic_end_N:   ret = load now
+    */
+    static Value PrintLogicIR(ExpId id, IRWriter &out) {
+        Value now = NewPtrSymbol();
+        Value trueLabel = NewLabelSymbol("logic_true");
+        Value falseLabel = NewLabelSymbol("logic_false");
+        Value endLabel = NewLabelSymbol("logic_end");
+        out.Line() << now << " = alloc i32\n";
+        PrintNodeCondIR(id, out, trueLabel, falseLabel);
+        out << trueLabel << ":\n";
+        out.Line() << "store 1, " << now << "\n";
+        out.Line() << "jump " << endLabel << "\n";
+        out << falseLabel << ":\n";
+        out.Line() << "store 0, " << now << "\n";
+        out.Line() << "jump " << endLabel << "\n";
+        out << endLabel << ":\n";
+        Value ret = NewTempSymbol();
+        out.Line() << ret << " = load " << now << "\n";
+        return ret;
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        if (kind == kUnInit) {
-            if (isGlobal) {
-                buffer += tab + "global @" + ident + " = alloc i32, zeroinit\n";
+    // Ref 结点: 返回变量的地址 (需要 load 或作为赋值的目标), 或者不需要 load 的值 (常量, 数组指针)
+    static Value PrintRefIR(ExpId id, IRWriter &out) {
+        const ExpNode &node = expPool[id];
+        if (node.isConst) {
+            // 常量 (包括下标都是常量的常量数组元素) 不需要 load
+            return Value::Const(node.value);
+        }
+        const ExpRef &ref = expPool.refs[node.lhs];
+        if (ref.isConstArray) {
+            // 需要在运行时访问的常量数组, 放入 .rodata
+            AddTopLevelDef(ConstArrayDefs()[ref.ident + (ref.identVal == 0 ? "" : "_" + std::to_string(ref.identVal))]);
+        }
+        if (ref.kind == ExpRef::kVar) {
+            if (ref.identVal == -1) {
+                return Value::FParam(ref.ident);
+            } else
+            if (ref.identVal == -2) { // 是数组指针类型的函数形参
+                Value now = NewTempSymbol();
+                out.Line() << now << " = load " << Value::FParam(ref.ident) << "\n";
+                Value now2 = NewTempSymbol();
+                out.Line() << now2 << " = getptr " << now << ", 0\n";
+                return now2;
             } else {
-                buffer += tab + "@" + ident + " = alloc i32\n";
+                Value var = Value::Var(ref.ident, ref.identVal);
+                // 数组指针不需要 load
+                if (ref.isArrayPtr) {
+                    Value now = NewTempSymbol();
+                    out.Line() << now << " = getelemptr " << var << ", 0\n";
+                    return now;
+                } else {
+                    return var;
+                }
             }
         } else
-        if (kind == kArray) {
-            if (isGlobal) {
-                buffer += tab + "global @" + ident + " = alloc ";
-                // buffer 加上 constArrayDims 个数个 '['
-                buffer.append(constArrayDims->size(), '[');
-                buffer += "i32";
-                for (auto it = constArrayDims->rbegin(); it != constArrayDims->rend(); it++) {
-                    buffer += ", " + (*it)->PrintIR(tab, buffer) + "]";
-                }
-                buffer += ", zeroinit\n";
+        if (ref.kind == ExpRef::kArray) {
+            Value pre;
+            if (ref.identVal == -2) {
+                pre = NewTempSymbol();
+                out.Line() << pre << " = load " << Value::FParam(ref.ident) << "\n";
             } else {
-                buffer += tab + "@" + ident + " = alloc ";
-                // buffer 加上 constArrayDims 个数个 '['
-                buffer.append(constArrayDims->size(), '[');
-                buffer += "i32";
-                for (auto it = constArrayDims->rbegin(); it != constArrayDims->rend(); it++) {
-                    buffer += ", " + (*it)->PrintIR(tab, buffer) + "]";
+                pre = Value::Var(ref.ident, ref.identVal);
+            }
+
+            for (uint32_t i = 0; i < ref.dimCount; i++) {
+                Value var = PrintNodeIR(expPool.Dim(ref, i), out); // 数组下标
+                Value now = NewPtrSymbol();
+                // 变量是数组类型的函数形参，且是第一个下标
+                if (ref.identVal == -2 && i == 0) {
+                    out.Line() << now << " = getptr " << pre << ", " << var << "\n";
+                } else {
+                    out.Line() << now << " = getelemptr " << pre << ", " << var << "\n";
                 }
-                buffer += "\n"; // 局部变量不初始化
+                pre = now;
             }
-        } else
-        if (kind == kInit) {
-            if (isGlobal) {
-                // XXX 没有检查initVal是否是常量
-                std::string var = initVal->PrintIR(tab, buffer);
-                buffer += tab + "global @" + ident + " = alloc i32, " + var + "\n";
+
+            if (ref.isArrayPtr) { // 数组指针，需要作为函数参数传递
+                Value now = NewTempSymbol();
+                out.Line() << now << " = getelemptr " << pre << ", 0\n";
+                return now;
             } else {
-                buffer += tab + "@" + ident + " = alloc i32\n";
-                std::string var = initVal->PrintIR(tab, buffer);
-                buffer += tab + "store " + var + ", @" + ident + "\n";
+                return pre;
             }
         } else {
-            std::cerr << "VarDefAST::PrintIR: unknown kind" << std::endl;
+            std::cerr << "ExpAST::PrintRefIR: unknown kind" << std::endl;
+        }
+        return Value();
+    }
+
+    // 函数调用: 先算出实参列表, 再输出 call
+    static Value PrintCallIR(const ExpCall &call, IRWriter &out) {
+        std::vector<Value> params;
+        params.reserve(call.argCount);
+        for (uint32_t i = 0; i < call.argCount; i++) {
+            params.push_back(PrintNodeIR(expPool.Arg(call, i), out));
+        }
+        Value now;
+        if (call.funcType == 0) { // void
+            out.Line() << "call @" << call.ident << "(";
+        } else
+        if (call.funcType == 1) { // int
+            now = NewTempSymbol();
+            out.Line() << now << " = call @" << call.ident << "(";
+        } else {
+            std::cerr << "ExpAST::PrintCallIR: unknown funcType" << std::endl;
+            return Value();
         }
-        return "";
+        for (size_t i = 0; i < params.size(); i++) {
+            if (i != 0) out << ", ";
+            out << params[i];
+        }
+        out << ")\n";
+        return now;
     }
 };
 
-class InitValAST : public BaseExpAST {
+// ConstExp: 常量表达式, 值在语法分析时已经算出
+// ConstExp ::= Exp;
+class ConstExpAST : public BaseExpAST {
 public:
-    std::unique_ptr<BaseExpAST> exp;
+    ExpId exp;
+    int value;
 
     int CalcConstExp() const override {
-        return exp->CalcConstExp();
+        return value;
     }
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "InitValAST {\n";
-        ans += tab + "\texp: " + exp->PrintAST(tab + "\t");
-        ans += tab + "}\n";
-        return ans;
+    bool IsConstExp() const override {
+        return true;
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        std::string var = exp->PrintIR(tab, buffer); // XXX 目前没有检测是否是常量表达式（可以优化）
-        return var;
+    static const ASTKind KIND = ASTKind::kConstExp;
+
+    ConstExpAST() : BaseExpAST(KIND) {}
+
+    Value PrintValueIR(IRWriter &out) const override{
+        // PrintIR 前已经计算了常量表达式的值（在语法分析的时候）
+        return Value::Const(value);
     }
 };
 
-class StmtAST : public BaseAST {
+// CompUnit: 起始字符, 表示整个文件
+// CompUnit ::= GlobalDefs
+class CompUnitAST : public BaseAST {
+public:
+    // 所有结点都由 astArena 管理
+    ASTList *globalDefs = nullptr;
+
+    static const ASTKind KIND = ASTKind::kCompUnit;
+
+    CompUnitAST() : BaseAST(KIND) {}
+};
+
+class GlobalDefAST : public BaseAST {
 public:
     enum Kind {
-        kMatch,
-        kUnmatch,
+        kFuncDef,
+        kDecl
     };
-
+    
     Kind kind;
 
-    std::unique_ptr<BaseAST> matchStmt;
-    std::unique_ptr<BaseAST> unmatchStmt;
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "StmtAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kMatch:
-            ans += tab + "\tkind: match\n";
-            ans += tab + "\tmatchStmt: " + matchStmt->PrintAST(tab + "\t");
-            break;
-        case kUnmatch:
-            ans += tab + "\tkind: unmatch\n";
-            ans += tab + "\tunmatchStmt: " + unmatchStmt->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "StmtAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
+    BaseAST *funcDef = nullptr;
+    BaseAST *decl = nullptr;
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        if (kind == kMatch) {
-            return matchStmt->PrintIR(tab, buffer);
-        } else
-        if (kind == kUnmatch) {
-            return unmatchStmt->PrintIR(tab, buffer);
-        } else {
-            std::cerr << "StmtAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    static const ASTKind KIND = ASTKind::kGlobalDef;
+
+    GlobalDefAST() : BaseAST(KIND) {}
 };
 
-class MatchStmtAST : public BaseAST {
+// FuncDef: 函数定义
+// FuncDef ::= FuncType IDENT '(' [FuncFParams] ')' Block;
+class FuncDefAST : public BaseAST {
 public:
-    enum Kind {
-        kIf,
-        kOther
-    };
+    int funcType; // 0 表示 void, 1 表示 int
+    std::string ident;
+    // 函数参数列表
+    // XXX 没有在符号表中存参数列表，语义分析没有检查函数调用时参数是否匹配
+    ASTList *funcFParams = nullptr;
+    BaseAST *block = nullptr;
 
-    Kind kind;
-    
-    std::unique_ptr<BaseExpAST> exp;
-    std::unique_ptr<BaseAST> matchStmt1, matchStmt2;
-    std::unique_ptr<BaseAST> otherStmt;
-    int ifLabelIndex;
+    static const ASTKind KIND = ASTKind::kFuncDef;
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "MatchStmtAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kIf:
-            ans += tab + "\tkind: if\n";
-            ans += tab + "\texp: " + exp->PrintAST(tab + "\t");
-            ans += tab + "\tmatchStmt1: " + matchStmt1->PrintAST(tab + "\t");
-            ans += tab + "\tmatchStmt2: " + matchStmt2->PrintAST(tab + "\t");
-            break;
-        case kOther:
-            ans += tab + "\tkind: other\n";
-            ans += tab + "\totherStmt: " + otherStmt->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "MatchStmtAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
-
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        if (kind == kIf) {
-            std::string thenLabel = "\%then" + (ifLabelIndex == 0 ? "" : "_" + std::to_string(ifLabelIndex));
-            std::string elseLabel = "\%else" + (ifLabelIndex == 0 ? "" : "_" + std::to_string(ifLabelIndex));
-            std::string ifEndLabel = "\%if_end" + (ifLabelIndex == 0 ? "" : "_" + std::to_string(ifLabelIndex));
-            std::string stmtRet;
-
-            // if 的条件判断部分
-            std::string var = exp->PrintIR(tab, buffer);
-            buffer += tab + "br " + var + ", " + thenLabel + ", " + elseLabel + "\n";
-            // if 语句的 if 分支
-            buffer += thenLabel + ":\n";
-            stmtRet = matchStmt1->PrintIR(tab, buffer);
-            if (stmtRet != "return" && stmtRet != "break" && stmtRet != "continue") {
-                buffer += tab + "jump " + ifEndLabel + "\n";
-            }
-            // if 语句的 else 分支
-            buffer += elseLabel + ":\n";
-            stmtRet = matchStmt2->PrintIR(tab, buffer);
-            if (stmtRet != "return" && stmtRet != "break" && stmtRet != "continue") {
-                buffer += tab + "jump " + ifEndLabel + "\n";
-            }
-            // if 语句之后的内容（的标号）
-            buffer += ifEndLabel + ":\n";
-        } else
-        if (kind == kOther) {
-            return otherStmt->PrintIR(tab, buffer);
-        } else {
-            std::cerr << "MatchStmtAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    FuncDefAST() : BaseAST(KIND) {}
 };
 
-class UnmatchStmtAST : public BaseAST {
+// FuncFParam: 函数参数
+// FuncFParam ::= Btype IDENT
+class FuncFParamAST : public BaseAST {
 public:
     enum Kind {
-        kNoElse,
-        kElse
+        kInt,
+        kIntArray
     };
 
     Kind kind;
+    
+    int bType; // XXX bType 用数字实现，不太好，应该改成枚举
+    std::string ident;
+    ExpASTList *constArrayDims = nullptr;
 
-    std::unique_ptr<BaseExpAST> exp;
-    std::unique_ptr<BaseAST> stmt;
-    std::unique_ptr<BaseAST> matchStmt;
-    std::unique_ptr<BaseAST> unmatchStmt;
-    int ifLabelIndex;
+    static const ASTKind KIND = ASTKind::kFuncFParam;
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "UnmatchStmtAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kNoElse:
-            ans += tab + "\tkind: noElse\n";
-            ans += tab + "\texp: " + exp->PrintAST(tab + "\t");
-            ans += tab + "\tstmt: " + stmt->PrintAST(tab + "\t");
-            break;
-        case kElse:
-            ans += tab + "\tkind: else\n";
-            ans += tab + "\texp: " + exp->PrintAST(tab + "\t");
-            ans += tab + "\tmatchStmt: " + matchStmt->PrintAST(tab + "\t");
-            ans += tab + "\tunmatchStmt: " + unmatchStmt->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "UnmatchStmtAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
-
-    std::string PrintIR(std::string tab, std::string &buffer) const override {
-        if (kind == kNoElse) {
-            std::string thenLabel = "\%then" + (ifLabelIndex == 0 ? "" : "_" + std::to_string(ifLabelIndex));
-            std::string ifEndLabel = "\%if_end" + (ifLabelIndex == 0 ? "" : "_" + std::to_string(ifLabelIndex));
-            std::string stmtRet;
-
-            // if 的条件判断部分
-            std::string var = exp->PrintIR(tab, buffer);
-            buffer += tab + "br " + var + ", " + thenLabel + ", " + ifEndLabel + "\n";
-            // if 语句的 if 分支
-            buffer += thenLabel + ":\n";
-            stmtRet = stmt->PrintIR(tab, buffer);
-            if (stmtRet != "return" && stmtRet != "break" && stmtRet != "continue") {
-                buffer += tab + "jump " + ifEndLabel + "\n";
-            }
-            // if 语句之后的内容（的标号）
-            buffer += ifEndLabel + ":\n";
-        } else
-        if (kind == kElse) {
-            std::string thenLabel = "\%then" + (ifLabelIndex == 0 ? "" : "_" + std::to_string(ifLabelIndex));
-            std::string elseLabel = "\%else" + (ifLabelIndex == 0 ? "" : "_" + std::to_string(ifLabelIndex));
-            std::string ifEndLabel = "\%if_end" + (ifLabelIndex == 0 ? "" : "_" + std::to_string(ifLabelIndex));
-            std::string stmtRet;
-
-            // if 的条件判断部分
-            std::string var = exp->PrintIR(tab, buffer);
-            buffer += tab + "br " + var + ", " + thenLabel + ", " + elseLabel + "\n";
-            // if 语句的 if 分支
-            buffer += thenLabel + ":\n";
-            stmtRet = matchStmt->PrintIR(tab, buffer);
-            if (stmtRet != "return" && stmtRet != "break" && stmtRet != "continue") {
-                buffer += tab + "jump " + ifEndLabel + "\n";
-            }
-            // if 语句的 else 分支
-            buffer += elseLabel + ":\n";
-            unmatchStmt->PrintIR(tab, buffer); // UnmatchStmt 不会以 return 结尾，一定会跳转，所以不需要判断返回值
-            buffer += tab + "jump " + ifEndLabel + "\n";
-            // if 语句之后的内容（的标号）
-            buffer += ifEndLabel + ":\n";
-        } else {
-            std::cerr << "UnmatchStmtAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    FuncFParamAST() : BaseAST(KIND) {}
 };
 
-// OtherStmt: 不是条件分支的 SysY 语句
-// OtherStme ::= 
-// 翻译为: ret var, var是Exp对应的变量
-/**
-*   翻译为:
-*   Exp
-*   ret var
-*/
-class OtherStmtAST : public BaseAST {
+// Block: 函数的结构体
+// Block :== '{' {BlockItem} '}'
+class BlockAST : public BaseAST {
+public:
+    ASTList *blockItems = nullptr;
+
+    static const ASTKind KIND = ASTKind::kBlock;
+
+    BlockAST() : BaseAST(KIND) {}
+};
+
+class BlockItemAST : public BaseAST {
 public:
     enum Kind {
-        kExp,
-        kAssign,
-        kReturn,
-        kWhile,
-        kBreak,
-        kContinue,
-        kBlock
+        kDecl,
+        kStmt
     };
-    
+
     Kind kind;
 
-    std::unique_ptr<BaseExpAST> lVal;
-    std::unique_ptr<BaseExpAST> exp; // 在 kExp 和 kReturn 类型中，可以为 nullptr
-    int whileIndex; // kWhile、kBreak、kContinue 类型中使用
-    std::unique_ptr<BaseAST> stmt;
-    std::unique_ptr<BaseAST> block;
+    BaseAST *decl = nullptr;
+    BaseAST *stmt = nullptr;
 
-    std::string PrintAST(std::string tab) const override {
-        if (kind == kExp) {
-            std::string ans = "";
-            ans += "OtherStmtAST {\n";
-            ans += tab + "\tkind: " + "exp\n";
-            ans += tab + "\texp: " + (exp == nullptr ? "NULL\n" : exp->PrintAST(tab + "\t"));
-            ans += tab + "}\n";
-            return ans;
-        } else
-        if (kind == kAssign) {
-            std::string ans = "";
-            ans += "OtherStmtAST {\n";
-            ans += tab + "\tkind: " + "assign\n";
-            ans += tab + "\tlVal: " + lVal->PrintAST(tab) + "\n";
-            ans += tab + "\texp: " + exp->PrintAST(tab + "\t");
-            ans += tab + "}\n";
-            return ans;
-        } else
-        if (kind == kWhile) {
-            std::string ans = "";
-            ans += "OtherStmtAST {\n";
-            ans += tab + "\tkind: " + "while\n";
-            ans += tab + "\twhileIndex: " + std::to_string(whileIndex) + "\n";
-            ans += tab + "\texp: " + exp->PrintAST(tab + "\t");
-            ans += tab + "\tstmt: " + stmt->PrintAST(tab + "\t");
-            ans += tab + "}\n";
-            return ans;
-        } else
-        if (kind == kBreak) {
-            std::string ans = "";
-            ans += "OtherStmtAST {\n";
-            ans += tab + "\tkind: " + "break\n";
-            ans += tab + "\twhileIndex: " + std::to_string(whileIndex) + "\n";
-            ans += tab + "}\n";
-            return ans;
-        } else
-        if (kind == kContinue) {
-            std::string ans = "";
-            ans += "OtherStmtAST {\n";
-            ans += tab + "\tkind: " + "continue\n";
-            ans += tab + "\twhileIndex: " + std::to_string(whileIndex) + "\n";
-            ans += tab + "}\n";
-            return ans;
-        } else
-        if (kind == kReturn) {
-            std::string ans = "";
-            ans += "OtherStmtAST {\n";
-            ans += tab + "\tkind: " + "return\n";
-            ans += tab + "\texp: " + (exp == nullptr ? "NULL\n" : exp->PrintAST(tab + "\t"));
-            ans += tab + "}\n";
-            return ans;
-        } else
-        if (kind == kBlock) {
-            std::string ans = "";
-            ans += "OtherStmtAST {\n";
-            ans += tab + "\tkind: " + "block\n";
-            ans += tab + "\tblock: " + block->PrintAST(tab + "\t");
-            ans += tab + "}\n";
-            return ans;
-        } else {
-            std::cerr << "OtherStmtAST::PrintAST: unknown kind" << std::endl;
-            return "";
-        }
-    }
+    static const ASTKind KIND = ASTKind::kBlockItem;
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        // Exp
-        if (kind == kExp) {
-            if (exp != nullptr) exp->PrintIR(tab, buffer);
-        } else
-        // Exp
-        // store var, @lVal
-        if (kind == kAssign) {
-            std::string var = exp->PrintIR(tab, buffer);
-            std::string lValName = lVal->PrintIR(tab, buffer);
-            buffer += tab + "store " + var + ", " + lValName + "\n";
-        } else
-        if (kind == kWhile) {
-            std::string whileEntryLabel = "\%while_entry" + (whileIndex == 0 ? "" : "_" + std::to_string(whileIndex));
-            std::string whileBodyLabel = "\%while_body" + (whileIndex == 0 ? "" : "_" + std::to_string(whileIndex));
-            std::string whileEndLabel = "\%while_end" + (whileIndex == 0 ? "" : "_" + std::to_string(whileIndex));
-            std::string stmtRet;
-
-            // while 循环的入口
-            buffer += tab + "jump " + whileEntryLabel + "\n";
-            buffer += whileEntryLabel + ":\n";
-            buffer += tab + "br " + exp->PrintIR(tab, buffer) + ", " + whileBodyLabel + ", " + whileEndLabel + "\n";
-            // while 循环的循环体
-            buffer += whileBodyLabel + ":\n";
-            stmtRet = stmt->PrintIR(tab, buffer);
-            if (stmtRet != "return" && stmtRet != "break" && stmtRet != "continue") {
-                buffer += tab + "jump " + whileEntryLabel + "\n";
-            }
-            // while 循环的结尾
-            buffer += whileEndLabel + ":\n";
-        } else
-        if (kind == kBreak) {
-            std::string whileEndLabel = "\%while_end" + (whileIndex == 0 ? "" : "_" + std::to_string(whileIndex));
-            buffer += tab + "jump " + whileEndLabel + "\n";
-            return "break"; // 返回 break，说明该基本块以 break 语句结尾，语句块结尾不能加 br、jump 等
-        } else
-        if (kind == kContinue) {
-            std::string whileEntryLabel = "\%while_entry" + (whileIndex == 0 ? "" : "_" + std::to_string(whileIndex));
-            buffer += tab + "jump " + whileEntryLabel + "\n";
-            return "continue"; // 返回 continue，说明该基本块以 continue 语句结尾，语句块结尾不能加 br、jump 等
-        } else
-        // Exp
-        // ret var
-        if (kind == kReturn) {
-            std::string retVar = exp == nullptr ? "" : " " + exp->PrintIR(tab, buffer);
-            buffer += tab + "ret" + retVar + "\n";
-            return "return"; // 返回 return，说明该基本块以 return 语句结尾，语句块结尾不能加 br、jump 等
-        } else
-        // Block
-        if (kind == kBlock) {
-            return block->PrintIR(tab, buffer);
-        } else {
-            std::cerr << "OtherStmtAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    BlockItemAST() : BaseAST(KIND) {}
 };
 
-class ConstExpAST : public BaseExpAST {
+class DeclAST : public BaseAST {
 public:
-    std::unique_ptr<BaseExpAST> exp;
-
-    bool isCalcuated = false;
-    int value;
-
-    int CalcConstExp() const override {
-        if (isCalcuated) {
-            return value;
-        } else {
-            return exp->CalcConstExp();
-        }
-    }
+    enum Kind {
+        kConstDecl,
+        kVarDecl
+    };
+    
+    Kind kind;
+    
+    BaseAST *constDecl = nullptr;
+    BaseAST *varDecl = nullptr;
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "ConstExpAST {\n";
-        ans += tab + "\texp: " + exp->PrintAST(tab + "\t");
-        ans += tab + "}\n";
-        return ans;
-    }
+    static const ASTKind KIND = ASTKind::kDecl;
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        // PrintIR 前已经计算了常量表达式的值（在语法分析的时候）
-        return std::to_string(value);
-    }
+    DeclAST() : BaseAST(KIND) {}
 };
 
-// Exp: 一个 SysY 表达式
-// Exp ::= AddExp;
-/**
-*   翻译为:
-*   [addExp]
-*/
-class ExpAST : public BaseExpAST {
+class ConstDeclAST : public BaseAST {
 public:
-    std::unique_ptr<BaseExpAST> lOrExp;
+    /* enum BType {
+        kInt,
+    }; */
 
-    int CalcConstExp() const override {
-        return lOrExp->CalcConstExp();
-    }
+    int bType;
+    ASTList *constDefs = nullptr; // XXX 也许不需要存储指针
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "ExpAST {\n";
-        ans += tab + "\taddExp: " + lOrExp->PrintAST(tab + "\t");
-        ans += tab + "}\n";
-        return ans;
-    }
+    static const ASTKind KIND = ASTKind::kConstDecl;
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        std::string var = lOrExp->PrintIR(tab, buffer);
-        return var;
-    }
+    ConstDeclAST() : BaseAST(KIND) {}
 };
 
-// PrimaryExpAST: 表达式中优先计算的部分, 即被'()'包裹的表达式/标识符/单个数字
-// PrimaryExp ::= "(" Exp ")" | LVal | Number;
-// LVal 就是变量标识符，常量会被直接替换为 Number
-class PrimaryExpAST : public BaseExpAST {
+class ConstInitValAST : public BaseExpAST {
 public:
     enum Kind {
         kExp,
-        kLVal,
-        kNumber
+        kList   // 花括号括起来的初始化列表
     };
 
     Kind kind;
-    std::unique_ptr<BaseExpAST> exp;
-    std::unique_ptr<BaseExpAST> lVal;
-    int number;
+
+    BaseExpAST *constExp = nullptr;
+    ExpASTList *constInitVals = nullptr; // 初始化列表中的各项, 可以为空
 
     int CalcConstExp() const override {
         if (kind == kExp) {
-            return exp->CalcConstExp();
-        } else
-        if (kind == kLVal) {
-            return lVal->CalcConstExp();
-            return 0;
-        } else
-        if (kind == kNumber) {
-            return number;
+            return constExp->CalcConstExp();
         } else {
-            std::cerr << "PrimaryExpAST::CalcConstExp: unknown kind" << std::endl;
+            std::cerr << "ConstInitValAST::CalcConstExp: init list is not a single value" << std::endl;
             return 0;
         }
     }
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "PrimaryExpAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kExp:
-            ans += tab + "\texp: " + exp->PrintAST(tab + "\t");
-            break;
-        case kLVal:
-            ans += tab + "\tLVal: " + lVal->PrintAST(tab + "\t") + "\n";
-            break;
-        case kNumber:
-            ans += tab + "\tnumber: " + std::to_string(number) + "\n";
-            break;
-        default:
-            std::cerr << "PrimaryExpAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
+    bool IsConstExp() const override {
+        return kind == kExp;
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        if (kind == kExp) {
-            return exp->PrintIR(tab, buffer);
-        } else
-        if (kind == kLVal) {
-            std::string lVarName = lVal->PrintIR(tab, buffer);
-            if (lVarName[0] == '*')  { // 不是需要 load 的变量
-                lVarName = lVarName.substr(1);
-                // if (lVarName[1] == '@' || lVarName[1] == '%') { // 不是常量，是数组指针类型的变量
-                //     std::string now = NewTempSymbol();
-                //     buffer += tab + now + " = getelemptr " + lVarName + "\n";
-                //     return now;
-                // }
-                return lVarName;
-            } else { // 需要 load 的变量
-                std::string now = NewTempSymbol();
-                buffer += tab + now + " = load " + lVarName + "\n";
-                return now;
+    static const ASTKind KIND = ASTKind::kConstInitVal;
+
+    ConstInitValAST() : BaseExpAST(KIND) {}
+
+    Value PrintValueIR(IRWriter &out) const override{
+        Value var = constExp->PrintValueIR(out);
+        return var;
+    }
+
+    // 与 InitValAST::Flatten 相同的规则, 直接计算出各元素的值, 没有给出的元素保持为 0
+    void Flatten(const std::vector<int> &dims, size_t level, size_t begin, std::vector<int> &values) const {
+        size_t size = 1;
+        for (size_t i = level; i < dims.size(); i++) size *= dims[i];
+        size_t pos = 0;
+        for (auto &constInitVal : *constInitVals) {
+            auto item = static_cast<const ConstInitValAST *>(constInitVal);
+            if (pos >= size) {
+                std::cerr << "ConstInitValAST::Flatten: too many initializers" << std::endl;
+                return;
             }
-        } else
-        if (kind == kNumber) {
-            return std::to_string(number);
-        } else {
-            std::cerr << "PrimaryExpAST::PrintIR: unknown kind" << std::endl;
+            if (item->kind == kExp) {
+                values[begin + pos] = item->constExp->CalcConstExp();
+                pos++;
+                continue;
+            }
+            size_t sub = level + 1, subSize = size / dims[level];
+            while (sub < dims.size() && pos % subSize != 0) {
+                subSize /= dims[sub];
+                sub++;
+            }
+            if (sub == dims.size()) {
+                item->Flatten(std::vector<int>{1}, 0, begin + pos, values);
+                pos++;
+                continue;
+            }
+            item->Flatten(dims, sub, begin + pos, values);
+            pos += subSize;
         }
-        return "";
     }
 };
 
-class LValAST: public BaseExpAST {
+class ConstDefAST : public BaseAST {
 public:
     enum Kind {
         kConst,
-        kVar,
-        kArray
+        kArray  // 常量数组
     };
 
     Kind kind;
 
-    int identVal; // 标识符在符号表中的值
+    bool isGlobal;
     std::string ident;
-    std::unique_ptr<std::vector<std::unique_ptr<BaseExpAST> > > arrayDims;
-    bool isArrayPtr; // 是否是数组指针
-
-    int CalcConstExp() const override {
-        if (kind == kConst) {
-            return identVal;
+    BaseExpAST *constInitVal = nullptr;
+    ExpASTList *constArrayDims = nullptr;
+
+    // 常量数组在 .rodata 中的名字 (不含 @), 各维长度与展开后的值, 在语法分析时计算
+    std::string arrayName;
+    std::vector<int> dims;
+    std::shared_ptr<std::vector<int> > values;
+
+    // 计算常量数组的各维长度与值
+    void CalcArrayValues() {
+        dims.clear();
+        for (auto &constArrayDim : *constArrayDims) dims.push_back(constArrayDim->CalcConstExp());
+        size_t total = 1;
+        for (int dim : dims) total *= dim;
+        values = std::make_shared<std::vector<int> >(total, 0);
+        auto init = static_cast<const ConstInitValAST *>(constInitVal);
+        if (init->kind == ConstInitValAST::kList) {
+            init->Flatten(dims, 0, 0, *values);
         } else {
-            std::cerr << "LValAST::CalcConstExp: lVal is not a const" << std::endl;
-        }
-        return 0;
-    }
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "LValAST {\n";
-        switch (kind) {
-        case kConst:
-            ans += tab + "\tconst: " + std::to_string(identVal) + "\n";
-            break;
-        case kVar:
-            ans += tab + "\tvar: " + ident + "\n";
-            break;
-        case kArray:
-            ans += tab + "\tarray: " + ident + "\n";
-            ans += tab + "\tarrayDims: [\n";
-            for (auto &dim : *arrayDims) {
-                ans += tab + "\t\t" + dim->PrintAST(tab + "\t\t") + "\n";
-            }
-            ans += tab + "\t]\n";
-            break;
-        default:
-            std::cerr << "LValAST::PrintAST: unknown kind" << std::endl;
-            break;
+            std::cerr << "ConstDefAST: const array " << ident << " must be initialized by an init list" << std::endl;
         }
-        ans += tab + "}\n";
-        return ans;
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        // 开头为 *，表示是需要求值的东西（而不是被赋值的变量），且不需要 load
-        
-        if (kind == kConst) {
-            // 常量不需要 load
-            return "*" + std::to_string(identVal);
-        } else
-        if (kind == kVar) {
-            if (identVal == -1) {
-                return "\%" + ident + "_fParam";
-            } else
-            if (identVal == -2) { // 是数组指针类型的函数形参
-                std::string now = NewTempSymbol();
-                buffer += tab + now + " = load \%" + ident + "_fParam\n";
-                std::string now2 = NewTempSymbol();
-                buffer += tab + now2 + " = getptr " + now + ", 0\n";
-                return "*" + now2;
-            } else {
-                std::string var = "@" + ident + (identVal == 0 ? "" : "_" + std::to_string(identVal));
-                // 数组指针不需要 load
-                if (isArrayPtr) {
-                    std::string now = NewTempSymbol();
-                    buffer += tab + now + " = getelemptr " + var + ", 0\n";
-                    return "*" + now;
-                } else {
-                    return var;
-                }
-            }
-        } else
-        if (kind == kArray) {
-            std::string pre;
-            if (identVal == -2) {
-                std::string fParamIdent = "\%" + ident + "_fParam";
-                pre = NewTempSymbol();
-                buffer += tab + pre + " = load " + fParamIdent + "\n";
-            } else {
-                pre = "@" + ident + (identVal == 0 ? "" : "_" + std::to_string(identVal));
-            }
-
-            for (auto &dim : *arrayDims) {
-                std::string var = dim->PrintIR(tab, buffer); // 数组下标
-                std::string now = NewTempSymbol();
-                // 变量是数组类型的函数形参，且是第一个下标
-                if (identVal == -2 && dim == arrayDims->front()) {
-                    buffer += tab + now + " = getptr " + pre + ", " + var + "\n";
-                } else {
-                    buffer += tab + now + " = getelemptr " + pre + ", " + var + "\n";
-                }
-                pre = now;
-            }
+    static const ASTKind KIND = ASTKind::kConstDef;
 
-            if (isArrayPtr) { // 数组指针，需要作为函数参数传递
-                std::string now = NewTempSymbol();
-                buffer += tab + now + " = getelemptr " + pre + ", 0\n";
-                return "*" + now;
-            } else {
-                return pre;
-            }
-        } else {
-            std::cerr << "LValAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    ConstDefAST() : BaseAST(KIND) {}
 };
 
-// UnaryExpAST: 单目运算表达式
-// UnaryExp ::= PrimaryExp | '+' UnaryExp | '-' UnaryExp | '!' UnaryExp
-/**
-*   翻译为:
-*   1. [PrimaryExp]
-*   2. [UnaryExp]
-*/
-class UnaryExpAST : public BaseExpAST {
+class VarDeclAST : public BaseAST {
 public:
-    enum Kind {
-        kPrimaryExp,
-        kCall,
-        kPositive,
-        kNegative,
-        kNot
-    };
-    
-    Kind kind;
-    std::unique_ptr<BaseExpAST> primaryExp;
-    std::string ident;
-    int funcType;
-    int funcFParamNum;
-    bool *funcFParamIsArray;
-    std::unique_ptr<std::vector<std::unique_ptr<BaseExpAST> > > funcRParams;
-    std::unique_ptr<BaseExpAST> unaryExp;
-
-    int CalcConstExp() const override {
-        if (kind == kPrimaryExp) {
-            return primaryExp->CalcConstExp();
-        } else
-        if (kind == kCall) {
-            std::cerr << "UnaryExpAST::CalcConstExp: call is not a const" << std::endl;
-            return 0;
-        } else
-        if (kind == kPositive) {
-            return unaryExp->CalcConstExp();
-        } else
-        if (kind == kNegative) {
-            return -unaryExp->CalcConstExp();
-        } else
-        if (kind == kNot) {
-            return !unaryExp->CalcConstExp();
-        } else {
-            std::cerr << "UnaryExpAST::CalcConstExp: unknown kind" << std::endl;
-            return 0;
-        }
-    }
+    int bType;
+    ASTList *varDefs = nullptr;
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "UnaryExpAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kPrimaryExp:
-            ans += tab + "\tprimaryExp: " + primaryExp->PrintAST(tab + "\t");
-            break;
-        case kCall:
-            ans += tab + "\tident: " + ident + "\n";
-            ans += tab + "\tfuncRParams: {\n";
-            for (auto &param : *funcRParams) {
-                ans += tab + "\t\t" + param->PrintAST(tab + "\t\t");
-            }
-            ans += tab + "\t}\n";
-            break;
-        case kPositive:
-            ans += tab + "\tunaryOp: " + "+" + "\n";
-            ans += tab + "\tunaryExp: " + unaryExp->PrintAST(tab + "\t");
-            break;
-        case kNegative:
-            ans += tab + "\tunaryOp: " + "-" + "\n";
-            ans += tab + "\tunaryExp: " + unaryExp->PrintAST(tab + "\t");
-            break;
-        case kNot:
-            ans += tab + "\tunaryOp: " + "!" + "\n";
-            ans += tab + "\tunaryExp: " + unaryExp->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "UnaryExpAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
+    static const ASTKind KIND = ASTKind::kVarDecl;
 
-        ans += tab + "}\n";
-        return ans;
-    }
-    std::string PrintIR(std::string tab, std::string &buffer) const override{
-        if(kind == kPrimaryExp) {
-            std::string var = primaryExp->PrintIR(tab, buffer);
-            return var;
-        } else
-        if (kind == kCall) {
-            if (funcType == 0) { // void
-                // 先算出实参列表
-                std::vector<std::string> params;
-                if (funcRParams != nullptr) {
-                    int fParamId = 0;
-                    for (auto &paramAST : *funcRParams) {
-                        params.push_back(paramAST->PrintIR(tab, buffer));
-                        fParamId++;
-                    }
-                }
-                buffer += tab + "call @" + ident + "(";
-                if (funcRParams != nullptr) {
-                    for (auto &param : params) {
-                        buffer += param;
-                        if (param != params.back()) {
-                            buffer += ", ";
-                        }
-                    }
-                }
-                buffer += ")\n";
-                return "";
-            } else
-            if (funcType == 1) { // int
-                // 先算出实参列表
-                std::vector<std::string> params;
-                if (funcRParams != nullptr) {
-                    int fParamId = 0;
-                    for (auto &paramAST : *funcRParams) {
-                        params.push_back(paramAST->PrintIR(tab, buffer));
-                        fParamId++;
-                    }
-                }
-                std::string now = NewTempSymbol();
-                buffer += tab + now + " = call @" + ident + "(";
-                if (funcRParams != nullptr) {
-                    for (auto &param : params) {
-                        buffer += param;
-                        if (param != params.back()) {
-                            buffer += ", ";
-                        }
-                    }
-                }
-                buffer += ")\n";
-                return now;
-            } else {
-                std::cerr << "UnaryExpAST::PrintIR: unknown funcType" << std::endl;
-            }
-        } else
-        // +, 不产生IR
-        if (kind == kPositive) {
-            std::string var = unaryExp->PrintIR(tab, buffer);
-            return var;
-        } else
-        // -, IR格式为: now = sub 0, var
-        if (kind == kNegative) {
-            std::string var = unaryExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = " + "sub" + " 0, " + var + "\n";
-            return now;
-        } else
-        // !, IR格式为: now = eq 0, var
-        if (kind == kNot) {
-            std::string var = unaryExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = " + "eq" + " 0, " + var + "\n";
-            return now;
-        } else {
-            std::cerr << "UnaryExpAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    VarDeclAST() : BaseAST(KIND) {}
 };
 
-// MulExpAST: 乘法表达式，包括乘法、除法、取模
-// MulExp ::= UnaryExp | MulExp '*' UnaryExp | MulExp '/' UnaryExp | MulExp '%' UnaryExp
-/**
- * 翻译为:
- * 1. [UnaryExp]
- * 2. var = mul [MulExp], [UnaryExp]
- * 3.
- * 4.
- */
-class MulExpAST : public BaseExpAST {
+class InitValAST : public BaseExpAST {
 public:
     enum Kind {
-        kUnaryExp,
-        kMul,
-        kDiv,
-        kMod
+        kExp,
+        kList   // 花括号括起来的初始化列表
     };
 
     Kind kind;
 
-    std::unique_ptr<BaseExpAST> unaryExp;
-    std::unique_ptr<BaseExpAST> mulExp;
+    BaseExpAST *exp = nullptr;
+    ExpASTList *initVals = nullptr; // 初始化列表中的各项, 可以为空
 
     int CalcConstExp() const override {
-        if (kind == kUnaryExp) {
-            return unaryExp->CalcConstExp();
-        } else
-        if (kind == kMul) {
-            return mulExp->CalcConstExp() * unaryExp->CalcConstExp();
-        } else
-        if (kind == kDiv) {
-            return mulExp->CalcConstExp() / unaryExp->CalcConstExp();
-        } else
-        if (kind == kMod) {
-            return mulExp->CalcConstExp() % unaryExp->CalcConstExp();
+        if (kind == kExp) {
+            return exp->CalcConstExp();
         } else {
-            std::cerr << "MulExpAST::CalcConstExp: unknown kind" << std::endl;
+            std::cerr << "InitValAST::CalcConstExp: init list is not a const" << std::endl;
             return 0;
         }
     }
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "MulExpAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kUnaryExp:
-            ans += tab + "\tunaryExp: " + unaryExp->PrintAST(tab + "\t");
-            break;
-        case kMul:
-            ans += tab + "\tmulExp: " + mulExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: *\n";
-            ans += tab + "\tunaryExp: " + unaryExp->PrintAST(tab + "\t");
-            break;
-        case kDiv:
-            ans += tab + "\tmulExp: " + mulExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: /\n";
-            ans += tab + "\tunaryExp: " + unaryExp->PrintAST(tab + "\t");
-            break;
-        case kMod:
-            ans += tab + "\tmulExp: " + mulExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: %\n";
-            ans += tab + "\tunaryExp: " + unaryExp->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "MulExpAST::PrintAST: unknown kind" << std::endl;
-            break;
+    bool IsConstExp() const override {
+        return kind == kExp && exp->IsConstExp();
+    }
+
+    static const ASTKind KIND = ASTKind::kInitVal;
+
+    InitValAST() : BaseExpAST(KIND) {}
+
+    Value PrintValueIR(IRWriter &out) const override{
+        if (kind == kList) {
+            std::cerr << "InitValAST::PrintIR: init list can only be used for arrays" << std::endl;
+            return Value::Const(0);
         }
-        ans += tab + "}\n";
-        return ans;
+        Value var = exp->PrintValueIR(out); // XXX 目前没有检测是否是常量表达式（可以优化）
+        return var;
     }
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override {
-        if (kind == kUnaryExp) {
-            std::string var = unaryExp->PrintIR(tab, buffer);
-            return var;
-        } else
-        if (kind == kMul) {
-            std::string var1 = mulExp->PrintIR(tab, buffer);
-            std::string var2 = unaryExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = mul " + var1 + ", " + var2 + "\n";
-            return now;
-        } else
-        if (kind == kDiv) {
-            std::string var1 = mulExp->PrintIR(tab, buffer);
-            std::string var2 = unaryExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = div " + var1 + ", " + var2 + "\n";
-            return now;
-        } else
-        if (kind == kMod) {
-            std::string var1 = mulExp->PrintIR(tab, buffer);
-            std::string var2 = unaryExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = mod " + var1 + ", " + var2 + "\n";
-            return now;
-        } else {
-            std::cerr << "MulExpAST::PrintIR: unknown kind" << std::endl;
+    // 按照 SysY 的规则, 把初始化列表展开到 elems[begin, begin + 第 level 维及之后的元素个数) 中
+    // 列表中的表达式依次填入下一个元素, 子列表初始化当前位置对齐的最大的子数组, 没有给出的元素保持为 nullptr (即 0)
+    void Flatten(const std::vector<int> &dims, size_t level, size_t begin, std::vector<const BaseExpAST *> &elems) const {
+        size_t size = 1;
+        for (size_t i = level; i < dims.size(); i++) size *= dims[i];
+        size_t pos = 0;
+        for (auto &initVal : *initVals) {
+            auto item = static_cast<const InitValAST *>(initVal);
+            if (pos >= size) {
+                std::cerr << "InitValAST::Flatten: too many initializers" << std::endl;
+                return;
+            }
+            if (item->kind == kExp) {
+                elems[begin + pos] = item->exp;
+                pos++;
+                continue;
+            }
+            size_t sub = level + 1, subSize = size / dims[level];
+            while (sub < dims.size() && pos % subSize != 0) {
+                subSize /= dims[sub];
+                sub++;
+            }
+            if (sub == dims.size()) {
+                // 与 C 相同, 没有对齐到任何子数组的 {x} 只初始化当前的一个元素
+                item->Flatten(std::vector<int>{1}, 0, begin + pos, elems);
+                pos++;
+                continue;
+            }
+            item->Flatten(dims, sub, begin + pos, elems);
+            pos += subSize;
         }
-        return "";
     }
 };
 
-// AddExpAST: 加法表达式，包括加法、减法
-// AddExp ::= MulExp | AddExp '+' MulExp | AddExp '-' MulExp
-class AddExpAST : public BaseExpAST {
+class VarDefAST : public BaseAST {
 public:
     enum Kind {
-        kMulExp,
-        kAdd,
-        kSub
+        kUnInit,
+        kArray,     // 没有初始化的数组
+        kInit,
+        kArrayInit  // 有初始化列表的数组
     };
 
     Kind kind;
 
-    std::unique_ptr<BaseExpAST> mulExp;
-    std::unique_ptr<BaseExpAST> addExp;
-
-    int CalcConstExp() const override {
-        if (kind == kMulExp) {
-            return mulExp->CalcConstExp();
-        } else
-        if (kind == kAdd) {
-            return addExp->CalcConstExp() + mulExp->CalcConstExp();
-        } else
-        if (kind == kSub) {
-            return addExp->CalcConstExp() - mulExp->CalcConstExp();
-        } else {
-            std::cerr << "AddExpAST::CalcConstExp: unknown kind" << std::endl;
-            return 0;
-        }
-    }
+    bool isGlobal;
+    std::string ident;
+    BaseExpAST *initVal = nullptr;
+    ExpASTList *constArrayDims = nullptr; 
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "AddExpAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kMulExp:
-            ans += tab + "\tmulExp: " + mulExp->PrintAST(tab + "\t");
-            break;
-        case kAdd:
-            ans += tab + "\taddExp: " + addExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: +\n";
-            ans += tab + "\tmulExp: " + mulExp->PrintAST(tab + "\t");
-            break;
-        case kSub:
-            ans += tab + "\taddExp: " + addExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: -\n";
-            ans += tab + "\tmulExp: " + mulExp->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "AddExpAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
+    static const ASTKind KIND = ASTKind::kVarDef;
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override {
-        if (kind == kMulExp) {
-            std::string var = mulExp->PrintIR(tab, buffer);
-            return var;
-        } else
-        if (kind == kAdd) {
-            std::string var1 = addExp->PrintIR(tab, buffer);
-            std::string var2 = mulExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = add " + var1 + ", " + var2 + "\n";
-            return now;
-        } else
-        if (kind == kSub) {
-            std::string var1 = addExp->PrintIR(tab, buffer);
-            std::string var2 = mulExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = sub " + var1 + ", " + var2 + "\n";
-            return now;
-        } else {
-            std::cerr << "AddExpAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    VarDefAST() : BaseAST(KIND) {}
 };
 
-// RelExpAST: 关系表达式，包括小于、大于、小于等于、大于等于
-// RelExp ::= AddExp | RelExp '<' AddExp | RelExp '>' AddExp | RelExp '<=' AddExp | RelExp '>=' AddExp
-class RelExpAST : public BaseExpAST {
+class StmtAST : public BaseAST {
 public:
     enum Kind {
-        kAddExp,
-        kLT,
-        kGT,
-        kLE,
-        kGE,
+        kMatch,
+        kUnmatch,
     };
 
     Kind kind;
 
-    std::unique_ptr<BaseExpAST> addExp;
-    std::unique_ptr<BaseExpAST> relExp;
-
-    int CalcConstExp() const override {
-        if (kind == kAddExp) {
-            return addExp->CalcConstExp();
-        } else
-        if (kind == kLT) {
-            return relExp->CalcConstExp() < addExp->CalcConstExp();
-        } else
-        if (kind == kGT) {
-            return relExp->CalcConstExp() > addExp->CalcConstExp();
-        } else
-        if (kind == kLE) {
-            return relExp->CalcConstExp() <= addExp->CalcConstExp();
-        } else
-        if (kind == kGE) {
-            return relExp->CalcConstExp() >= addExp->CalcConstExp();
-        } else {
-            std::cerr << "RelExpAST::CalcConstExp: unknown kind" << std::endl;
-            return 0;
-        }
-    }
+    BaseAST *matchStmt = nullptr;
+    BaseAST *unmatchStmt = nullptr;
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "RelExpAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kAddExp:
-            ans += tab + "\taddExp: " + addExp->PrintAST(tab + "\t");
-            break;
-        case kLT:
-            ans += tab + "\trelExp: " + relExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: <\n";
-            ans += tab + "\taddExp: " + addExp->PrintAST(tab + "\t");
-            break;
-        case kGT:
-            ans += tab + "\trelExp: " + relExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: >\n";
-            ans += tab + "\taddExp: " + addExp->PrintAST(tab + "\t");
-            break;
-        case kLE:
-            ans += tab + "\trelExp: " + relExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: <=\n";
-            ans += tab + "\taddExp: " + addExp->PrintAST(tab + "\t");
-            break;
-        case kGE:
-            ans += tab + "\trelExp: " + relExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: >=\n";
-            ans += tab + "\taddExp: " + addExp->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "RelExpAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
+    static const ASTKind KIND = ASTKind::kStmt;
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override {
-        if (kind == kAddExp) {
-            std::string var = addExp->PrintIR(tab, buffer);
-            return var;
-        } else
-        if (kind == kLT) {
-            std::string var1 = relExp->PrintIR(tab, buffer);
-            std::string var2 = addExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = lt " + var1 + ", " + var2 + "\n";
-            return now;
-        } else
-        if (kind == kGT) {
-            std::string var1 = relExp->PrintIR(tab, buffer);
-            std::string var2 = addExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = gt " + var1 + ", " + var2 + "\n";
-            return now;
-        } else
-        if (kind == kLE) {
-            std::string var1 = relExp->PrintIR(tab, buffer);
-            std::string var2 = addExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = le " + var1 + ", " + var2 + "\n";
-            return now;
-        } else
-        if (kind == kGE) {
-            std::string var1 = relExp->PrintIR(tab, buffer);
-            std::string var2 = addExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = ge " + var1 + ", " + var2 + "\n";
-            return now;
-        } else {
-            std::cerr << "RelExpAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    StmtAST() : BaseAST(KIND) {}
 };
 
-// EqExpAST: 相等表达式，包括等于、不等于
-// EqExp ::= RelExp | EqExp '==' RelExp | EqExp '!=' RelExp
-class EqExpAST : public BaseExpAST {
+class MatchStmtAST : public BaseAST {
 public:
     enum Kind {
-        kRelExp,
-        kEQ,
-        kNE,
+        kIf,
+        kOther
     };
-    
-    Kind kind;
 
-    std::unique_ptr<BaseExpAST> relExp;
-    std::unique_ptr<BaseExpAST> eqExp;
+    Kind kind;
+    
+    BaseExpAST *exp = nullptr;
+    BaseAST *matchStmt1 = nullptr, *matchStmt2 = nullptr;
+    BaseAST *otherStmt = nullptr;
+    int ifLabelIndex;
 
-    int CalcConstExp() const override {
-        if (kind == kRelExp) {
-            return relExp->CalcConstExp();
-        } else
-        if (kind == kEQ) {
-            return eqExp->CalcConstExp() == relExp->CalcConstExp();
-        } else
-        if (kind == kNE) {
-            return eqExp->CalcConstExp() != relExp->CalcConstExp();
-        } else {
-            std::cerr << "EqExpAST::CalcConstExp: unknown kind" << std::endl;
-            return 0;
-        }
-    }
+    static const ASTKind KIND = ASTKind::kMatchStmt;
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "EqExpAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kRelExp:
-            ans += tab + "\trelExp: " + relExp->PrintAST(tab + "\t");
-            break;
-        case kEQ:
-            ans += tab + "\teqExp: " + eqExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: ==\n";
-            ans += tab + "\trelExp: " + relExp->PrintAST(tab + "\t");
-            break;
-        case kNE:
-            ans += tab + "\teqExp: " + eqExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: !=\n";
-            ans += tab + "\trelExp: " + relExp->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "EqExpAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
-
-    std::string PrintIR(std::string tab, std::string &buffer) const override {
-        if (kind == kRelExp) {
-            std::string var = relExp->PrintIR(tab, buffer);
-            return var;
-        } else
-        if (kind == kEQ) {
-            std::string var1 = eqExp->PrintIR(tab, buffer);
-            std::string var2 = relExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = eq " + var1 + ", " + var2 + "\n";
-            return now;
-        } else
-        if (kind == kNE) {
-            std::string var1 = eqExp->PrintIR(tab, buffer);
-            std::string var2 = relExp->PrintIR(tab, buffer);
-            std::string now = NewTempSymbol();
-            buffer += tab + now + " = ne " + var1 + ", " + var2 + "\n";
-            return now;
-        } else {
-            std::cerr << "EqExpAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    MatchStmtAST() : BaseAST(KIND) {}
 };
 
-// LANDExpAST: 逻辑与表达式
-// LAndExp ::= EqExp | LAndExp '&&' EqExp
-class LAndExpAST : public BaseExpAST {
+class UnmatchStmtAST : public BaseAST {
 public:
     enum Kind {
-        kEqExp,
-        kAnd,
+        kNoElse,
+        kElse
     };
 
     Kind kind;
 
-    std::unique_ptr<BaseExpAST> eqExp;
-    std::unique_ptr<BaseExpAST> lAndExp;
-
-    int CalcConstExp() const override {
-        if (kind == kEqExp) {
-            return eqExp->CalcConstExp();
-        } else
-        if (kind == kAnd) {
-            return lAndExp->CalcConstExp() && eqExp->CalcConstExp();
-        } else {
-            std::cerr << "LAndExpAST::CalcConstExp: unknown kind" << std::endl;
-            return 0;
-        }
-    }
+    BaseExpAST *exp = nullptr;
+    BaseAST *stmt = nullptr;
+    BaseAST *matchStmt = nullptr;
+    BaseAST *unmatchStmt = nullptr;
+    int ifLabelIndex;
 
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "LAndExpAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kEqExp:
-            ans += tab + "\teqExp: " + eqExp->PrintAST(tab + "\t");
-            break;
-        case kAnd:
-            ans += tab + "\tlAndExp: " + lAndExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: &&\n";
-            ans += tab + "\teqExp: " + eqExp->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "LAndExpAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
+    static const ASTKind KIND = ASTKind::kUnmatchStmt;
 
-    std::string PrintIR(std::string tab, std::string &buffer) const override {
-        if (kind == kEqExp) {
-            std::string var = eqExp->PrintIR(tab, buffer);
-            return var;
-        } else
-        if (kind == kAnd) {
-            std::string var1 = lAndExp->PrintIR(tab, buffer);
-            std::string var2 = eqExp->PrintIR(tab, buffer);
-            // 用其他运算实现逻辑与
-            // now1 = ne 0, var1
-            // now2 = ne 0, var2
-            // now3 = and now1, now2
-            std::string now1 = NewTempSymbol();
-            std::string now2 = NewTempSymbol();
-            std::string now3 = NewTempSymbol();
-            buffer += tab + now1 + " = ne 0, " + var1 + "\n";
-            buffer += tab + now2 + " = ne 0, " + var2 + "\n";
-            buffer += tab + now3 + " = and " + now1 + ", " + now2 + "\n";
-            return now3;
-        } else {
-            std::cerr << "LAndExpAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    UnmatchStmtAST() : BaseAST(KIND) {}
 };
 
-// LORExpAST: 逻辑或表达式
-// LOrExp ::= LAndExp | LOrExp '||' LAndExp
-class LOrExpAST : public BaseExpAST {
+// OtherStmt: 不是条件分支的 SysY 语句
+// OtherStme ::= 
+// 翻译为: ret var, var是Exp对应的变量
+/**
+*   翻译为:
+*   Exp
+*   ret var
+*/
+class OtherStmtAST : public BaseAST {
 public:
     enum Kind {
-        kLAndExp,
-        kOr,
+        kExp,
+        kAssign,
+        kReturn,
+        kWhile,
+        kBreak,
+        kContinue,
+        kBlock
     };
-
+    
     Kind kind;
 
-    std::unique_ptr<BaseExpAST> lAndExp;
-    std::unique_ptr<BaseExpAST> lOrExp;
+    ExpAST *lVal = nullptr;
+    BaseExpAST *exp = nullptr; // 在 kExp 和 kReturn 类型中，可以为 nullptr
+    int whileIndex; // kWhile、kBreak、kContinue 类型中使用
+    BaseAST *stmt = nullptr;
+    BaseAST *block = nullptr;
 
-    int CalcConstExp() const override {
-        if (kind == kLAndExp) {
-            return lAndExp->CalcConstExp();
-        } else
-        if (kind == kOr) {
-            return lOrExp->CalcConstExp() || lAndExp->CalcConstExp();
-        } else {
-            std::cerr << "LOrExpAST::CalcConstExp: unknown kind" << std::endl;
-        }
-        return 0;
-    }
-
-    std::string PrintAST(std::string tab) const override {
-        std::string ans = "";
-        ans += "LOrExpAST {\n";
-        switch (kind) { // XXX 把switch改成if else，switch中不能定义变量
-        case kLAndExp:
-            ans += tab + "\tlAndExp: " + lAndExp->PrintAST(tab + "\t");
-            break;
-        case kOr:
-            ans += tab + "\tlOrExp: " + lOrExp->PrintAST(tab + "\t");
-            ans += tab + "\tkind: ||\n";
-            ans += tab + "\tlAndExp: " + lAndExp->PrintAST(tab + "\t");
-            break;
-        default:
-            std::cerr << "LOrExpAST::PrintAST: unknown kind" << std::endl;
-            break;
-        }
-        ans += tab + "}\n";
-        return ans;
-    }
-        
-    std::string PrintIR(std::string tab, std::string &buffer) const override {
-        if (kind == kLAndExp) {
-            std::string var = lAndExp->PrintIR(tab, buffer);
-            return var;
-        } else
-        if (kind == kOr) {
-            std::string var1 = lOrExp->PrintIR(tab, buffer);
-            std::string var2 = lAndExp->PrintIR(tab, buffer);
-            // 用其他运算实现逻辑或
-            // now1 = or var1, var2
-            // now2 = ne 0, now1
-            std::string now1 = NewTempSymbol();
-            std::string now2 = NewTempSymbol();
-            buffer += tab + now1 + " = or " + var1 + ", " + var2 + "\n";
-            buffer += tab + now2 + " = ne 0, " + now1 + "\n";
-            return now2;
-        } else {
-            std::cerr << "LOrExpAST::PrintIR: unknown kind" << std::endl;
-        }
-        return "";
-    }
+    static const ASTKind KIND = ASTKind::kOtherStmt;
+
+    OtherStmtAST() : BaseAST(KIND) {}
 };
@@ -13,6 +13,28 @@
 #include <vector>
 #include "AST.hpp"
 
+// 当前编译单元的所有 AST 结点, 子结点列表与标识符, 由 front_main 在输出 IR 后一次性释放
+Arena astArena;
+
+// 所有标识符的驻留表, lexer 返回标识符的编号
+Identifiers identifiers;
+
+// 当前编译单元的所有表达式结点, 由 front_main 在输出 IR 后一次性清空
+ExpPool expPool;
+
+// 以 expPool 中的结点 root 为根的表达式, 作为语句与初始值的子结点
+ExpAST *NewExpAST(ExpId root) {
+    auto ast = astArena.New<ExpAST>();
+    ast->root = root;
+    return ast;
+}
+
+// 常量数组在 IR 中的名字 __const_ident, 分配在 astArena 中
+const char *ConstArrayName(const char *ident) {
+    std::string name = std::string("__const_") + ident;
+    return astArena.NewString(name.data(), name.size());
+}
+
 // 用于存储符号表
 // 符号表的作用域为函数内，随着编译过程动态增加或删除
 NestedSymbolTable symbolTable;
@@ -23,6 +45,12 @@ SymbolTable globalSymbolTable;
 // 用于记录当前是否在全局作用域
 bool isGlobal = true;
 
+// 查找标识符: 先查找局部符号表, 再查找全局符号表, 都不存在时返回 nullptr
+const SymbolTable::Symbol *LookupSymbol(int name) {
+    const SymbolTable::Symbol *symbol = symbolTable.Find(name);
+    return symbol != nullptr ? symbol : globalSymbolTable.Find(name);
+}
+
 // 用于记录 if 语句的出现词序，以生成唯一的标签
 int ifCount = 0;
 
@@ -34,38 +62,42 @@ std::vector<int> nestedWhileIndex;
 
 // 声明 lexer 函数和错误处理函数
 int yylex();
-void yyerror(std::unique_ptr<BaseAST> &ast, const char *s);
+void yyerror(BaseAST *&ast, const char *s);
 
 using namespace std;
 
 %}
 
-// 定义 parser 函数和错误处理函数的附加参数, 类型为unique_ptr<BaseAST>
-%parse-param { std::unique_ptr<BaseAST> &ast }
+// 定义 parser 函数和错误处理函数的附加参数, 类型为BaseAST*, 结点由 astArena 管理
+%parse-param { BaseAST *&ast }
 
 // yylval 的定义, 我们把它定义成了一个联合体 (union)
-// 因为 token 的值有的是 string*, 有的是 int, 有的是 BastAST*
-// lexer 中用到的 str_val 和 int_val 就是在这里被定义的
+// 因为 token 的值有的是标识符的编号, 有的是 int, 有的是 BastAST*
+// lexer 中用到的 ident_val 和 int_val 就是在这里被定义的
 %union {
-    std::string *str_val;
+    int ident_val;
     int int_val;
     BaseAST *ast_val;
     BaseExpAST *expAst_val;
-    std::vector<std::unique_ptr<BaseAST> > *ast_list;
-    std::vector<std::unique_ptr<BaseExpAST> > *expAst_list;
+    ASTList *ast_list;
+    ExpASTList *expAst_list;
+    ExpId exp_id;
+    ExpIdList *expId_list;
 }
 
 // lexer 返回的所有 token 种类的声明（终结符）
-// 注意 IDENT 和 INT_CONST 会返回 token 的值, 分别对应 str_val 和 int_val
+// 注意 IDENT 和 INT_CONST 会返回 token 的值, 分别对应 ident_val 和 int_val
 %token VOID INT CONST IF ELSE WHILE BREAK CONTINUE RETURN LT GT LE GE EQ NE AND OR
-%token <str_val> IDENT
+%token <ident_val> IDENT
 %token <int_val> INT_CONST
 
 // 非终结符的类型定义, 分别对应 ast_val 和 int_val
 %type <ast_val> GlobalDef FuncDef FuncFParam Block BlockItem Decl ConstDecl ConstDef VarDecl VarDef Stmt MatchStmt UnmatchStmt OtherStmt
-%type <expAst_val> ConstInitVal ConstExp InitVal Exp PrimaryExp LVal UnaryExp MulExp AddExp RelExp EqExp LAndExp LOrExp
+%type <expAst_val> ConstInitVal ConstExp InitVal
+%type <exp_id> Exp PrimaryExp LVal UnaryExp MulExp AddExp RelExp EqExp LAndExp LOrExp
 %type <ast_list> GlobalDefs FuncFParams BlockItems ConstDefs VarDefs
-%type <expAst_list> FuncRParams ConstArrayDims ArrayDims
+%type <expAst_list> ConstArrayDims InitVals ConstInitVals
+%type <expId_list> FuncRParams ArrayDims
 %type <int_val> Number If While
 
 // 无返回类型的终结符
@@ -80,36 +112,36 @@ using namespace std;
 // $1 指代规则里第一个符号的返回值, 也就是 FuncDef 的返回值
 CompUnit
     : GlobalDefs {
-        auto compUnit = make_unique<CompUnitAST>();
-        compUnit->globalDefs = unique_ptr<vector<unique_ptr<BaseAST> > >($1);
-        ast = move(compUnit);
+        auto compUnit = astArena.New<CompUnitAST>();
+        compUnit->globalDefs = $1;
+        ast = compUnit;
     }
     ;
 
 GlobalDefs
     : GlobalDef {
-        auto ast_list = new vector<unique_ptr<BaseAST> >();
-        ast_list->push_back(unique_ptr<BaseAST>($1));
+        auto ast_list = astArena.New<ASTList>(astArena);
+        ast_list->push_back($1);
         $$ = ast_list;
     }
     | GlobalDefs GlobalDef {
-        auto ast_list = $1; // XXX 这里没用 unique_ptr
-        ast_list->push_back(unique_ptr<BaseAST>($2));
+        auto ast_list = $1;
+        ast_list->push_back($2);
         $$ = ast_list;
     }
     ;
 
 GlobalDef
     : Decl {
-        auto ast = new GlobalDefAST();
+        auto ast = astArena.New<GlobalDefAST>();
         ast->kind = GlobalDefAST::kDecl;
-        ast->decl = unique_ptr<BaseAST>($1);
+        ast->decl = $1;
         $$ = ast;
     }
     | FuncDef {
-        auto ast = new GlobalDefAST();
+        auto ast = astArena.New<GlobalDefAST>();
         ast->kind = GlobalDefAST::kFuncDef;
-        ast->funcDef = unique_ptr<BaseAST>($1);
+        ast->funcDef = $1;
         $$ = ast;
     }
     ;
@@ -120,47 +152,47 @@ GlobalDef
 // $$ 表示非终结符的返回值, 我们可以通过给这个符号赋值的方法来返回结果
 FuncDef
     : VOID IDENT '(' ')' {
-        globalSymbolTable.AddFuncSymbol(*$2, 0, 0, NULL);
+        globalSymbolTable.AddFuncSymbol($2, 0, 0, NULL);
     } Block {
-        auto ast = new FuncDefAST();
+        auto ast = astArena.New<FuncDefAST>();
         ast->funcType = 0; // 0 表示 void
-        ast->ident = *unique_ptr<string>($2);
+        ast->ident = identifiers.Name($2);
         ast->funcFParams = nullptr;
-        ast->block = unique_ptr<BaseAST>($6);
+        ast->block = $6;
 
         isGlobal = true; // 函数定义结束，全局状态设为 true
         
         $$ = ast;
     }
     | INT IDENT '(' ')' {
-        globalSymbolTable.AddFuncSymbol(*$2, 1, 0, NULL);
+        globalSymbolTable.AddFuncSymbol($2, 1, 0, NULL);
     } Block {
-        auto ast = new FuncDefAST();
+        auto ast = astArena.New<FuncDefAST>();
         ast->funcType = 1; // 1 表示 int
-        ast->ident = *unique_ptr<string>($2);
+        ast->ident = identifiers.Name($2);
         ast->funcFParams = nullptr;
-        ast->block = unique_ptr<BaseAST>($6);
+        ast->block = $6;
 
         isGlobal = true; // 函数定义结束，全局状态设为 true
         
         $$ = ast;
     }
     | VOID IDENT '(' FuncFParams ')' {
-        vector<unique_ptr<BaseAST> > *fParams = $4;
+        ASTList *fParams = $4;
 
         int fParamNum = fParams->size();
         bool *fParamIsArray = new bool[fParamNum];
         for (int i = 0; i < fParamNum; i++) {
-            auto fParam = static_cast<FuncFParamAST*>((*fParams)[i].get());
+            auto fParam = static_cast<FuncFParamAST*>((*fParams)[i]);
             fParamIsArray[i] = fParam->kind == FuncFParamAST::kIntArray;
         }
-        globalSymbolTable.AddFuncSymbol(*$2, 0, fParamNum, fParamIsArray);
+        globalSymbolTable.AddFuncSymbol($2, 0, fParamNum, fParamIsArray);
     } Block {
-        auto ast = new FuncDefAST();
+        auto ast = astArena.New<FuncDefAST>();
         ast->funcType = 0; // 0 表示 void
-        ast->ident = *unique_ptr<string>($2);
-        ast->funcFParams = unique_ptr<vector<unique_ptr<BaseAST> > >($4);
-        ast->block = unique_ptr<BaseAST>($7);
+        ast->ident = identifiers.Name($2);
+        ast->funcFParams = $4;
+        ast->block = $7;
 
         symbolTable.ClearFParamTable();
         isGlobal = true; // 函数定义结束，全局状态设为 true
@@ -168,21 +200,21 @@ FuncDef
         $$ = ast;
     }
     | INT IDENT '(' FuncFParams ')' {
-        vector<unique_ptr<BaseAST> > *fParams = $4;
+        ASTList *fParams = $4;
         
         int fParamNum = fParams->size();
         bool *fParamIsArray = new bool[fParamNum];
         for (int i = 0; i < fParamNum; i++) {
-            auto fParam = static_cast<FuncFParamAST*>((*fParams)[i].get());
+            auto fParam = static_cast<FuncFParamAST*>((*fParams)[i]);
             fParamIsArray[i] = fParam->kind == FuncFParamAST::kIntArray;
         }
-        globalSymbolTable.AddFuncSymbol(*$2, 1, fParamNum, fParamIsArray);
+        globalSymbolTable.AddFuncSymbol($2, 1, fParamNum, fParamIsArray);
     } Block {
-        auto ast = new FuncDefAST();
+        auto ast = astArena.New<FuncDefAST>();
         ast->funcType = 1; // 1 表示 int
-        ast->ident = *unique_ptr<string>($2);
-        ast->funcFParams = unique_ptr<vector<unique_ptr<BaseAST> > >($4);
-        ast->block = unique_ptr<BaseAST>($7);
+        ast->ident = identifiers.Name($2);
+        ast->funcFParams = $4;
+        ast->block = $7;
 
         symbolTable.ClearFParamTable();
         isGlobal = true; // 函数定义结束，全局状态设为 true
@@ -193,49 +225,49 @@ FuncDef
 
 FuncFParams
     : FuncFParam {
-        auto ast_list = new vector<unique_ptr<BaseAST> >();
-        ast_list->push_back(unique_ptr<BaseAST>($1));
+        auto ast_list = astArena.New<ASTList>(astArena);
+        ast_list->push_back($1);
         $$ = ast_list;
     }
     | FuncFParams ',' FuncFParam {
-        auto ast_list = $1; // XXX 这里没用 unique_ptr
-        ast_list->push_back(unique_ptr<BaseAST>($3));
+        auto ast_list = $1;
+        ast_list->push_back($3);
         $$ = ast_list;
     }
     ;
 
 FuncFParam
     : INT IDENT { // XXX BType 确定为 int
-        auto ast = new FuncFParamAST();
+        auto ast = astArena.New<FuncFParamAST>();
         ast->kind = FuncFParamAST::kInt;
         ast->bType = 0;
-        ast->ident = *unique_ptr<string>($2);
+        ast->ident = identifiers.Name($2);
 
-        symbolTable.AddFParamSymbol(ast->ident, -1, 0); // 添加函数形参符号，-1 表示是函数参数
+        symbolTable.AddFParamSymbol($2, -1, 0); // 添加函数形参符号，-1 表示是函数参数
         ast->ident += "_"; // 函数形参的标识符加上下划线，以区分全局变量
         
         $$ = ast;
     }
     | INT IDENT '[' ']' {
-        auto ast = new FuncFParamAST();
+        auto ast = astArena.New<FuncFParamAST>();
         ast->kind = FuncFParamAST::kIntArray;
         ast->bType = 0;
-        ast->ident = *unique_ptr<string>($2);
+        ast->ident = identifiers.Name($2);
         ast->constArrayDims = nullptr;
 
-        symbolTable.AddFParamSymbol(ast->ident, -2, 1); // 添加函数形参符号，-2 表示是数组类型
+        symbolTable.AddFParamSymbol($2, -2, 1); // 添加函数形参符号，-2 表示是数组类型
         ast->ident += "_"; // 函数形参的标识符加上下划线，以区分全局变量
 
         $$ = ast;
     }
     | INT IDENT '[' ']' ConstArrayDims {
-        auto ast = new FuncFParamAST();
+        auto ast = astArena.New<FuncFParamAST>();
         ast->kind = FuncFParamAST::kIntArray;
         ast->bType = 0;
-        ast->ident = *unique_ptr<string>($2);
-        ast->constArrayDims = unique_ptr<vector<unique_ptr<BaseExpAST> > >($5);
+        ast->ident = identifiers.Name($2);
+        ast->constArrayDims = $5;
 
-        symbolTable.AddFParamSymbol(ast->ident, -2, 1 + ast->constArrayDims->size()); // 添加函数形参符号，-2 表示是数组类型
+        symbolTable.AddFParamSymbol($2, -2, 1 + ast->constArrayDims->size()); // 添加函数形参符号，-2 表示是数组类型
         ast->ident += "_"; // 函数形参的标识符加上下划线，以区分全局变量
 
         $$ = ast;
@@ -245,13 +277,13 @@ FuncFParam
 // Block :== '{' BlockItems '}';
 Block
     : '{' '}' {
-        auto ast = new BlockAST();
+        auto ast = astArena.New<BlockAST>();
         ast->blockItems = nullptr;
         $$ = ast;
     }
     | BlockBeg BlockItems BlockEnd {
-        auto ast = new BlockAST();
-        ast->blockItems = unique_ptr<vector<unique_ptr<BaseAST> > >($2);
+        auto ast = astArena.New<BlockAST>();
+        ast->blockItems = $2;
         $$ = ast;
     }
     ;
@@ -278,13 +310,13 @@ BlockEnd
 // BlockItems ::= %empty | BlockItems BlockItem;
 BlockItems
     : BlockItem {
-        auto ast_list = new vector<unique_ptr<BaseAST> >();
-        ast_list->push_back(unique_ptr<BaseAST>($1));
+        auto ast_list = astArena.New<ASTList>(astArena);
+        ast_list->push_back($1);
         $$ = ast_list;
     }
     | BlockItems BlockItem {
-        auto ast_list = $1; // XXX 这里没用 unique_ptr
-        ast_list->push_back(unique_ptr<BaseAST>($2));
+        auto ast_list = $1;
+        ast_list->push_back($2);
         $$ = ast_list;
     }
     ;
@@ -292,15 +324,15 @@ BlockItems
 // BlockItem ::= Decl | Stmt;
 BlockItem
     : Decl {
-        auto ast = new BlockItemAST();
+        auto ast = astArena.New<BlockItemAST>();
         ast->kind = BlockItemAST::kDecl;
-        ast->decl = unique_ptr<BaseAST>($1);
+        ast->decl = $1;
         $$ = ast;
     }
     | Stmt {
-        auto ast = new BlockItemAST();
+        auto ast = astArena.New<BlockItemAST>();
         ast->kind = BlockItemAST::kStmt;
-        ast->stmt = unique_ptr<BaseAST>($1);
+        ast->stmt = $1;
         $$ = ast;
     }
     ;
@@ -308,15 +340,15 @@ BlockItem
 // Decl ::= ConstDecl | VarDecl;
 Decl
     : ConstDecl {
-        auto ast = new DeclAST();
+        auto ast = astArena.New<DeclAST>();
         ast->kind = DeclAST::kConstDecl;
-        ast->constDecl = unique_ptr<BaseAST>($1);
+        ast->constDecl = $1;
         $$ = ast;
     }
     | VarDecl {
-        auto ast = new DeclAST();
+        auto ast = astArena.New<DeclAST>();
         ast->kind = DeclAST::kVarDecl;
-        ast->varDecl = unique_ptr<BaseAST>($1);
+        ast->varDecl = $1;
         $$ = ast;
     }
     ;
@@ -325,9 +357,9 @@ Decl
 // (ConstDecl ::= "const" BType ConstDefs ';';)
 ConstDecl
     : CONST INT ConstDefs ';' {
-        auto ast = new ConstDeclAST();
+        auto ast = astArena.New<ConstDeclAST>();
         ast->bType = 0;
-        ast->constDefs = unique_ptr<vector<unique_ptr<BaseAST> > >($3);
+        ast->constDefs = $3;
         $$ = ast;
     }
     ;
@@ -342,49 +374,96 @@ ConstDecl
 // (ConstDefs ::= ConstDef | ConstDefs ',';)
 ConstDefs
     : ConstDef {
-        auto ast_list = new vector<unique_ptr<BaseAST> >();
-        ast_list->push_back(unique_ptr<BaseAST>($1));
+        auto ast_list = astArena.New<ASTList>(astArena);
+        ast_list->push_back($1);
         $$ = ast_list;
     }
     | ConstDefs ',' ConstDef {
-        auto ast_list = $1; // XXX 这里没用 unique_ptr
-        ast_list->push_back(unique_ptr<BaseAST>($3));
+        auto ast_list = $1;
+        ast_list->push_back($3);
         $$ = ast_list;
     }
     ;
 
-// ConstDef ::= IDENT '=' ConstInitVal;
+// ConstDef ::= IDENT '=' ConstInitVal | IDENT ConstArrayDims '=' ConstInitVal;
 ConstDef
     : IDENT '=' ConstInitVal {
-        auto ast = new ConstDefAST();
-        ast->ident = *unique_ptr<string>($1);
-        ast->constInitVal = unique_ptr<BaseExpAST>($3);
+        auto ast = astArena.New<ConstDefAST>();
+        ast->kind = ConstDefAST::kConst;
+        ast->isGlobal = isGlobal;
+        ast->ident = identifiers.Name($1);
+        ast->constInitVal = $3;
         // 将常量定义插入符号表
         if (isGlobal) {
-            globalSymbolTable.AddConstSymbol(ast->ident, ast->constInitVal->CalcConstExp());
+            globalSymbolTable.AddConstSymbol($1, ast->constInitVal->CalcConstExp());
+        } else {
+        symbolTable.AddConstSymbol($1, ast->constInitVal->CalcConstExp());
+        }
+        $$ = ast;
+    }
+    | IDENT ConstArrayDims '=' ConstInitVal {
+        auto ast = astArena.New<ConstDefAST>();
+        ast->kind = ConstDefAST::kArray;
+        ast->isGlobal = isGlobal;
+        ast->ident = identifiers.Name($1);
+        ast->constArrayDims = $2;
+        ast->constInitVal = $4;
+        // 计算出常量数组的值, 与各维长度一起插入符号表
+        ast->CalcArrayValues();
+        if (isGlobal) {
+            globalSymbolTable.AddConstArraySymbol($1, 0, ast->dims, ast->values);
+            ast->arrayName = "__const_" + ast->ident;
         } else {
-        symbolTable.AddConstSymbol(ast->ident, ast->constInitVal->CalcConstExp());
+            symbolTable.AddConstArraySymbol($1, ast->dims, ast->values);
+            ast->arrayName = "__const_" + ast->ident + "_" + to_string(symbolTable.GetVarSymbolId($1));
         }
         $$ = ast;
     }
     ;
 
-// ConstInitVal ::= ConstExp;
+// ConstInitVal ::= ConstExp | '{' [ConstInitVal {',' ConstInitVal}] '}';
 ConstInitVal
     : ConstExp {
-        auto ast = new ConstInitValAST();
-        ast->constExp = unique_ptr<BaseExpAST>($1);
+        auto ast = astArena.New<ConstInitValAST>();
+        ast->kind = ConstInitValAST::kExp;
+        ast->constExp = $1;
+        $$ = ast;
+    }
+    | '{' '}' {
+        auto ast = astArena.New<ConstInitValAST>();
+        ast->kind = ConstInitValAST::kList;
+        ast->constInitVals = astArena.New<ExpASTList>(astArena);
+        $$ = ast;
+    }
+    | '{' ConstInitVals '}' {
+        auto ast = astArena.New<ConstInitValAST>();
+        ast->kind = ConstInitValAST::kList;
+        ast->constInitVals = $2;
         $$ = ast;
     }
     ;
 
+// ConstInitVals ::= ConstInitVal | ConstInitVals ',' ConstInitVal;
+ConstInitVals
+    : ConstInitVal {
+        auto expAst_list = astArena.New<ExpASTList>(astArena);
+        expAst_list->push_back($1);
+        $$ = expAst_list;
+    }
+    | ConstInitVals ',' ConstInitVal {
+        auto expAst_list = $1;
+        expAst_list->push_back($3);
+        $$ = expAst_list;
+    }
+    ;
+
 // VarDecl ::= BType VarDef {"," VarDef} ";";
 // (VarDecl ::= BType VarDefs ';';)
 VarDecl
     : INT VarDefs ';' {
-        auto ast = new VarDeclAST();
+        auto ast = astArena.New<VarDeclAST>();
         ast->bType = 0;
-        ast->varDefs = unique_ptr<vector<unique_ptr<BaseAST> > >($2);
+        ast->varDefs = $2;
         $$ = ast;
     }
     ;
@@ -392,35 +471,35 @@ VarDecl
 // VarDefs ::= VarDef | VarDefs ',' VarDef;
 VarDefs
     : VarDef {
-        auto ast_list = new vector<unique_ptr<BaseAST> >();
-        ast_list->push_back(unique_ptr<BaseAST>($1));
+        auto ast_list = astArena.New<ASTList>(astArena);
+        ast_list->push_back($1);
         $$ = ast_list;
     }
     | VarDefs ',' VarDef {
-        auto ast_list = $1; // XXX 这里没用 unique_ptr
-        ast_list->push_back(unique_ptr<BaseAST>($3));
+        auto ast_list = $1;
+        ast_list->push_back($3);
         $$ = ast_list;
     }
     ;
 
-// VarDef ::= IDENT | IDENT '=' InitVal;
+// VarDef ::= IDENT | IDENT ConstArrayDims | IDENT ConstArrayDims '=' InitVal | IDENT '=' InitVal;
 VarDef
     : IDENT {
-        auto ast = new VarDefAST();
+        auto ast = astArena.New<VarDefAST>();
         ast->isGlobal = isGlobal;
         ast->kind = VarDefAST::kUnInit;
-        ast->ident = *unique_ptr<string>($1);
+        ast->ident = identifiers.Name($1);
 
         if (isGlobal) {
             // 将变量定义插入符号表
-            globalSymbolTable.AddVarSymbol(ast->ident, 0, 0);
+            globalSymbolTable.AddVarSymbol($1, 0, 0);
             // 全局变量名不加序号
         } else {
             // 将变量定义插入符号表
-            symbolTable.AddVarSymbol(ast->ident, 0);
+            symbolTable.AddVarSymbol($1, 0);
 
             // 变量名后面加上序号
-            int id = symbolTable.GetVarSymbolId(ast->ident);
+            int id = symbolTable.GetVarSymbolId($1);
             ast->ident += id == 0 ? "" : "_" + to_string(id); // XXX 不需要 0 了，因为全局变量不加序号，局部变量默认都加序号
                                                             // 原优化：如果序号为0，不加在变量名后面
         }
@@ -428,46 +507,69 @@ VarDef
         $$ = ast;
     }
     | IDENT ConstArrayDims {
-        auto ast = new VarDefAST();
+        auto ast = astArena.New<VarDefAST>();
         ast->isGlobal = isGlobal;
         ast->kind = VarDefAST::kArray;
-        ast->ident = *unique_ptr<string>($1);
-        ast->constArrayDims = unique_ptr<vector<unique_ptr<BaseExpAST> > >($2);
+        ast->ident = identifiers.Name($1);
+        ast->constArrayDims = $2;
 
         // TODO 没有在符号表中区分数组和变量
         if (isGlobal) {
             // 将变量定义插入符号表
-            globalSymbolTable.AddVarSymbol(ast->ident, 0, ast->constArrayDims->size());
+            globalSymbolTable.AddVarSymbol($1, 0, ast->constArrayDims->size());
             // 全局变量名不加序号
         } else {
             // 将变量定义插入符号表
-            symbolTable.AddVarSymbol(ast->ident, ast->constArrayDims->size());
+            symbolTable.AddVarSymbol($1, ast->constArrayDims->size());
 
             // 变量名后面加上序号
-            int id = symbolTable.GetVarSymbolId(ast->ident);
+            int id = symbolTable.GetVarSymbolId($1);
             ast->ident += id == 0 ? "" : "_" + to_string(id); // XXX 不需要 0 了，因为全局变量不加序号，局部变量默认都加序号
                                                               // 原优化：如果序号为0，不加在变量名后面
         }
 
         $$ = ast;
     }
+    | IDENT ConstArrayDims '=' InitVal {
+        auto ast = astArena.New<VarDefAST>();
+        ast->isGlobal = isGlobal;
+        ast->kind = VarDefAST::kArrayInit;
+        ast->ident = identifiers.Name($1);
+        ast->constArrayDims = $2;
+        ast->initVal = $4;
+
+        if (isGlobal) {
+            // 将变量定义插入符号表
+            globalSymbolTable.AddVarSymbol($1, 0, ast->constArrayDims->size());
+            // 全局变量名不加序号
+        } else {
+            // 将变量定义插入符号表
+            symbolTable.AddVarSymbol($1, ast->constArrayDims->size());
+
+            // 变量名后面加上序号
+            int id = symbolTable.GetVarSymbolId($1);
+            ast->ident += id == 0 ? "" : "_" + to_string(id);
+        }
+
+        $$ = ast;
+    }
     | IDENT '=' InitVal {
-        auto ast = new VarDefAST();
+        auto ast = astArena.New<VarDefAST>();
         ast->isGlobal = isGlobal;
         ast->kind = VarDefAST::kInit;
-        ast->ident = *unique_ptr<string>($1);
-        ast->initVal = unique_ptr<BaseExpAST>($3);
+        ast->ident = identifiers.Name($1);
+        ast->initVal = $3;
 
         if (isGlobal) {
             // 将变量定义插入符号表
-            globalSymbolTable.AddVarSymbol(ast->ident, 0, 0);
+            globalSymbolTable.AddVarSymbol($1, 0, 0);
             // 全局变量名不加序号
         } else {
             // 将变量定义插入符号表
-            symbolTable.AddVarSymbol(ast->ident, 0);
+            symbolTable.AddVarSymbol($1, 0);
             
             // 变量名后面加上序号
-            int id = symbolTable.GetVarSymbolId(ast->ident);
+            int id = symbolTable.GetVarSymbolId($1);
             ast->ident += id == 0 ? "" : "_" + to_string(id); // XXX 不需要 0 了，因为全局变量不加序号，局部变量默认都加序号
                                                               // 原优化：如果序号为0，不加在变量名后面
         }
@@ -478,38 +580,65 @@ VarDef
 
 ConstArrayDims
     : '[' ConstExp ']' {
-        auto expAst_list = new vector<unique_ptr<BaseExpAST> >();
-        expAst_list->push_back(unique_ptr<BaseExpAST>($2));
+        auto expAst_list = astArena.New<ExpASTList>(astArena);
+        expAst_list->push_back($2);
         $$ = expAst_list;
     }
     | ConstArrayDims '[' ConstExp ']' {
-        auto expAst_list = $1; // XXX 这里没用 unique_ptr
-        expAst_list->push_back(unique_ptr<BaseExpAST>($3));
+        auto expAst_list = $1;
+        expAst_list->push_back($3);
         $$ = expAst_list;
     }
     ;
 
-// InitVal ::= Exp;
+// InitVal ::= Exp | '{' [InitVal {',' InitVal}] '}';
 InitVal
     : Exp {
-        auto ast = new InitValAST();
-        ast->exp = unique_ptr<BaseExpAST>($1);
+        auto ast = astArena.New<InitValAST>();
+        ast->kind = InitValAST::kExp;
+        ast->exp = NewExpAST($1);
         $$ = ast;
     }
+    | '{' '}' {
+        auto ast = astArena.New<InitValAST>();
+        ast->kind = InitValAST::kList;
+        ast->initVals = astArena.New<ExpASTList>(astArena);
+        $$ = ast;
+    }
+    | '{' InitVals '}' {
+        auto ast = astArena.New<InitValAST>();
+        ast->kind = InitValAST::kList;
+        ast->initVals = $2;
+        $$ = ast;
+    }
+    ;
+
+// InitVals ::= InitVal | InitVals ',' InitVal;
+InitVals
+    : InitVal {
+        auto expAst_list = astArena.New<ExpASTList>(astArena);
+        expAst_list->push_back($1);
+        $$ = expAst_list;
+    }
+    | InitVals ',' InitVal {
+        auto expAst_list = $1;
+        expAst_list->push_back($3);
+        $$ = expAst_list;
+    }
     ;
 
 // Stmt ::= MatchStmt | UnmatchStmt;
 Stmt
     : MatchStmt {
-        auto ast = new StmtAST();
+        auto ast = astArena.New<StmtAST>();
         ast->kind = StmtAST::kMatch;
-        ast->matchStmt = unique_ptr<BaseAST>($1);
+        ast->matchStmt = $1;
         $$ = ast;
     }
     | UnmatchStmt {
-        auto ast = new StmtAST();
+        auto ast = astArena.New<StmtAST>();
         ast->kind = StmtAST::kUnmatch;
-        ast->unmatchStmt = unique_ptr<BaseAST>($1);
+        ast->unmatchStmt = $1;
         $$ = ast;
     }
     ;
@@ -517,18 +646,18 @@ Stmt
 // MatchStmt ::= "if" '(' Exp ')' MatchStmt "else" MatchStmt | OtherStmt;
 MatchStmt
     : If '(' Exp ')' MatchStmt ELSE MatchStmt {
-        auto ast = new MatchStmtAST();
+        auto ast = astArena.New<MatchStmtAST>();
         ast->kind = MatchStmtAST::kIf;
         ast->ifLabelIndex = $1;
-        ast->exp = unique_ptr<BaseExpAST>($3);
-        ast->matchStmt1 = unique_ptr<BaseAST>($5);
-        ast->matchStmt2 = unique_ptr<BaseAST>($7);
+        ast->exp = NewExpAST($3);
+        ast->matchStmt1 = $5;
+        ast->matchStmt2 = $7;
         $$ = ast;
     }
     | OtherStmt {
-        auto ast = new MatchStmtAST();
+        auto ast = astArena.New<MatchStmtAST>();
         ast->kind = MatchStmtAST::kOther;
-        ast->otherStmt = unique_ptr<BaseAST>($1);
+        ast->otherStmt = $1;
         $$ = ast;
     }
     ;
@@ -536,20 +665,20 @@ MatchStmt
 // UnmatchStmt ::= "if" '(' Exp ')' Stmt | "if" '(' Exp ')' MatchStmt "else" UnmatchStmt;
 UnmatchStmt
     : If '(' Exp ')' Stmt {
-        auto ast = new UnmatchStmtAST();
+        auto ast = astArena.New<UnmatchStmtAST>();
         ast->kind = UnmatchStmtAST::kNoElse;
         ast->ifLabelIndex = $1;
-        ast->exp = unique_ptr<BaseExpAST>($3);
-        ast->stmt = unique_ptr<BaseAST>($5);
+        ast->exp = NewExpAST($3);
+        ast->stmt = $5;
         $$ = ast;
     }
     | If '(' Exp ')' MatchStmt ELSE UnmatchStmt {
-        auto ast = new UnmatchStmtAST();
+        auto ast = astArena.New<UnmatchStmtAST>();
         ast->kind = UnmatchStmtAST::kElse;
         ast->ifLabelIndex = $1;
-        ast->exp = unique_ptr<BaseExpAST>($3);
-        ast->matchStmt = unique_ptr<BaseAST>($5);
-        ast->unmatchStmt = unique_ptr<BaseAST>($7);
+        ast->exp = NewExpAST($3);
+        ast->matchStmt = $5;
+        ast->unmatchStmt = $7;
         $$ = ast;
     }
     ;
@@ -565,61 +694,61 @@ If
 // (OtherStmt ::= LVal '=' Exp ';' | ';' | Exp ';' | Block | RETURN Exp ';';)
 OtherStmt
     : ';' {
-        auto ast = new OtherStmtAST();
+        auto ast = astArena.New<OtherStmtAST>();
         ast->kind = OtherStmtAST::kExp;
         ast->exp = nullptr;
         $$ = ast;
     }
     | Exp ';' {
-        auto ast = new OtherStmtAST();
+        auto ast = astArena.New<OtherStmtAST>();
         ast->kind = OtherStmtAST::kExp;
-        ast->exp = unique_ptr<BaseExpAST>($1);
+        ast->exp = NewExpAST($1);
         $$ = ast;
     }
     | LVal '=' Exp ';' {
-        auto ast = new OtherStmtAST();
+        auto ast = astArena.New<OtherStmtAST>();
         ast->kind = OtherStmtAST::kAssign;
-        ast->lVal = unique_ptr<BaseExpAST>($1);
-        ast->exp = unique_ptr<BaseExpAST>($3);
+        ast->lVal = NewExpAST($1);
+        ast->exp = NewExpAST($3);
         $$ = ast;
     }
     | While '(' Exp ')' Stmt {
-        auto ast = new OtherStmtAST();
+        auto ast = astArena.New<OtherStmtAST>();
         ast->kind = OtherStmtAST::kWhile;
         ast->whileIndex = $1;
-        ast->exp = unique_ptr<BaseExpAST>($3);
-        ast->stmt = unique_ptr<BaseAST>($5);
+        ast->exp = NewExpAST($3);
+        ast->stmt = $5;
         nestedWhileIndex.pop_back(); // 退出 while 循环，删除当前 while 的序号
         $$ = ast;
     }
     | BREAK ';' {
-        auto ast = new OtherStmtAST();
+        auto ast = astArena.New<OtherStmtAST>();
         ast->kind = OtherStmtAST::kBreak;
         ast->whileIndex = nestedWhileIndex.back(); // 跳出 while 循环，跳转到最近的 while 循环结尾，所以需要获取最近 while 的标号
         $$ = ast;
     }
     | CONTINUE ';' {
-        auto ast = new OtherStmtAST();
+        auto ast = astArena.New<OtherStmtAST>();
         ast->kind = OtherStmtAST::kContinue;
         ast->whileIndex = nestedWhileIndex.back(); // 跳出 while 循环，跳转到最近的 while 循环判断，所以需要获取最近 while 的标号
         $$ = ast;
     }
     | RETURN ';' {
-        auto ast = new OtherStmtAST();
+        auto ast = astArena.New<OtherStmtAST>();
         ast->kind = OtherStmtAST::kReturn;
         ast->exp = nullptr;
         $$ = ast;
     }
     | RETURN Exp ';' {
-        auto ast = new OtherStmtAST();
+        auto ast = astArena.New<OtherStmtAST>();
         ast->kind = OtherStmtAST::kReturn;
-        ast->exp = unique_ptr<BaseExpAST>($2);
+        ast->exp = NewExpAST($2);
         $$ = ast;
     }
     | Block {
-        auto ast = new OtherStmtAST();
+        auto ast = astArena.New<OtherStmtAST>();
         ast->kind = OtherStmtAST::kBlock;
-        ast->block = unique_ptr<BaseAST>($1);
+        ast->block = $1;
         $$ = ast;
     }
     ;
@@ -631,138 +760,116 @@ While
     }
 
 // ConstExp ::= Exp;
+// 常量表达式的值在创建 expPool 中的结点时已经算出
 ConstExp
     : Exp {
-        auto ast = new ConstExpAST();
-        ast->exp = unique_ptr<BaseExpAST>($1);
-        ast->value = ast->CalcConstExp(); // 遍历 AST，计算常量表达式的值
-        ast->isCalcuated = true;
+        auto ast = astArena.New<ConstExpAST>();
+        ast->exp = $1;
+        if (!expPool[$1].isConst) {
+            std::cerr << "error: ConstExp is not a const" << std::endl;
+        }
+        ast->value = expPool[$1].value;
         $$ = ast;
     }
     ;
 
+// 以下的表达式不对应 AST, 返回 expPool 中结点的下标, 只有运算才产生结点
 // Exp ::= LOrExp;
 Exp
     : LOrExp {
-        auto ast = new ExpAST();
-        ast->lOrExp = unique_ptr<BaseExpAST>($1);
-        $$ = ast;
+        $$ = $1;
     }
     ;
 
 // PrimaryExp ::= '(' Exp ')' | LVal | Number;
 PrimaryExp
     : '(' Exp ')' {
-        auto ast = new PrimaryExpAST();
-        ast->kind = PrimaryExpAST::kExp;
-        ast->exp = unique_ptr<BaseExpAST>($2);
-        $$ = ast;
+        $$ = $2;
     }
     | LVal {
-        auto ast = new PrimaryExpAST();
-        ast->kind = PrimaryExpAST::kLVal;
-        ast->lVal = unique_ptr<BaseExpAST>($1);
-        $$ = ast;
+        $$ = $1;
     }
     | Number {
-        auto ast = new PrimaryExpAST();
-        ast->kind = PrimaryExpAST::kNumber;
-        ast->number = $1;
-        $$ = ast;
+        $$ = expPool.Literal($1);
     }
     ;
 
-// LVal ::= IDENT;
-// 不对应 AST, 直接返回 IDENT 的值
+// LVal ::= IDENT {'[' Exp ']'};
+// 在符号表中查找标识符, 常量在创建结点时直接得到值
 LVal
     : IDENT {
-        auto ast = new LValAST();
-        ast->ident = *unique_ptr<string>($1);
-
-        // 先查找局部标识符
-        if (symbolTable.HasSymbol(ast->ident)) {
-            if (symbolTable.GetSymbolType(ast->ident) == SymbolTable::Symbol::kConst) {
-                ast->kind = LValAST::kConst;
-                ast->identVal = symbolTable.GetConstSymbolValue(ast->ident);
-                ast->isArrayPtr = false;
-            } else
-            if (symbolTable.GetSymbolType(ast->ident) == SymbolTable::Symbol::kVar) {
-                ast->kind = LValAST::kVar;
-                ast->identVal = symbolTable.GetVarSymbolId(ast->ident);
-                ast->isArrayPtr = symbolTable.GetVarSymbolDim(ast->ident) > 0;
-            } else {
-                std::cerr << "LVal: unknown symbol type" << std::endl;
-            }
+        ExpRef ref{ExpRef::kVar, false, false, 0, identifiers.Name($1)};
+        const std::vector<int> *constDims = nullptr, *constVals = nullptr;
+
+        // 先查找局部标识符, 再查找全局标识符
+        const SymbolTable::Symbol *symbol = LookupSymbol($1);
+        if (symbol == nullptr) {
+            std::cerr << "error: " << ref.ident << " is not defined" << std::endl;
+        } else
+        if (symbol->type == SymbolTable::Symbol::kConst) {
+            ref.kind = ExpRef::kConst;
+            ref.identVal = symbol->val.const_val;
         } else
-        // 再查找全局标识符
-        if (globalSymbolTable.HasSymbol(ast->ident)) {
-            if (globalSymbolTable.GetSymbolType(ast->ident) == SymbolTable::Symbol::kConst) {
-                ast->kind = LValAST::kConst;
-                ast->identVal = globalSymbolTable.GetConstSymbolValue(ast->ident);
-                ast->isArrayPtr = false;
-            } else
-            if (globalSymbolTable.GetSymbolType(ast->ident) == SymbolTable::Symbol::kVar) {
-                ast->kind = LValAST::kVar;
-                ast->identVal = globalSymbolTable.GetVarSymbolId(ast->ident);
-                ast->isArrayPtr = globalSymbolTable.GetVarSymbolDim(ast->ident) > 0;
-            } else {
-                std::cerr << "LVal: unknown symbol type" << std::endl;
-            }
+        if (symbol->type == SymbolTable::Symbol::kVar) {
+            ref.identVal = symbol->val.var_val.var_id;
+            ref.isArrayPtr = symbol->val.var_val.var_dim > 0;
+        } else
+        if (symbol->type == SymbolTable::Symbol::kConstArray) {
+            // 常量数组整体只能作为数组指针使用
+            ref.identVal = symbol->val.var_val.var_id;
+            ref.isArrayPtr = true;
+            ref.isConstArray = true;
+            ref.ident = ConstArrayName(ref.ident);
+            constDims = &symbol->const_array_dims;
+            constVals = symbol->const_array_vals.get();
         } else {
-            std::cerr << "error: " << ast->ident << " is not defined" << std::endl;
+            std::cerr << "LVal: unknown symbol type" << std::endl;
         }
-        
-        $$ = ast;
+
+        $$ = expPool.Ref(ref, nullptr, constDims, constVals);
     }
     | IDENT ArrayDims {
-        auto ast = new LValAST();
-        ast->kind = LValAST::kArray;
-        ast->ident = *unique_ptr<string>($1);
-        ast->arrayDims = unique_ptr<vector<unique_ptr<BaseExpAST> > >($2);
-        ast->isArrayPtr = false;
-
-        // XXX 目前数组只有变量
-        // 先查找局部标识符
-        if (symbolTable.HasSymbol(ast->ident)) {
-            if (symbolTable.GetSymbolType(ast->ident) == SymbolTable::Symbol::kConst) {
-                ast->identVal = symbolTable.GetConstSymbolValue(ast->ident);
-            } else
-            if (symbolTable.GetSymbolType(ast->ident) == SymbolTable::Symbol::kVar) {
-                ast->identVal = symbolTable.GetVarSymbolId(ast->ident);
-                ast->isArrayPtr = symbolTable.GetVarSymbolDim(ast->ident) > ast->arrayDims->size();
-            } else {
-                std::cerr << "LVal: unknown symbol type" << std::endl;
-            }
+        ExpRef ref{ExpRef::kArray, false, false, 0, identifiers.Name($1)};
+        const std::vector<int> *constDims = nullptr, *constVals = nullptr;
+
+        // 先查找局部标识符, 再查找全局标识符
+        const SymbolTable::Symbol *symbol = LookupSymbol($1);
+        if (symbol == nullptr) {
+            std::cerr << "error: " << ref.ident << " is not defined" << std::endl;
+        } else
+        if (symbol->type == SymbolTable::Symbol::kConst) {
+            ref.identVal = symbol->val.const_val;
         } else
-        // 再查找全局标识符
-        if (globalSymbolTable.HasSymbol(ast->ident)) {
-            if (globalSymbolTable.GetSymbolType(ast->ident) == SymbolTable::Symbol::kConst) {
-                ast->identVal = globalSymbolTable.GetConstSymbolValue(ast->ident);
-            } else
-            if (globalSymbolTable.GetSymbolType(ast->ident) == SymbolTable::Symbol::kVar) {
-                ast->identVal = globalSymbolTable.GetVarSymbolId(ast->ident);
-                ast->isArrayPtr = globalSymbolTable.GetVarSymbolDim(ast->ident) > ast->arrayDims->size();
-            } else {
-                std::cerr << "LVal: unknown symbol type" << std::endl;
-            }
+        if (symbol->type == SymbolTable::Symbol::kVar) {
+            ref.identVal = symbol->val.var_val.var_id;
+            ref.isArrayPtr = symbol->val.var_val.var_dim > (int)$2->size();
+        } else
+        if (symbol->type == SymbolTable::Symbol::kConstArray) {
+            // 下标都是常量时在编译时求值, 否则访问 .rodata 中的 @__const_ident
+            ref.identVal = symbol->val.var_val.var_id;
+            ref.isArrayPtr = symbol->val.var_val.var_dim > (int)$2->size();
+            ref.isConstArray = true;
+            ref.ident = ConstArrayName(ref.ident);
+            constDims = &symbol->const_array_dims;
+            constVals = symbol->const_array_vals.get();
         } else {
-            std::cerr << "error: " << ast->ident << " is not defined" << std::endl;
+            std::cerr << "LVal: unknown symbol type" << std::endl;
         }
 
-        $$ = ast;
+        $$ = expPool.Ref(ref, $2, constDims, constVals);
     }
     ;
 
 ArrayDims
     : '[' Exp ']' {
-        auto expAst_list = new vector<unique_ptr<BaseExpAST> >();
-        expAst_list->push_back(unique_ptr<BaseExpAST>($2));
-        $$ = expAst_list;
+        auto expId_list = astArena.New<ExpIdList>(astArena);
+        expId_list->push_back($2);
+        $$ = expId_list;
     }
     | ArrayDims '[' Exp ']' {
-        auto expAst_list = $1; // XXX 这里没用 unique_ptr
-        expAst_list->push_back(unique_ptr<BaseExpAST>($3));
-        $$ = expAst_list;
+        auto expId_list = $1;
+        expId_list->push_back($3);
+        $$ = expId_list;
     }
     ;
 
@@ -774,221 +881,125 @@ Number
     }
     ;
 
-// UnaryExp ::= PrimaryExp | '+' UnaryExp | '-' UnaryExp | '!' UnaryExp;
+// UnaryExp ::= PrimaryExp | IDENT '(' [FuncRParams] ')' | ('+' | '-' | '!') UnaryExp;
 UnaryExp
-    : PrimaryExp{
-        auto ast = new UnaryExpAST();
-        ast->kind = UnaryExpAST::kPrimaryExp;
-        ast->primaryExp = unique_ptr<BaseExpAST>($1);
-        $$ = ast;
+    : PrimaryExp {
+        $$ = $1;
     }
     | IDENT '(' ')' {
-        auto ast = new UnaryExpAST();
-        ast->kind = UnaryExpAST::kCall;
-        ast->ident = *unique_ptr<string>($1);
-        ast->funcType = globalSymbolTable.GetFuncSymbolType(ast->ident);
-        ast->funcFParamNum = 0;
-        ast->funcFParamIsArray = NULL;
-        ast->funcRParams = nullptr;
-        $$ = ast;
+        $$ = expPool.Call(identifiers.Name($1), globalSymbolTable.GetFuncSymbolType($1), nullptr);
     }
     | IDENT '(' FuncRParams ')' {
-        auto ast = new UnaryExpAST();
-        ast->kind = UnaryExpAST::kCall;
-        ast->ident = *unique_ptr<string>($1);
-        ast->funcType = globalSymbolTable.GetFuncSymbolType(ast->ident);
-        ast->funcFParamNum = globalSymbolTable.GetFuncSymbolFParamNum(ast->ident);
-        ast->funcFParamIsArray = globalSymbolTable.GetFuncSymbolFParamIsArray(ast->ident);
-        ast->funcRParams = unique_ptr<vector<unique_ptr<BaseExpAST> > >($3);
-        $$ = ast;
+        $$ = expPool.Call(identifiers.Name($1), globalSymbolTable.GetFuncSymbolType($1), $3);
     }
-    | '+' UnaryExp{
-        auto ast = new UnaryExpAST();
-        ast->kind = UnaryExpAST::kPositive;
-        ast->unaryExp = unique_ptr<BaseExpAST>($2);
-        $$ = ast;
+    | '+' UnaryExp {
+        $$ = expPool.Unary(ExpNode::kPos, $2);
     }
-    | '-' UnaryExp{
-        auto ast = new UnaryExpAST();
-        ast->kind = UnaryExpAST::kNegative;
-        ast->unaryExp = unique_ptr<BaseExpAST>($2);
-        $$ = ast;
+    | '-' UnaryExp {
+        $$ = expPool.Unary(ExpNode::kNeg, $2);
     }
-    | '!' UnaryExp{
-        auto ast = new UnaryExpAST();
-        ast->kind = UnaryExpAST::kNot;
-        ast->unaryExp = unique_ptr<BaseExpAST>($2);
-        $$ = ast;
+    | '!' UnaryExp {
+        $$ = expPool.Unary(ExpNode::kNot, $2);
     }
     ;
 
 FuncRParams
     : Exp {
-        auto expAst_list = new vector<unique_ptr<BaseExpAST> >();
-        expAst_list->push_back(unique_ptr<BaseExpAST>($1));
-        $$ = expAst_list;
+        auto expId_list = astArena.New<ExpIdList>(astArena);
+        expId_list->push_back($1);
+        $$ = expId_list;
     }
     | FuncRParams ',' Exp {
-        auto expAst_list = $1; // XXX 这里没用 unique_ptr
-        expAst_list->push_back(unique_ptr<BaseExpAST>($3));
-        $$ = expAst_list;
+        auto expId_list = $1;
+        expId_list->push_back($3);
+        $$ = expId_list;
     }
     ;
 
 // MulExp ::= UnaryExp | MulExp ('*' | '/' | '%') UnaryExp;
 MulExp
     : UnaryExp {
-        auto ast = new MulExpAST();
-        ast->kind = MulExpAST::kUnaryExp;
-        ast->unaryExp = unique_ptr<BaseExpAST>($1);
-        $$ = ast;
+        $$ = $1;
     }
     | MulExp '*' UnaryExp {
-        auto ast = new MulExpAST();
-        ast->kind = MulExpAST::kMul;
-        ast->mulExp = unique_ptr<BaseExpAST>($1);
-        ast->unaryExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kMul, $1, $3);
     }
     | MulExp '/' UnaryExp {
-        auto ast = new MulExpAST();
-        ast->kind = MulExpAST::kDiv;
-        ast->mulExp = unique_ptr<BaseExpAST>($1);
-        ast->unaryExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kDiv, $1, $3);
     }
     | MulExp '%' UnaryExp {
-        auto ast = new MulExpAST();
-        ast->kind = MulExpAST::kMod;
-        ast->mulExp = unique_ptr<BaseExpAST>($1);
-        ast->unaryExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kMod, $1, $3);
     }
     ;
 
 // AddExp ::= MulExp | AddExp ('+' | '-') MulExp;
 AddExp
     : MulExp {
-        auto ast = new AddExpAST();
-        ast->kind = AddExpAST::kMulExp;
-        ast->mulExp = unique_ptr<BaseExpAST>($1);
-        $$ = ast;
+        $$ = $1;
     }
     | AddExp '+' MulExp {
-        auto ast = new AddExpAST();
-        ast->kind = AddExpAST::kAdd;
-        ast->addExp = unique_ptr<BaseExpAST>($1);
-        ast->mulExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kAdd, $1, $3);
     }
     | AddExp '-' MulExp {
-        auto ast = new AddExpAST();
-        ast->kind = AddExpAST::kSub;
-        ast->addExp = unique_ptr<BaseExpAST>($1);
-        ast->mulExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kSub, $1, $3);
     }
     ;
 
 // RelExp ::= AddExp | RelExp ('<' | '>' | '<=' | '>=') AddExp;
 RelExp
     : AddExp {
-        auto ast = new RelExpAST();
-        ast->kind = RelExpAST::kAddExp;
-        ast->addExp = unique_ptr<BaseExpAST>($1);
-        $$ = ast;
+        $$ = $1;
     }
     | RelExp LT AddExp {
-        auto ast = new RelExpAST();
-        ast->kind = RelExpAST::kLT;
-        ast->relExp = unique_ptr<BaseExpAST>($1);
-        ast->addExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kLT, $1, $3);
     }
     | RelExp GT AddExp {
-        auto ast = new RelExpAST();
-        ast->kind = RelExpAST::kGT;
-        ast->relExp = unique_ptr<BaseExpAST>($1);
-        ast->addExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kGT, $1, $3);
     }
     | RelExp LE AddExp {
-        auto ast = new RelExpAST();
-        ast->kind = RelExpAST::kLE;
-        ast->relExp = unique_ptr<BaseExpAST>($1);
-        ast->addExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kLE, $1, $3);
     }
     | RelExp GE AddExp {
-        auto ast = new RelExpAST();
-        ast->kind = RelExpAST::kGE;
-        ast->relExp = unique_ptr<BaseExpAST>($1);
-        ast->addExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kGE, $1, $3);
     }
     ;
 
 // EqExp ::= RelExp | EqExp ('==' | '!=') Rel;
 EqExp
     : RelExp {
-        auto ast = new EqExpAST();
-        ast->kind = EqExpAST::kRelExp;
-        ast->relExp = unique_ptr<BaseExpAST>($1);
-        $$ = ast;
+        $$ = $1;
     }
     | EqExp EQ RelExp {
-        auto ast = new EqExpAST();
-        ast->kind = EqExpAST::kEQ;
-        ast->eqExp = unique_ptr<BaseExpAST>($1);
-        ast->relExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kEQ, $1, $3);
     }
     | EqExp NE RelExp {
-        auto ast = new EqExpAST();
-        ast->kind = EqExpAST::kNE;
-        ast->eqExp = unique_ptr<BaseExpAST>($1);
-        ast->relExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kNE, $1, $3);
     }
     ;
 
 // LAndExp ::= EqExp | LAndExp '&&' EqExp;
 LAndExp
     : EqExp {
-        auto ast = new LAndExpAST();
-        ast->kind = LAndExpAST::kEqExp;
-        ast->eqExp = unique_ptr<BaseExpAST>($1);
-        $$ = ast;
+        $$ = $1;
     }
     | LAndExp AND EqExp {
-        auto ast = new LAndExpAST();
-        ast->kind = LAndExpAST::kAnd;
-        ast->lAndExp = unique_ptr<BaseExpAST>($1);
-        ast->eqExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kAnd, $1, $3);
     }
     ;
 
 // LOrExp ::= LAndExp | LOrExp '||' LAndExp;
 LOrExp
     : LAndExp {
-        auto ast = new LOrExpAST();
-        ast->kind = LOrExpAST::kLAndExp;
-        ast->lAndExp = unique_ptr<BaseExpAST>($1);
-        $$ = ast;
+        $$ = $1;
     }
     | LOrExp OR LAndExp {
-        auto ast = new LOrExpAST();
-        ast->kind = LOrExpAST::kOr;
-        ast->lOrExp = unique_ptr<BaseExpAST>($1);
-        ast->lAndExp = unique_ptr<BaseExpAST>($3);
-        $$ = ast;
+        $$ = expPool.Binary(ExpNode::kOr, $1, $3);
     }
     ;
 %%
 
 // 定义错误处理函数, 其中第二个参数是错误信息
 // parser 如果发生错误 (例如输入的程序出现了语法错误), 就会调用这个函数
-void yyerror(unique_ptr<BaseAST> &ast, const char *s) {
+void yyerror(BaseAST *&ast, const char *s) {
     cerr << "error: " << s << endl;
 }
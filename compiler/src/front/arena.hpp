@@ -0,0 +1,129 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+#include <vector>
+#include <type_traits>
+
+// bump-pointer 分配器: 一个编译单元的所有 AST 结点, 子结点列表与标识符都分配在其中
+// 分配只移动指针, 结点按创建的顺序连续存放; 不能单独释放, 由 Clear 一次性析构并释放全部内存
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+    ~Arena() {
+        Clear();
+    }
+
+    // 分配 size 字节, 按 align 对齐, 不初始化
+    void *Alloc(size_t size, size_t align = alignof(std::max_align_t)) {
+        size_t offset = (used + align - 1) & ~(align - 1);
+        if (chunks.empty() || offset + size > capacity) {
+            // 超过块大小一半的对象单独分配一块, 不浪费当前块的剩余空间
+            if (size > CHUNK_SIZE / 2) return NewChunk(size, false);
+            NewChunk(CHUNK_SIZE, true);
+            offset = 0;
+        }
+        used = offset + size;
+        return chunks.back() + offset;
+    }
+
+    // 在 arena 中构造对象, 有非平凡析构函数的对象在 Clear 时按创建的逆序析构
+    template <typename T, typename... Args>
+    T *New(Args &&... args) {
+        if (std::is_trivially_destructible<T>::value) {
+            return new (Alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        }
+        auto node = static_cast<DtorNode *>(Alloc(sizeof(DtorNode), alignof(DtorNode)));
+        T *object = new (Alloc(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+        node->object = object;
+        node->dtor = [](void *p) { static_cast<T *>(p)->~T(); };
+        node->next = dtors;
+        dtors = node;
+        return object;
+    }
+
+    // 复制长度为 len 的字符串, 以 '\0' 结尾
+    const char *NewString(const char *str, size_t len) {
+        char *ret = static_cast<char *>(Alloc(len + 1, 1));
+        memcpy(ret, str, len);
+        ret[len] = '\0';
+        return ret;
+    }
+
+    // 析构所有对象并释放全部内存
+    void Clear() {
+        for (DtorNode *node = dtors; node != nullptr; node = node->next) node->dtor(node->object);
+        dtors = nullptr;
+        for (char *chunk : chunks) free(chunk);
+        chunks.clear();
+        used = capacity = 0;
+    }
+
+private:
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    struct DtorNode {
+        void *object;
+        void (*dtor)(void *);
+        DtorNode *next;
+    };
+
+    std::vector<char *> chunks;     // 最后一块为当前分配的块
+    size_t used = 0;                // 当前块中已使用的字节数
+    size_t capacity = 0;            // 当前块的大小
+    DtorNode *dtors = nullptr;      // 需要析构的对象, 最后创建的在最前
+
+    // current 为 false 时, 新块放在当前块之前, 当前块继续用于分配
+    char *NewChunk(size_t size, bool current) {
+        char *chunk = static_cast<char *>(malloc(size));
+        if (chunk == nullptr) throw std::bad_alloc();
+        if (current || chunks.empty()) {
+            chunks.push_back(chunk);
+            used = current ? 0 : size;
+            capacity = size;
+        } else {
+            chunks.insert(chunks.end() - 1, chunk);
+        }
+        return chunk;
+    }
+};
+
+// 在 arena 中分配空间的 STL 分配器, deallocate 不做任何操作
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator(Arena &arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U> &other) : arena(other.arena) {}
+
+    T *allocate(size_t n) {
+        return static_cast<T *>(arena->Alloc(n * sizeof(T), alignof(T)));
+    }
+    void deallocate(T *, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U> &other) const {
+        return arena == other.arena;
+    }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U> &other) const {
+        return arena != other.arena;
+    }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+    Arena *arena;
+};
+
+// 元素存放在 arena 中的 vector
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T> >;
+
+// 当前编译单元的 AST 与标识符所在的 arena, 定义在 SysY.y 中
+extern Arena astArena;
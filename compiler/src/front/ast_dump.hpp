@@ -0,0 +1,332 @@
+#pragma once
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "ast_visitor.hpp"
+
+// 以文本形式输出 AST (-dump-ast), 边遍历边写入文件
+// 缩进由 dumper 记录, 不需要为每一层拼接子树的字符串, 输出的大小与 AST 的深度无关
+//   FuncDefAST {
+//       ident: main
+//       block: BlockAST {
+//           ...
+//       }
+//   }
+class ASTDumper : public ASTVisitor<ASTDumper> {
+public:
+    using ASTVisitor<ASTDumper>::Visit;
+
+    explicit ASTDumper(FILE *file) : file(file) {}
+
+    void Dump(const BaseAST *ast) {
+        if (ast == nullptr) {
+            Write("NULL\n");
+        } else {
+            Visit(ast);
+        }
+    }
+
+    void Visit(const CompUnitAST &ast) {
+        Begin("CompUnitAST");
+        List("globalDefs", ast.globalDefs);
+        End();
+    }
+
+    void Visit(const GlobalDefAST &ast) {
+        Begin("GlobalDefAST");
+        if (ast.kind == GlobalDefAST::kFuncDef) {
+            Child("funcDef", ast.funcDef);
+        } else {
+            Child("decl", ast.decl);
+        }
+        End();
+    }
+
+    void Visit(const FuncDefAST &ast) {
+        Begin("FuncDefAST");
+        Field("funcType", ast.funcType == 0 ? "void" : "int");
+        Field("ident", ast.ident);
+        List("funcFParams", ast.funcFParams);
+        Child("block", ast.block);
+        End();
+    }
+
+    void Visit(const FuncFParamAST &ast) {
+        Begin("FuncFParamAST");
+        Field("kind", ast.kind == FuncFParamAST::kInt ? "int" : "intArray");
+        Field("ident", ast.ident);
+        if (ast.kind == FuncFParamAST::kIntArray) List("constArrayDims", ast.constArrayDims);
+        End();
+    }
+
+    void Visit(const BlockAST &ast) {
+        Begin("BlockAST");
+        List("blockItems", ast.blockItems);
+        End();
+    }
+
+    void Visit(const BlockItemAST &ast) {
+        Begin("BlockItemAST");
+        if (ast.kind == BlockItemAST::kDecl) {
+            Child("decl", ast.decl);
+        } else {
+            Child("stmt", ast.stmt);
+        }
+        End();
+    }
+
+    void Visit(const DeclAST &ast) {
+        Begin("DeclAST");
+        if (ast.kind == DeclAST::kConstDecl) {
+            Child("constDecl", ast.constDecl);
+        } else {
+            Child("varDecl", ast.varDecl);
+        }
+        End();
+    }
+
+    void Visit(const ConstDeclAST &ast) {
+        Begin("ConstDeclAST");
+        Field("bType", "int");
+        List("constDefs", ast.constDefs);
+        End();
+    }
+
+    void Visit(const ConstInitValAST &ast) {
+        Begin("ConstInitValAST");
+        if (ast.kind == ConstInitValAST::kExp) {
+            Child("constExp", ast.constExp);
+        } else {
+            List("constInitVals", ast.constInitVals);
+        }
+        End();
+    }
+
+    void Visit(const ConstDefAST &ast) {
+        Begin("ConstDefAST");
+        Field("ident", ast.ident);
+        if (ast.kind == ConstDefAST::kArray) List("constArrayDims", ast.constArrayDims);
+        Child("constInitVal", ast.constInitVal);
+        End();
+    }
+
+    void Visit(const VarDeclAST &ast) {
+        Begin("VarDeclAST");
+        Field("bType", "int");
+        List("varDefs", ast.varDefs);
+        End();
+    }
+
+    void Visit(const InitValAST &ast) {
+        Begin("InitValAST");
+        if (ast.kind == InitValAST::kExp) {
+            Child("exp", ast.exp);
+        } else {
+            List("initVals", ast.initVals);
+        }
+        End();
+    }
+
+    void Visit(const VarDefAST &ast) {
+        static const char *kinds[] = {"unInit", "array", "init", "arrayInit"};
+        Begin("VarDefAST");
+        Field("ident", ast.ident);
+        Field("kind", kinds[ast.kind]);
+        if (ast.kind == VarDefAST::kArray || ast.kind == VarDefAST::kArrayInit) List("constArrayDims", ast.constArrayDims);
+        if (ast.kind == VarDefAST::kInit || ast.kind == VarDefAST::kArrayInit) Child("initVal", ast.initVal);
+        End();
+    }
+
+    void Visit(const StmtAST &ast) {
+        Begin("StmtAST");
+        if (ast.kind == StmtAST::kMatch) {
+            Child("matchStmt", ast.matchStmt);
+        } else {
+            Child("unmatchStmt", ast.unmatchStmt);
+        }
+        End();
+    }
+
+    void Visit(const MatchStmtAST &ast) {
+        Begin("MatchStmtAST");
+        if (ast.kind == MatchStmtAST::kIf) {
+            Field("kind", "if");
+            Child("exp", ast.exp);
+            Child("matchStmt1", ast.matchStmt1);
+            Child("matchStmt2", ast.matchStmt2);
+        } else {
+            Field("kind", "other");
+            Child("otherStmt", ast.otherStmt);
+        }
+        End();
+    }
+
+    void Visit(const UnmatchStmtAST &ast) {
+        Begin("UnmatchStmtAST");
+        if (ast.kind == UnmatchStmtAST::kNoElse) {
+            Field("kind", "noElse");
+            Child("exp", ast.exp);
+            Child("stmt", ast.stmt);
+        } else {
+            Field("kind", "else");
+            Child("exp", ast.exp);
+            Child("matchStmt", ast.matchStmt);
+            Child("unmatchStmt", ast.unmatchStmt);
+        }
+        End();
+    }
+
+    void Visit(const OtherStmtAST &ast) {
+        static const char *kinds[] = {"exp", "assign", "return", "while", "break", "continue", "block"};
+        Begin("OtherStmtAST");
+        Field("kind", kinds[ast.kind]);
+        switch (ast.kind) {
+        case OtherStmtAST::kAssign:
+            Child("lVal", ast.lVal);
+            Child("exp", ast.exp);
+            break;
+        case OtherStmtAST::kExp:
+        case OtherStmtAST::kReturn:
+            Child("exp", ast.exp);
+            break;
+        case OtherStmtAST::kWhile:
+            Field("whileIndex", ast.whileIndex);
+            Child("exp", ast.exp);
+            Child("stmt", ast.stmt);
+            break;
+        case OtherStmtAST::kBreak:
+        case OtherStmtAST::kContinue:
+            Field("whileIndex", ast.whileIndex);
+            break;
+        case OtherStmtAST::kBlock:
+            Child("block", ast.block);
+            break;
+        }
+        End();
+    }
+
+    void Visit(const ConstExpAST &ast) {
+        Begin("ConstExpAST");
+        Field("value", ast.value);
+        Exp("exp", ast.exp);
+        End();
+    }
+
+    void Visit(const ExpAST &ast) {
+        Begin("ExpAST");
+        Exp("root", ast.root);
+        End();
+    }
+
+private:
+    FILE *file;
+    int depth = 0;
+
+    void Write(const char *str) {
+        fputs(str, file);
+    }
+    void Write(const std::string &str) {
+        fwrite(str.data(), 1, str.size(), file);
+    }
+    void Write(int value) {
+        fprintf(file, "%d", value);
+    }
+
+    void Indent() {
+        for (int i = 0; i < depth; i++) fputc('\t', file);
+    }
+
+    // 结点的开头接在 "key: " 之后, 不需要缩进
+    void Begin(const char *name) {
+        Write(name);
+        Write(" {\n");
+        depth++;
+    }
+    void End() {
+        depth--;
+        Indent();
+        Write("}\n");
+    }
+
+    template <typename T>
+    void Field(const char *key, const T &value) {
+        Indent();
+        Write(key);
+        Write(": ");
+        Write(value);
+        Write("\n");
+    }
+
+    void Child(const char *key, const BaseAST *ast) {
+        Indent();
+        Write(key);
+        Write(": ");
+        Dump(ast);
+    }
+
+    template <typename T>
+    void List(const char *key, const ArenaVector<T *> *list) {
+        Indent();
+        Write(key);
+        if (list == nullptr) {
+            Write(": NULL\n");
+            return;
+        }
+        Write(": [\n");
+        depth++;
+        for (auto &ast : *list) {
+            Indent();
+            Dump(ast);
+        }
+        depth--;
+        Indent();
+        Write("]\n");
+    }
+
+    // expPool 中以 id 为根的表达式
+    void Exp(const char *key, ExpId id) {
+        static const char *ops[] = {
+            "", "+", "-", "!",
+            "*", "/", "%", "+", "-",
+            "<", ">", "<=", ">=", "==", "!=",
+            "&&", "||",
+        };
+        const ExpNode &node = expPool[id];
+        Indent();
+        Write(key);
+        Write(": ");
+        switch (node.kind) {
+        case ExpNode::kLiteral:
+            Begin("Literal");
+            Field("value", node.value);
+            break;
+        case ExpNode::kRef: {
+            const ExpRef &ref = expPool.refs[node.lhs];
+            Begin("Ref");
+            Field("ident", ref.ident);
+            if (ref.kind == ExpRef::kConst) Field("const", ref.identVal);
+            for (uint32_t i = 0; i < ref.dimCount; i++) Exp("dim", expPool.Dim(ref, i));
+            break;
+        }
+        case ExpNode::kUnary:
+            Begin("UnaryExpr");
+            Field("op", ops[node.op]);
+            Exp("operand", node.lhs);
+            break;
+        case ExpNode::kBinary:
+            Begin("BinaryExpr");
+            Field("op", ops[node.op]);
+            Exp("lhs", node.lhs);
+            Exp("rhs", node.rhs);
+            break;
+        case ExpNode::kCall: {
+            const ExpCall &call = expPool.calls[node.lhs];
+            Begin("Call");
+            Field("ident", call.ident);
+            for (uint32_t i = 0; i < call.argCount; i++) Exp("arg", expPool.Arg(call, i));
+            break;
+        }
+        }
+        End();
+    }
+};
@@ -0,0 +1,167 @@
+#pragma once
+#include <iostream>
+#include <type_traits>
+#include "AST.hpp"
+
+// 对 ast 的每个非空子结点依次调用 f, 顺序与源代码中的顺序相同
+template <typename F>
+void ForEachChild(const BaseAST *ast, F &&f) {
+    auto child = [&](const BaseAST *node) {
+        if (node != nullptr) f(node);
+    };
+    auto list = [&](const auto *nodes) {
+        if (nodes == nullptr) return;
+        for (auto node : *nodes) child(node);
+    };
+
+    switch (ast->astKind) {
+    case ASTKind::kCompUnit: {
+        auto &node = static_cast<const CompUnitAST &>(*ast);
+        list(node.globalDefs);
+        break;
+    }
+    case ASTKind::kGlobalDef: {
+        auto &node = static_cast<const GlobalDefAST &>(*ast);
+        child(node.funcDef);
+        child(node.decl);
+        break;
+    }
+    case ASTKind::kFuncDef: {
+        auto &node = static_cast<const FuncDefAST &>(*ast);
+        list(node.funcFParams);
+        child(node.block);
+        break;
+    }
+    case ASTKind::kFuncFParam: {
+        list(static_cast<const FuncFParamAST &>(*ast).constArrayDims);
+        break;
+    }
+    case ASTKind::kBlock: {
+        list(static_cast<const BlockAST &>(*ast).blockItems);
+        break;
+    }
+    case ASTKind::kBlockItem: {
+        auto &node = static_cast<const BlockItemAST &>(*ast);
+        child(node.decl);
+        child(node.stmt);
+        break;
+    }
+    case ASTKind::kDecl: {
+        auto &node = static_cast<const DeclAST &>(*ast);
+        child(node.constDecl);
+        child(node.varDecl);
+        break;
+    }
+    case ASTKind::kConstDecl: {
+        list(static_cast<const ConstDeclAST &>(*ast).constDefs);
+        break;
+    }
+    case ASTKind::kConstInitVal: {
+        auto &node = static_cast<const ConstInitValAST &>(*ast);
+        child(node.constExp);
+        list(node.constInitVals);
+        break;
+    }
+    case ASTKind::kConstDef: {
+        auto &node = static_cast<const ConstDefAST &>(*ast);
+        list(node.constArrayDims);
+        child(node.constInitVal);
+        break;
+    }
+    case ASTKind::kVarDecl: {
+        list(static_cast<const VarDeclAST &>(*ast).varDefs);
+        break;
+    }
+    case ASTKind::kInitVal: {
+        auto &node = static_cast<const InitValAST &>(*ast);
+        child(node.exp);
+        list(node.initVals);
+        break;
+    }
+    case ASTKind::kVarDef: {
+        auto &node = static_cast<const VarDefAST &>(*ast);
+        list(node.constArrayDims);
+        child(node.initVal);
+        break;
+    }
+    case ASTKind::kStmt: {
+        auto &node = static_cast<const StmtAST &>(*ast);
+        child(node.matchStmt);
+        child(node.unmatchStmt);
+        break;
+    }
+    case ASTKind::kMatchStmt: {
+        auto &node = static_cast<const MatchStmtAST &>(*ast);
+        child(node.exp);
+        child(node.matchStmt1);
+        child(node.matchStmt2);
+        child(node.otherStmt);
+        break;
+    }
+    case ASTKind::kUnmatchStmt: {
+        auto &node = static_cast<const UnmatchStmtAST &>(*ast);
+        child(node.exp);
+        child(node.stmt);
+        child(node.matchStmt);
+        child(node.unmatchStmt);
+        break;
+    }
+    case ASTKind::kOtherStmt: {
+        auto &node = static_cast<const OtherStmtAST &>(*ast);
+        child(node.lVal);
+        child(node.exp);
+        child(node.stmt);
+        child(node.block);
+        break;
+    }
+    case ASTKind::kConstExp:
+    case ASTKind::kExp:
+        // 表达式的结点在 expPool 中, 不是 AST 结点
+        break;
+    }
+}
+
+// AST 的访问者 (CRTP): 按结点的 astKind switch, 直接调用 Derived 中对应类型的 Visit, 没有虚函数调用
+// 新的分析或翻译写成一个 Derived 类即可, 不需要修改结点类:
+//   class Counter : public ASTVisitor<Counter> {
+//   public:
+//       using ASTVisitor<Counter>::Visit;
+//       int loops = 0;
+//       void Visit(const OtherStmtAST &ast) {
+//           if (ast.kind == OtherStmtAST::kWhile) loops++;
+//           VisitChildren(ast);
+//       }
+//   };
+// Derived 中没有定义 Visit 的结点类型, 默认访问其所有子结点并返回 Ret()
+template <typename Derived, typename Ret = void>
+class ASTVisitor {
+public:
+    Ret Visit(const BaseAST *ast) {
+        switch (ast->astKind) {
+#define AST_VISIT_CASE(Name) \
+        case ASTKind::k##Name: \
+            return Self().Visit(static_cast<const Name##AST &>(*ast));
+        AST_NODE_LIST(AST_VISIT_CASE)
+#undef AST_VISIT_CASE
+        }
+        std::cerr << "ASTVisitor::Visit: unknown kind" << std::endl;
+        return Ret();
+    }
+
+    template <typename T, typename = typename std::enable_if<std::is_base_of<BaseAST, T>::value>::type>
+    Ret Visit(const T &ast) {
+        VisitChildren(ast);
+        return Ret();
+    }
+
+    void VisitChildren(const BaseAST &ast) {
+        ForEachChild(&ast, [this](const BaseAST *child) {
+            Self().Visit(child);
+        });
+    }
+
+protected:
+    Derived &Self() {
+        return static_cast<Derived &>(*this);
+    }
+};
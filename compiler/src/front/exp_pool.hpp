@@ -0,0 +1,179 @@
+#pragma once
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+#include "arena.hpp"
+
+// 表达式结点在 ExpPool 中的下标
+using ExpId = uint32_t;
+
+// 语法分析时收集的表达式列表 (数组下标, 函数实参), 创建结点时复制到 ExpPool::operands 中
+using ExpIdList = ArenaVector<ExpId>;
+
+// 扁平化的表达式结点, 一个结点 16 字节
+// 语法中 LOrExp -> LAndExp -> ... -> PrimaryExp 的每一层不再对应一个结点, 只有真正的运算才产生结点
+struct ExpNode {
+    enum Kind : uint8_t {
+        kLiteral,   // 整数字面量
+        kRef,       // 变量/常量/数组元素 (LVal), lhs 为 ExpPool::refs 的下标
+        kUnary,     // 单目运算, lhs 为操作数
+        kBinary,    // 双目运算, lhs 与 rhs 为两个操作数
+        kCall,      // 函数调用, lhs 为 ExpPool::calls 的下标
+    };
+    enum Op : uint8_t {
+        kNone,
+        kPos, kNeg, kNot,
+        kMul, kDiv, kMod, kAdd, kSub,
+        kLT, kGT, kLE, kGE, kEQ, kNE,
+        kAnd, kOr,
+    };
+
+    Kind kind;
+    Op op;
+    bool isConst;   // 是否可以在编译时求值 (只由常量和字面量组成)
+    int value;      // isConst 时为表达式的值
+    ExpId lhs, rhs;
+};
+
+// 变量引用 (LVal) 的附加信息
+struct ExpRef {
+    enum Kind : uint8_t {
+        kConst,
+        kVar,
+        kArray      // 带下标的访问
+    };
+
+    Kind kind;
+    bool isArrayPtr;        // 结果是否是数组指针 (下标个数少于数组的维数)
+    bool isConstArray;      // 是否是常量数组, 运行时访问时需要输出 .rodata 中的定义
+    int identVal;           // 标识符在符号表中的值: 常量的值, 变量的编号, 或 -1/-2 表示形参
+    const char *ident;      // 变量名, 常量数组带有 __const_ 前缀
+    uint32_t dimBegin = 0;  // 下标在 ExpPool::operands 中的位置
+    uint32_t dimCount = 0;
+};
+
+// 函数调用的附加信息
+struct ExpCall {
+    const char *ident;
+    int funcType;           // 0 表示 void, 1 表示 int
+    uint32_t argBegin;      // 实参在 ExpPool::operands 中的位置
+    uint32_t argCount;
+};
+
+// 当前编译单元的所有表达式, 结点连续存放, 以 32 位下标互相引用
+// 常量表达式的值在创建结点时自底向上算出, 之后不需要再遍历子树
+class ExpPool {
+public:
+    std::vector<ExpNode> nodes;
+    std::vector<ExpRef> refs;
+    std::vector<ExpCall> calls;
+    std::vector<ExpId> operands;
+
+    const ExpNode &operator[](ExpId id) const {
+        return nodes[id];
+    }
+
+    // 变量引用的第 i 个下标, 函数调用的第 i 个实参
+    ExpId Dim(const ExpRef &ref, uint32_t i) const {
+        return operands[ref.dimBegin + i];
+    }
+    ExpId Arg(const ExpCall &call, uint32_t i) const {
+        return operands[call.argBegin + i];
+    }
+
+    ExpId Literal(int value) {
+        return Add(ExpNode{ExpNode::kLiteral, ExpNode::kNone, true, value, 0, 0});
+    }
+
+    ExpId Unary(ExpNode::Op op, ExpId operand) {
+        const ExpNode &x = nodes[operand];
+        int value = 0;
+        if (x.isConst) {
+            // 取负按无符号数计算, -INT_MIN 不溢出
+            value = op == ExpNode::kNeg ? (int)(0u - (unsigned)x.value) : op == ExpNode::kNot ? !x.value : x.value;
+        }
+        return Add(ExpNode{ExpNode::kUnary, op, x.isConst, value, operand, 0});
+    }
+
+    ExpId Binary(ExpNode::Op op, ExpId lhs, ExpId rhs) {
+        const ExpNode &x = nodes[lhs], &y = nodes[rhs];
+        // 除数为 0 与 INT_MIN / -1 时留到运行时处理, 编译器本身不能因此崩溃
+        bool isDiv = op == ExpNode::kDiv || op == ExpNode::kMod;
+        bool isConst = x.isConst && y.isConst && !(isDiv && (y.value == 0 || (x.value == INT_MIN && y.value == -1)));
+        int value = isConst ? Calc(op, x.value, y.value) : 0;
+        return Add(ExpNode{ExpNode::kBinary, op, isConst, value, lhs, rhs});
+    }
+
+    // 常量数组给出 constDims 与 constVals, 下标都是常量且没有越界时在编译时求值
+    ExpId Ref(ExpRef ref, const ExpIdList *dims, const std::vector<int> *constDims, const std::vector<int> *constVals) {
+        bool isConst = ref.kind == ExpRef::kConst;
+        int value = isConst ? ref.identVal : 0;
+        if (dims != nullptr) {
+            ref.dimBegin = operands.size();
+            ref.dimCount = dims->size();
+            operands.insert(operands.end(), dims->begin(), dims->end());
+        }
+        if (ref.kind == ExpRef::kArray && constVals != nullptr && ref.dimCount == constDims->size()) {
+            size_t index = 0;
+            isConst = true;
+            for (size_t i = 0; i < constDims->size() && isConst; i++) {
+                const ExpNode &dim = nodes[(*dims)[i]];
+                isConst = dim.isConst && dim.value >= 0 && dim.value < (*constDims)[i];
+                index = index * (*constDims)[i] + dim.value;
+            }
+            if (isConst) value = (*constVals)[index];
+        }
+        refs.push_back(ref);
+        return Add(ExpNode{ExpNode::kRef, ExpNode::kNone, isConst, value, (ExpId)refs.size() - 1, 0});
+    }
+
+    ExpId Call(const char *ident, int funcType, const ExpIdList *args) {
+        ExpCall call{ident, funcType, (uint32_t)operands.size(), 0};
+        if (args != nullptr) {
+            call.argCount = args->size();
+            operands.insert(operands.end(), args->begin(), args->end());
+        }
+        calls.push_back(call);
+        return Add(ExpNode{ExpNode::kCall, ExpNode::kNone, false, 0, (ExpId)calls.size() - 1, 0});
+    }
+
+    void Clear() {
+        nodes.clear();
+        refs.clear();
+        calls.clear();
+        operands.clear();
+    }
+
+private:
+    ExpId Add(const ExpNode &node) {
+        nodes.push_back(node);
+        return nodes.size() - 1;
+    }
+
+    // 加减乘按无符号数计算, 溢出时回绕, 与运行时的结果相同
+    static int Calc(ExpNode::Op op, int x, int y) {
+        unsigned ux = x, uy = y;
+        switch (op) {
+        case ExpNode::kMul: return ux * uy;
+        case ExpNode::kDiv: return x / y;
+        case ExpNode::kMod: return x % y;
+        case ExpNode::kAdd: return ux + uy;
+        case ExpNode::kSub: return ux - uy;
+        case ExpNode::kLT: return x < y;
+        case ExpNode::kGT: return x > y;
+        case ExpNode::kLE: return x <= y;
+        case ExpNode::kGE: return x >= y;
+        case ExpNode::kEQ: return x == y;
+        case ExpNode::kNE: return x != y;
+        case ExpNode::kAnd: return x && y;
+        case ExpNode::kOr: return x || y;
+        default:
+            std::cerr << "ExpPool::Calc: unknown op" << std::endl;
+            return 0;
+        }
+    }
+};
+
+// 当前编译单元的表达式, 定义在 SysY.y 中
+extern ExpPool expPool;
@@ -5,66 +5,94 @@ std::string AddLibraryFunction() {
 
     bool *isFParamArray;
 
-    globalSymbolTable.AddFuncSymbol("getint", 1, 0, NULL); // decl @getint(): i32
+    globalSymbolTable.AddFuncSymbol(identifiers.Intern("getint"), 1, 0, NULL); // decl @getint(): i32
     decls += "decl @getint(): i32\n";
     
-    globalSymbolTable.AddFuncSymbol("getch", 1, 0, NULL); // decl @getch(): i32
+    globalSymbolTable.AddFuncSymbol(identifiers.Intern("getch"), 1, 0, NULL); // decl @getch(): i32
     decls += "decl @getch(): i32\n";
     
     isFParamArray = new bool[1];
     isFParamArray[0] = true;
-    globalSymbolTable.AddFuncSymbol("getarray", 1, 1, isFParamArray); // decl @getarray(*i32): i32
+    globalSymbolTable.AddFuncSymbol(identifiers.Intern("getarray"), 1, 1, isFParamArray); // decl @getarray(*i32): i32
     decls += "decl @getarray(*i32): i32\n";
     
     isFParamArray = new bool[1];
     isFParamArray[0] = false;
-    globalSymbolTable.AddFuncSymbol("putint", 0, 1, isFParamArray); // decl @putint(i32)
+    globalSymbolTable.AddFuncSymbol(identifiers.Intern("putint"), 0, 1, isFParamArray); // decl @putint(i32)
     decls += "decl @putint(i32)\n";
     
     isFParamArray = new bool[1];
     isFParamArray[0] = false;
-    globalSymbolTable.AddFuncSymbol("putch", 0, 1, isFParamArray); // decl @putch(i32)
+    globalSymbolTable.AddFuncSymbol(identifiers.Intern("putch"), 0, 1, isFParamArray); // decl @putch(i32)
     decls += "decl @putch(i32)\n";
     
     isFParamArray = new bool[2];
     isFParamArray[0] = false;
     isFParamArray[1] = true;
-    globalSymbolTable.AddFuncSymbol("putarray", 0, 1, isFParamArray); // decl @putarray(i32, *i32)
+    globalSymbolTable.AddFuncSymbol(identifiers.Intern("putarray"), 0, 1, isFParamArray); // decl @putarray(i32, *i32)
     decls += "decl @putarray(i32, *i32)\n";
     
-    globalSymbolTable.AddFuncSymbol("starttime", 0, 0, NULL); // decl @starttime()
+    globalSymbolTable.AddFuncSymbol(identifiers.Intern("starttime"), 0, 0, NULL); // decl @starttime()
     decls += "decl @starttime()\n";
     
-    globalSymbolTable.AddFuncSymbol("stoptime", 0, 0, NULL); // decl @stoptime()
+    globalSymbolTable.AddFuncSymbol(identifiers.Intern("stoptime"), 0, 0, NULL); // decl @stoptime()
     decls += "decl @stoptime()\n";
 
     return decls;
 }
 
-void front_main(const char input[], const char output[]){
-    // freopen(output, "w", stdout);
+// 解析输入文件, 返回 AST, 库函数的声明放入 libraryFunctionDecls
+static BaseAST *ParseInput(const char input[], std::string &libraryFunctionDecls) {
+    // 临时变量与标号从 0 开始编号, 清空上一次编译留下的定义
+    BaseAST::ResetIRState();
 
-    // 打开输入文件, 并且指定 lexer 在解析的时候读取这个文件
-    yyin = fopen(input, "r");
-    assert(yyin);
+    // 打开输入文件, 并且指定 lexer 在解析的时候读取这个文件 (映射到内存)
+    OpenLexerInput(input);
 
     // 在 parse 之前, 添加库函数
-    std::string libraryFunctionDecls = AddLibraryFunction();
+    libraryFunctionDecls = AddLibraryFunction();
 
     // 调用 parser 函数, parser 函数会进一步调用 lexer 解析输入文件的
-    unique_ptr<BaseAST> ast;
+    BaseAST *ast = nullptr;
     auto ret = yyparse(ast);
     assert(!ret);
+    CloseLexerInput();
+    return ast;
+}
 
-    // AST树
-    // cout << "front:\n" << ast->PrintAST("");
+// 一次性释放所有 AST 结点, 表达式与标识符
+static void FreeAST() {
+    expPool.Clear();
+    identifiers.Clear();
+    astArena.Clear();
+}
+
+void front_main(const char input[], const char output[]){
+    std::string libraryFunctionDecls;
+    BaseAST *ast = ParseInput(input, libraryFunctionDecls);
 
     // IR树
-    std::string IRTree;
-    // cout << "front:\n";
-    ast->PrintIR("", IRTree);
+    IRWriter IRTree;
+    IRLowering(IRTree).Visit(ast);
+
+    FILE *fout = fopen(output, "w");
+    assert(fout);
+    fputs(libraryFunctionDecls.c_str(), fout);
+    fputs(BaseAST::TopLevelDefs().c_str(), fout); // 生成 IR 时产生的运行时库函数声明与全局数组
+    IRTree.WriteTo(fout);
+    fclose(fout);
+
+    FreeAST();
+}
+
+void front_dump_ast(const char input[], const char output[]){
+    std::string libraryFunctionDecls;
+    BaseAST *ast = ParseInput(input, libraryFunctionDecls);
+
+    FILE *fout = fopen(output, "w");
+    assert(fout);
+    ASTDumper(fout).Dump(ast);
+    fclose(fout);
 
-    ofstream fout(output);
-    fout << libraryFunctionDecls;
-    fout << IRTree;
+    FreeAST();
 }
@@ -6,15 +6,20 @@
 #include <fstream>
 #include <string>
 #include "AST.hpp"
+#include "ast_dump.hpp"
+#include "ir_lowering.hpp"
+#include "lexer.hpp"
 
 using namespace std;
 
-// 声明 lexer 的输入, 以及 parser 函数
-extern FILE *yyin;
-extern int yyparse(unique_ptr<BaseAST> &ast);
+// 声明 parser 函数, lexer 的输入由 OpenLexerInput 打开
+extern int yyparse(BaseAST *&ast);
 
 // 全局符号表，用于在 parse 前添加库函数
 extern SymbolTable globalSymbolTable;
 
 void front_main(const char input[], const char output[]);
 
+// 只做语法分析, 把 AST 以文本形式输出到 output
+void front_dump_ast(const char input[], const char output[]);
+
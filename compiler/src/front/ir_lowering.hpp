@@ -0,0 +1,389 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ast_visitor.hpp"
+
+// 把语句, 声明与定义翻译为 Koopa IR, 写入 out
+// 表达式的结点在 expPool 中, 由 BaseExpAST 的 PrintValueIR/PrintCondIR 翻译
+// Visit 的返回值为语句的结尾: "return"/"break"/"continue" 表示基本块已经结束, 之后不能再加 jump
+class IRLowering : public ASTVisitor<IRLowering, std::string> {
+public:
+    using ASTVisitor<IRLowering, std::string>::Visit;
+
+    // 局部数组的元素个数不超过该值时, 逐个 store 所有元素, 便于中端把数组拆分为标量
+    static const int INIT_STORE_MAX = 16;
+    // 非 0 常量元素至少有这么多个时, 从只读的模板中复制, 否则先清零再只 store 非 0 的元素
+    static const int INIT_TEMPLATE_MIN = 8;
+
+    explicit IRLowering(IRWriter &out) : out(out) {}
+
+    std::string Visit(const CompUnitAST &ast) {
+        for (auto &globalDef : *ast.globalDefs) Visit(globalDef);
+        return "";
+    }
+
+    std::string Visit(const GlobalDefAST &ast) {
+        Visit(ast.kind == GlobalDefAST::kFuncDef ? ast.funcDef : ast.decl);
+        return "";
+    }
+
+    /**
+    *   翻译为:
+    *   fun @IDENT (): [FuncType]{
+    *       [Block]
+    *   }
+    */
+    std::string Visit(const FuncDefAST &ast) {
+        std::string funcEntryLabel = "\%entry_" + ast.ident;
+        std::vector<const FuncFParamAST *> params;
+        std::vector<std::string> paramTypes;
+
+        // 函数的头部（函数名）
+        out.Line() << "fun @" << ast.ident << "(";
+
+        // 函数的参数
+        if (ast.funcFParams != nullptr) {
+            for (auto &funcFParam : *ast.funcFParams) {
+                if (!params.empty()) out << ", ";
+                params.push_back(static_cast<const FuncFParamAST *>(funcFParam));
+                paramTypes.push_back(Visit(funcFParam));
+            }
+        }
+
+        // 函数的类型
+        out << ")";
+        if (ast.funcType == 1) {
+            out << ": i32";
+        } else
+        if (ast.funcType != 0) {
+            std::cerr << "IRLowering: unknown funcType of " << ast.ident << std::endl;
+        }
+        out << " {\n";
+
+        // 函数的入口
+        out << funcEntryLabel << ":\n";
+
+        // 形参保存到栈上
+        for (size_t i = 0; i < params.size(); i++) {
+            out.Line() << "\t\%" << params[i]->ident << "fParam = alloc " << paramTypes[i] << "\n";
+            out.Line() << "\tstore @" << params[i]->ident << ", \%" << params[i]->ident << "fParam\n";
+        }
+
+        // 函数的代码块
+        out.Indent();
+        std::string blockRet = Visit(ast.block);
+        out.Dedent();
+        // void 函数没有 return 语句，需要手动加上 ret
+        // int 函数如果没有 return 语句，不会自动加 ret 0
+        if (ast.funcType == 0 && blockRet != "return") {
+            out.Line() << "\tret\n";
+        }
+
+        // 函数结尾
+        out.Line() << "}\n";
+        return "";
+    }
+
+    // 输出 @ident: type, 返回参数的类型
+    std::string Visit(const FuncFParamAST &ast) {
+        std::string type = "i32";
+        if (ast.kind == FuncFParamAST::kIntArray) {
+            type = "*";
+            if (ast.constArrayDims == nullptr) {
+                type += "i32";
+            } else {
+                type.append(ast.constArrayDims->size(), '[');
+                type += "i32";
+                for (auto it = ast.constArrayDims->rbegin(); it != ast.constArrayDims->rend(); it++) {
+                    type += ", " + std::to_string((*it)->CalcConstExp()) + "]";
+                }
+            }
+        }
+        out << "@" << ast.ident << ": " << type; // XXX bType 目前只有 int
+        return type;
+    }
+
+    std::string Visit(const BlockAST &ast) {
+        if (ast.blockItems == nullptr) {
+            return "";
+        }
+        std::string ret;
+        for (auto &blockItem : *ast.blockItems) {
+            ret = Visit(blockItem);
+            // 如果是 return、break、continue 语句，提前返回
+            if (EndsBlock(ret)) break;
+        }
+        return ret; // 返回最后一个语句的返回值，可能是 return、break、continue
+    }
+
+    std::string Visit(const BlockItemAST &ast) {
+        return Visit(ast.kind == BlockItemAST::kDecl ? ast.decl : ast.stmt); // 可能会返回 "return"
+    }
+
+    std::string Visit(const DeclAST &ast) {
+        Visit(ast.kind == DeclAST::kConstDecl ? ast.constDecl : ast.varDecl);
+        return "";
+    }
+
+    std::string Visit(const ConstDeclAST &ast) {
+        // 标量常量的定义不需要产生IR, 常量数组需要登记定义
+        for (auto &constDef : *ast.constDefs) Visit(constDef);
+        return "";
+    }
+
+    std::string Visit(const ConstDefAST &ast) {
+        // 常量数组只登记定义, 有不能在编译时求值的访问时 (见 ExpAST::PrintRefIR) 才放入 .rodata
+        if (ast.kind == ConstDefAST::kArray) {
+            BaseAST::ReadOnlyGlobals().insert(ast.arrayName);
+            BaseAST::ConstArrayDefs()[ast.arrayName] = "global @" + ast.arrayName + " = alloc " + BaseAST::ArrayType(ast.dims) + ", " + BaseAST::ArrayInit(ast.dims, *ast.values) + "\n";
+        }
+        return "";
+    }
+
+    std::string Visit(const VarDeclAST &ast) {
+        for (auto &varDef : *ast.varDefs) Visit(varDef);
+        return "";
+    }
+
+    std::string Visit(const VarDefAST &ast) {
+        const std::string &ident = ast.ident;
+        switch (ast.kind) {
+        case VarDefAST::kUnInit:
+            if (ast.isGlobal) {
+                out.Line() << "global @" << ident << " = alloc i32, zeroinit\n";
+            } else {
+                out.Line() << "@" << ident << " = alloc i32\n";
+            }
+            break;
+        case VarDefAST::kArray:
+            out.Line() << (ast.isGlobal ? "global @" : "@") << ident << " = alloc ";
+            // 输出 constArrayDims 个数个 '['
+            out.Repeat('[', ast.constArrayDims->size()) << "i32";
+            for (auto it = ast.constArrayDims->rbegin(); it != ast.constArrayDims->rend(); it++) {
+                Value dim = (*it)->PrintValueIR(out);
+                out << ", " << dim << "]";
+            }
+            out << (ast.isGlobal ? ", zeroinit\n" : "\n"); // 局部变量不初始化
+            break;
+        case VarDefAST::kInit:
+            if (ast.isGlobal) {
+                // XXX 没有检查initVal是否是常量
+                Value var = ast.initVal->PrintValueIR(out);
+                out.Line() << "global @" << ident << " = alloc i32, " << var << "\n";
+            } else {
+                out.Line() << "@" << ident << " = alloc i32\n";
+                Value var = ast.initVal->PrintValueIR(out);
+                out.Line() << "store " << var << ", @" << ident << "\n";
+            }
+            break;
+        case VarDefAST::kArrayInit: {
+            std::vector<int> dims;
+            for (auto &constArrayDim : *ast.constArrayDims) dims.push_back(constArrayDim->CalcConstExp());
+            size_t total = 1;
+            for (int dim : dims) total *= dim;
+            std::vector<const BaseExpAST *> elems(total, nullptr);
+            auto initVal = static_cast<const InitValAST *>(ast.initVal);
+            if (initVal->kind == InitValAST::kList) {
+                initVal->Flatten(dims, 0, 0, elems);
+            } else {
+                std::cerr << "IRLowering: array " << ident << " must be initialized by an init list" << std::endl;
+            }
+            if (ast.isGlobal) {
+                PrintGlobalArrayInit(ident, dims, elems);
+            } else {
+                PrintLocalArrayInit(ident, dims, elems);
+            }
+            break;
+        }
+        }
+        return "";
+    }
+
+    std::string Visit(const StmtAST &ast) {
+        return Visit(ast.kind == StmtAST::kMatch ? ast.matchStmt : ast.unmatchStmt);
+    }
+
+    std::string Visit(const MatchStmtAST &ast) {
+        if (ast.kind == MatchStmtAST::kOther) {
+            return Visit(ast.otherStmt);
+        }
+        Value thenLabel = BaseAST::StmtLabel("then", ast.ifLabelIndex);
+        Value elseLabel = BaseAST::StmtLabel("else", ast.ifLabelIndex);
+        Value ifEndLabel = BaseAST::StmtLabel("if_end", ast.ifLabelIndex);
+
+        // if 的条件判断部分
+        ast.exp->PrintCondIR(out, thenLabel, elseLabel);
+        // if 语句的 if 分支
+        out << thenLabel << ":\n";
+        Branch(ast.matchStmt1, ifEndLabel);
+        // if 语句的 else 分支
+        out << elseLabel << ":\n";
+        Branch(ast.matchStmt2, ifEndLabel);
+        // if 语句之后的内容（的标号）
+        out << ifEndLabel << ":\n";
+        return "";
+    }
+
+    std::string Visit(const UnmatchStmtAST &ast) {
+        Value thenLabel = BaseAST::StmtLabel("then", ast.ifLabelIndex);
+        Value ifEndLabel = BaseAST::StmtLabel("if_end", ast.ifLabelIndex);
+        if (ast.kind == UnmatchStmtAST::kNoElse) {
+            // if 的条件判断部分
+            ast.exp->PrintCondIR(out, thenLabel, ifEndLabel);
+            // if 语句的 if 分支
+            out << thenLabel << ":\n";
+            Branch(ast.stmt, ifEndLabel);
+        } else {
+            Value elseLabel = BaseAST::StmtLabel("else", ast.ifLabelIndex);
+            // if 的条件判断部分
+            ast.exp->PrintCondIR(out, thenLabel, elseLabel);
+            // if 语句的 if 分支
+            out << thenLabel << ":\n";
+            Branch(ast.matchStmt, ifEndLabel);
+            // if 语句的 else 分支
+            out << elseLabel << ":\n";
+            Visit(ast.unmatchStmt); // UnmatchStmt 不会以 return 结尾，一定会跳转，所以不需要判断返回值
+            out.Line() << "jump " << ifEndLabel << "\n";
+        }
+        // if 语句之后的内容（的标号）
+        out << ifEndLabel << ":\n";
+        return "";
+    }
+
+    std::string Visit(const OtherStmtAST &ast) {
+        switch (ast.kind) {
+        case OtherStmtAST::kExp:
+            if (ast.exp != nullptr) ast.exp->PrintValueIR(out);
+            return "";
+        // Exp
+        // store var, @lVal
+        case OtherStmtAST::kAssign: {
+            Value var = ast.exp->PrintValueIR(out);
+            Value lValName = ast.lVal->PrintAddrIR(out);
+            out.Line() << "store " << var << ", " << lValName << "\n";
+            return "";
+        }
+        case OtherStmtAST::kWhile: {
+            Value whileEntryLabel = BaseAST::StmtLabel("while_entry", ast.whileIndex);
+            Value whileBodyLabel = BaseAST::StmtLabel("while_body", ast.whileIndex);
+            Value whileEndLabel = BaseAST::StmtLabel("while_end", ast.whileIndex);
+
+            // while 循环的入口
+            out.Line() << "jump " << whileEntryLabel << "\n";
+            out << whileEntryLabel << ":\n";
+            ast.exp->PrintCondIR(out, whileBodyLabel, whileEndLabel);
+            // while 循环的循环体
+            out << whileBodyLabel << ":\n";
+            Branch(ast.stmt, whileEntryLabel);
+            // while 循环的结尾
+            out << whileEndLabel << ":\n";
+            return "";
+        }
+        case OtherStmtAST::kBreak:
+            out.Line() << "jump " << BaseAST::StmtLabel("while_end", ast.whileIndex) << "\n";
+            return "break"; // 该基本块以 break 语句结尾，语句块结尾不能加 br、jump 等
+        case OtherStmtAST::kContinue:
+            out.Line() << "jump " << BaseAST::StmtLabel("while_entry", ast.whileIndex) << "\n";
+            return "continue"; // 该基本块以 continue 语句结尾，语句块结尾不能加 br、jump 等
+        // Exp
+        // ret var
+        case OtherStmtAST::kReturn:
+            if (ast.exp == nullptr) {
+                out.Line() << "ret\n";
+            } else {
+                Value retVar = ast.exp->PrintValueIR(out);
+                out.Line() << "ret " << retVar << "\n";
+            }
+            return "return"; // 该基本块以 return 语句结尾，语句块结尾不能加 br、jump 等
+        case OtherStmtAST::kBlock:
+            return Visit(ast.block);
+        }
+        return "";
+    }
+
+private:
+    IRWriter &out;
+
+    // 语句的结尾是否已经离开了当前基本块
+    static bool EndsBlock(const std::string &ret) {
+        return ret == "return" || ret == "break" || ret == "continue";
+    }
+
+    // 分支 (if 的两个分支, while 的循环体): 没有以 return/break/continue 结尾时跳转到 target
+    void Branch(const BaseAST *stmt, const Value &target) {
+        if (!EndsBlock(Visit(stmt))) {
+            out.Line() << "jump " << target << "\n";
+        }
+    }
+
+    // 元素的常量值, 没有给出的元素为 0
+    static int ElemValue(const BaseExpAST *elem) {
+        return elem == nullptr ? 0 : elem->CalcConstExp();
+    }
+
+    // 展开后下标为 index 的元素的指针: 每一维一条 getelemptr
+    Value ElemPtr(const Value &array, const std::vector<int> &dims, size_t index) {
+        Value ptr = array;
+        size_t stride = 1;
+        for (int dim : dims) stride *= dim;
+        for (int dim : dims) {
+            stride /= dim;
+            Value now = BaseAST::NewPtrSymbol();
+            out.Line() << now << " = getelemptr " << ptr << ", " << index / stride % dim << "\n";
+            ptr = now;
+        }
+        return ptr;
+    }
+
+    // 全局数组: 初始值必须是常量
+    void PrintGlobalArrayInit(const std::string &ident, const std::vector<int> &dims, const std::vector<const BaseExpAST *> &elems) {
+        std::vector<int> values;
+        for (auto elem : elems) {
+            if (elem != nullptr && !elem->IsConstExp()) {
+                std::cerr << "IRLowering: initializer of global array " << ident << " is not a const" << std::endl;
+            }
+            values.push_back(ElemValue(elem));
+        }
+        out.Line() << "global @" << ident << " = alloc " << BaseAST::ArrayType(dims) << ", " << BaseAST::ArrayInit(dims, values) << "\n";
+    }
+
+    // 局部数组: 小数组逐个 store 所有元素
+    // 大数组先整体初始化 (非 0 常量较多时从只读模板 @__const_<ident>__init 复制, 否则清零), 再 store 剩下的元素
+    void PrintLocalArrayInit(const std::string &ident, const std::vector<int> &dims, const std::vector<const BaseExpAST *> &elems) {
+        Value array = Value::Var(ident.c_str());
+        out.Line() << array << " = alloc " << BaseAST::ArrayType(dims) << "\n";
+
+        int constCount = 0;
+        for (auto elem : elems) {
+            if (elem != nullptr && elem->IsConstExp() && elem->CalcConstExp() != 0) constCount++;
+        }
+        bool storeAll = elems.size() <= (size_t)INIT_STORE_MAX;
+        bool useTemplate = !storeAll && constCount >= INIT_TEMPLATE_MIN;
+        if (useTemplate) {
+            std::vector<int> values;
+            for (auto elem : elems) values.push_back(elem != nullptr && elem->IsConstExp() ? ElemValue(elem) : 0);
+            std::string name = "__const_" + ident + "__init";
+            BaseAST::ReadOnlyGlobals().insert(name);
+            BaseAST::AddTopLevelDef("global @" + name + " = alloc " + BaseAST::ArrayType(dims) + ", " + BaseAST::Aggregate(dims, 0, 0, values) + "\n");
+            BaseAST::AddTopLevelDef("decl @__memcpy_i32(*i32, *i32, i32)\n");
+            Value dst = ElemPtr(array, dims, 0);
+            Value src = ElemPtr(Value::Var(name.c_str()), dims, 0);
+            out.Line() << "call @__memcpy_i32(" << dst << ", " << src << ", " << elems.size() << ")\n";
+        } else
+        if (!storeAll) {
+            BaseAST::AddTopLevelDef("decl @__memset_i32(*i32, i32, i32)\n");
+            Value dst = ElemPtr(array, dims, 0);
+            out.Line() << "call @__memset_i32(" << dst << ", 0, " << elems.size() << ")\n";
+        }
+
+        for (size_t i = 0; i < elems.size(); i++) {
+            auto elem = elems[i];
+            bool isConst = elem == nullptr || elem->IsConstExp();
+            if (!storeAll && isConst && (useTemplate || ElemValue(elem) == 0)) continue;
+            Value var = isConst ? Value::Const(ElemValue(elem)) : elem->PrintValueIR(out);
+            Value ptr = ElemPtr(array, dims, i);
+            out.Line() << "store " << var << ", " << ptr << "\n";
+        }
+    }
+};
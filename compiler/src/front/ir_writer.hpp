@@ -0,0 +1,103 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+// 生成 IR 的输出
+// 文本追加到固定大小的块中, 写满后换一个新块, 已写入的内容不会因为扩容而复制
+// 整数直接转换为文本, 不产生临时字符串; 缩进由 writer 记录, 不需要在递归中传递
+class IRWriter {
+public:
+    IRWriter() {
+        NewChunk();
+    }
+    IRWriter(const IRWriter &) = delete;
+    IRWriter &operator=(const IRWriter &) = delete;
+
+    void Write(const char *str, size_t len) {
+        while (len > 0) {
+            if (used == CHUNK_SIZE) NewChunk();
+            size_t n = std::min(len, CHUNK_SIZE - used);
+            memcpy(chunks.back().get() + used, str, n);
+            used += n;
+            str += n;
+            len -= n;
+        }
+    }
+
+    IRWriter &operator<<(const std::string &str) {
+        Write(str.data(), str.size());
+        return *this;
+    }
+    IRWriter &operator<<(const char *str) {
+        Write(str, strlen(str));
+        return *this;
+    }
+    IRWriter &operator<<(char ch) {
+        if (used == CHUNK_SIZE) NewChunk();
+        chunks.back()[used++] = ch;
+        return *this;
+    }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value && !std::is_same<T, bool>::value, IRWriter &>::type
+    operator<<(T value) {
+        WriteInt((long long)value);
+        return *this;
+    }
+
+    // 重复输出 count 个字符 ch
+    IRWriter &Repeat(char ch, size_t count) {
+        for (size_t i = 0; i < count; i++) *this << ch;
+        return *this;
+    }
+
+    // 开始新的一行指令, 输出当前的缩进
+    IRWriter &Line() {
+        return Repeat('\t', indent);
+    }
+    void Indent() {
+        indent++;
+    }
+    void Dedent() {
+        indent--;
+    }
+
+    size_t Size() const {
+        return (chunks.size() - 1) * CHUNK_SIZE + used;
+    }
+
+    // 把所有内容写入文件
+    void WriteTo(FILE *file) const {
+        for (size_t i = 0; i < chunks.size(); i++) {
+            fwrite(chunks[i].get(), 1, i + 1 == chunks.size() ? used : CHUNK_SIZE, file);
+        }
+    }
+
+private:
+    static const size_t CHUNK_SIZE = 64 * 1024;
+
+    std::vector<std::unique_ptr<char[]> > chunks;
+    size_t used = 0;        // 最后一块中已使用的字节数
+    int indent = 0;
+
+    void NewChunk() {
+        chunks.emplace_back(new char[CHUNK_SIZE]);
+        used = 0;
+    }
+
+    void WriteInt(long long value) {
+        char buf[24];
+        char *end = buf + sizeof(buf), *p = end;
+        unsigned long long abs = value < 0 ? 0ULL - (unsigned long long)value : (unsigned long long)value;
+        do {
+            *--p = '0' + abs % 10;
+            abs /= 10;
+        } while (abs != 0);
+        if (value < 0) *--p = '-';
+        Write(p, end - p);
+    }
+};
@@ -0,0 +1,297 @@
+#include "lexer.hpp"
+#include <cassert>
+#include <climits>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// 因为 lexer 需要返回 token 的种类和值, 需要 include Bison 生成的头文件
+#include "SysY.tab.hpp"
+
+// flex 生成的 scanner (见 SysY.l 中的 YY_DECL) 与它的输入
+extern FILE *yyin;
+int FlexLex();
+
+/**************** 源文件 ****************/
+
+bool SourceFile::Open(const char path[]) {
+    Close();
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close(fd);
+        return false;
+    }
+    size = st.st_size;
+    if (size == 0) {
+        // 空文件不能映射
+        data = "";
+    } else {
+        void *addr = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            size = 0;
+            return false;
+        }
+        madvise(addr, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(addr);
+        mapped = true;
+    }
+    close(fd);
+    return true;
+}
+
+void SourceFile::Close() {
+    if (mapped) munmap(const_cast<char *>(data), size);
+    data = nullptr;
+    size = 0;
+    mapped = false;
+}
+
+/**************** 手写的 scanner ****************/
+
+// 与 SysY.l 的规则一一对应, 接受的 token 与 flex 生成的 scanner 相同
+namespace {
+
+// 字符的类别, 按字节查表, 不调用 isalpha/isdigit
+enum : uint8_t {
+    kSpace = 1,         // [ \t\n\r]
+    kIdentStart = 2,    // [a-zA-Z_]
+    kIdentChar = 4,     // [a-zA-Z0-9_]
+    kDigit = 8,         // [0-9]
+    kHexDigit = 16,     // [0-9a-fA-F]
+};
+
+struct CharTable {
+    uint8_t cls[256] = {};
+
+    CharTable() {
+        for (const char *p = " \t\n\r"; *p; p++) cls[(uint8_t)*p] |= kSpace;
+        for (int c = 'a'; c <= 'z'; c++) cls[c] |= kIdentStart | kIdentChar;
+        for (int c = 'A'; c <= 'Z'; c++) cls[c] |= kIdentStart | kIdentChar;
+        cls['_'] |= kIdentStart | kIdentChar;
+        for (int c = '0'; c <= '9'; c++) cls[c] |= kIdentChar | kDigit | kHexDigit;
+        for (int c = 'a'; c <= 'f'; c++) cls[c] |= kHexDigit;
+        for (int c = 'A'; c <= 'F'; c++) cls[c] |= kHexDigit;
+    }
+
+    bool Is(char ch, uint8_t mask) const {
+        return cls[(uint8_t)ch] & mask;
+    }
+};
+
+const CharTable chars;
+
+class Scanner {
+public:
+    void Reset(const char *begin, size_t size) {
+        cur = begin;
+        end = begin + size;
+    }
+
+    int Next() {
+        SkipSpaceAndComments();
+        if (cur == end) return 0;
+
+        char ch = *cur;
+        if (chars.Is(ch, kIdentStart)) return Identifier();
+        if (chars.Is(ch, kDigit)) return Number();
+        if (ch == '\'') {
+            int token = CharLiteral();
+            if (token != 0) return token;
+        }
+
+        // 两个字符的运算符
+        char next = cur + 1 < end ? cur[1] : '\0';
+        int token = 0;
+        switch (ch) {
+        case '<': token = next == '=' ? LE : LT; break;
+        case '>': token = next == '=' ? GE : GT; break;
+        case '=': token = next == '=' ? EQ : 0; break;
+        case '!': token = next == '=' ? NE : 0; break;
+        case '&': token = next == '&' ? AND : 0; break;
+        case '|': token = next == '|' ? OR : 0; break;
+        }
+        if (token == LT || token == GT) {
+            cur++;
+            return token;
+        }
+        if (token != 0) {
+            cur += 2;
+            return token;
+        }
+        // 其余的字符原样返回, 与 flex 的 yytext[0] 相同
+        cur++;
+        return ch;
+    }
+
+private:
+    const char *cur = nullptr;
+    const char *end = nullptr;
+
+    void SkipSpaceAndComments() {
+        while (cur != end) {
+            if (chars.Is(*cur, kSpace)) {
+                cur++;
+            } else
+            if (*cur == '/' && cur + 1 < end && cur[1] == '/') {
+                // 行注释, 直接找到行尾
+                const void *eol = memchr(cur + 2, '\n', end - cur - 2);
+                cur = eol != nullptr ? static_cast<const char *>(eol) : end;
+            } else
+            if (*cur == '/' && cur + 1 < end && cur[1] == '*') {
+                // 块注释, 没有结尾的 */ 时与 flex 相同, 把 / 作为普通字符返回
+                const char *close = BlockCommentEnd(cur + 2);
+                if (close == nullptr) return;
+                cur = close;
+            } else {
+                return;
+            }
+        }
+    }
+
+    // 块注释的内容从 p 开始, 返回 */ 之后的位置, 没有 */ 时返回 nullptr
+    // 用 memchr 找 '/', 再检查前一个字符, 不逐个字符比较
+    const char *BlockCommentEnd(const char *p) const {
+        p++; // "/*/" 不是完整的注释
+        while (p < end) {
+            const char *slash = static_cast<const char *>(memchr(p, '/', end - p));
+            if (slash == nullptr) return nullptr;
+            if (slash[-1] == '*') return slash + 1;
+            p = slash + 1;
+        }
+        return nullptr;
+    }
+
+    int Identifier() {
+        const char *begin = cur++;
+        while (cur != end && chars.Is(*cur, kIdentChar)) cur++;
+        size_t len = cur - begin;
+        int keyword = Keyword(begin, len);
+        if (keyword != 0) return keyword;
+        yylval.ident_val = identifiers.Intern(begin, len);
+        return IDENT;
+    }
+
+    // 按长度与首字母区分关键字, 每个标识符最多比较一次
+    static int Keyword(const char *str, size_t len) {
+        auto is = [&](const char *keyword) {
+            return memcmp(str, keyword, len) == 0;
+        };
+        switch (len) {
+        case 2: return is("if") ? IF : 0;
+        case 3: return is("int") ? INT : 0;
+        case 4: return str[0] == 'v' ? (is("void") ? VOID : 0) : (is("else") ? ELSE : 0);
+        case 5: return str[0] == 'c' ? (is("const") ? CONST : 0) : str[0] == 'w' ? (is("while") ? WHILE : 0) : (is("break") ? BREAK : 0);
+        case 6: return is("return") ? RETURN : 0;
+        case 8: return is("continue") ? CONTINUE : 0;
+        default: return 0;
+        }
+    }
+
+    // Decimal [1-9][0-9]* | Octal 0[0-7]* | Hexadecimal 0[xX][0-9a-fA-F]+
+    // 值与 strtol(yytext, nullptr, 0) 相同 (超出 long 的范围时取 LONG_MAX), 再截断为 int
+    int Number() {
+        unsigned long long value = 0;
+        int base = 10;
+        if (*cur != '0') {
+            while (cur != end && chars.Is(*cur, kDigit)) Accumulate(value, base, *cur++ - '0');
+        } else
+        if (cur + 2 < end && (cur[1] == 'x' || cur[1] == 'X') && chars.Is(cur[2], kHexDigit)) {
+            base = 16;
+            cur += 2;
+            while (cur != end && chars.Is(*cur, kHexDigit)) Accumulate(value, base, HexValue(*cur++));
+        } else {
+            base = 8;
+            cur++;
+            while (cur != end && *cur >= '0' && *cur <= '7') Accumulate(value, base, *cur++ - '0');
+        }
+        yylval.int_val = (int)(long)value;
+        return INT_CONST;
+    }
+
+    static void Accumulate(unsigned long long &value, int base, int digit) {
+        if (value > ((unsigned long long)LONG_MAX - digit) / base) {
+            value = LONG_MAX;
+        } else {
+            value = value * base + digit;
+        }
+    }
+
+    static int HexValue(char ch) {
+        if (ch <= '9') return ch - '0';
+        return (ch | 0x20) - 'a' + 10;
+    }
+
+    // Char '[^'\\\n]' | Escape '\\[nrt0'\\]', 都不匹配时返回 0, 单独的 ' 作为普通字符
+    int CharLiteral() {
+        if (cur + 2 < end && cur[1] != '\'' && cur[1] != '\\' && cur[1] != '\n' && cur[2] == '\'') {
+            yylval.int_val = cur[1];
+            cur += 3;
+            return INT_CONST;
+        }
+        if (cur + 3 < end && cur[1] == '\\' && cur[3] == '\'') {
+            int value;
+            switch (cur[2]) {
+            case 'n': value = '\n'; break;
+            case 'r': value = '\r'; break;
+            case 't': value = '\t'; break;
+            case '0': value = '\0'; break;
+            case '\'': value = '\''; break;
+            case '\\': value = '\\'; break;
+            default: return 0;
+            }
+            yylval.int_val = value;
+            cur += 4;
+            return INT_CONST;
+        }
+        return 0;
+    }
+};
+
+SourceFile source;
+Scanner scanner;
+bool useFlex = false;   // 当前的输入是否由 flex 生成的 scanner 扫描
+bool forceFlex = false;
+
+}
+
+void UseFlexLexer(bool use) {
+    forceFlex = use;
+}
+
+void OpenLexerInput(const char input[]) {
+    useFlex = forceFlex || !source.Open(input);
+    if (useFlex) {
+        yyin = fopen(input, "r");
+        assert(yyin);
+    } else {
+        scanner.Reset(source.Data(), source.Size());
+    }
+}
+
+void CloseLexerInput() {
+    if (useFlex) {
+        fclose(yyin);
+        yyin = nullptr;
+    } else {
+        source.Close();
+    }
+}
+
+int yylex() {
+    return useFlex ? FlexLex() : scanner.Next();
+}
+
+int CountTokens(const char input[]) {
+    OpenLexerInput(input);
+    int count = 0;
+    while (yylex() != 0) count++;
+    CloseLexerInput();
+    return count;
+}
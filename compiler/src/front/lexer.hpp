@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+
+// 通过 mmap 映射到内存的只读源文件
+// 不复制文件内容, 也不经过 stdio 的缓冲; 内容不以 '\0' 结尾, 需要按 Size() 访问
+class SourceFile {
+public:
+    SourceFile() = default;
+    SourceFile(const SourceFile &) = delete;
+    SourceFile &operator=(const SourceFile &) = delete;
+    ~SourceFile() {
+        Close();
+    }
+
+    // 映射 path, 不是普通文件或映射失败时返回 false
+    bool Open(const char path[]);
+    void Close();
+
+    const char *Data() const {
+        return data;
+    }
+    size_t Size() const {
+        return size;
+    }
+
+private:
+    const char *data = nullptr;
+    size_t size = 0;
+    bool mapped = false;
+};
+
+// 打开 lexer 的输入文件
+// 默认映射整个文件, 由手写的 scanner 扫描; 映射失败或 UseFlexLexer(true) 时用 yyin 读取, 由 flex 生成的 scanner 扫描
+void OpenLexerInput(const char input[]);
+void CloseLexerInput();
+
+// 是否强制使用 flex 生成的 scanner (-flex-lexer)
+void UseFlexLexer(bool use);
+
+// 只做词法分析, 返回 token 的个数 (-lex)
+int CountTokens(const char input[]);
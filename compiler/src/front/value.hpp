@@ -0,0 +1,75 @@
+#pragma once
+#include <cstdint>
+#include "ir_writer.hpp"
+
+// 生成 IR 时表达式的结果与基本块标号
+// 只记录种类和一个整数 (常量的值, 临时变量的编号, 变量的编号), 名字指向 AST 或字符串常量, 不复制
+// 输出时才转换为文本, 生成过程中不再拼接和解析 "%3", "*@a_1" 这样的字符串
+struct Value {
+    enum Kind : uint8_t {
+        kNone,      // 没有值, 如 void 函数的调用
+        kConst,     // 整数常量 id
+        kTemp,      // 临时变量 %id
+        kPtr,       // 保存元素地址的临时变量 %id, 取值时需要 load
+        kVar,       // 变量 @name 或 @name_id, 取值时需要 load
+        kFParam,    // 形参的副本 %name_fParam, 取值时需要 load
+        kLabel,     // 基本块标号 %name 或 %name_id
+    };
+
+    Kind kind = kNone;
+    int id = 0;
+    const char *name = nullptr;
+
+    static Value Const(int value) {
+        return Value(kConst, value);
+    }
+    static Value Temp(int id) {
+        return Value(kTemp, id);
+    }
+    static Value Ptr(int id) {
+        return Value(kPtr, id);
+    }
+    // id 为 0 时没有后缀
+    static Value Var(const char *name, int id = 0) {
+        return Value(kVar, id, name);
+    }
+    static Value FParam(const char *name) {
+        return Value(kFParam, 0, name);
+    }
+    // id 为负数时没有后缀
+    static Value Label(const char *name, int id = -1) {
+        return Value(kLabel, id, name);
+    }
+
+    // 是否是变量的地址 (赋值的目标), 而不是可以直接使用的值
+    bool IsAddr() const {
+        return kind == kPtr || kind == kVar || kind == kFParam;
+    }
+
+    Value() = default;
+
+private:
+    Value(Kind kind, int id, const char *name = nullptr) : kind(kind), id(id), name(name) {}
+};
+
+inline IRWriter &operator<<(IRWriter &out, const Value &value) {
+    switch (value.kind) {
+    case Value::kConst:
+        return out << value.id;
+    case Value::kTemp:
+    case Value::kPtr:
+        return out << '%' << value.id;
+    case Value::kVar:
+        out << '@' << value.name;
+        if (value.id != 0) out << '_' << value.id;
+        return out;
+    case Value::kFParam:
+        return out << '%' << value.name << "_fParam";
+    case Value::kLabel:
+        out << '%' << value.name;
+        if (value.id >= 0) out << '_' << value.id;
+        return out;
+    default:
+        return out;
+    }
+}
@@ -1,20 +1,28 @@
 #include <cstring>
 #include <ctime>
+#include <chrono>
+#include <sys/stat.h>
 
 #include "front/front_main.hpp"
+#include "opt/opt_main.hpp"
 #include "back/back_main.hpp"
 
 void CopyFile(const char input[], const char output[]){
-    // 从input中读取文件内容
-    ifstream fin(input);
-    std::istreambuf_iterator<char> beg(fin), end;
-    std::string input_data(beg, end);
-    fin.close();
-
-    // 输出到 output 中
-    ofstream fout(output);
-    fout << input_data;
-    fout.close();
+    // input 与 output 是同一个文件时不需要复制 (make riscv 的输入就是 ./test/task.c)
+    struct stat inputStat, outputStat;
+    if (stat(input, &inputStat) == 0 && stat(output, &outputStat) == 0 &&
+        inputStat.st_dev == outputStat.st_dev && inputStat.st_ino == outputStat.st_ino) {
+        return;
+    }
+
+    // 映射 input, 直接写入 output, 不经过中间的字符串
+    SourceFile source;
+    bool ok = source.Open(input);
+    assert(ok);
+    FILE *fout = fopen(output, "w");
+    assert(fout);
+    fwrite(source.Data(), 1, source.Size(), fout);
+    fclose(fout);
 }
 
 void Delay(int ms){
@@ -26,14 +34,42 @@ void Delay(int ms){
 int main(int argc, const char *argv[]) {
     // 解析命令行参数. 测试脚本/评测平台要求你的编译器能接收如下参数:
     // compiler 模式 输入文件 -o 输出文件
-    assert(argc == 5);
+    // 之后可以跟优化选项: -O0/-O1/-O2/-O3, -passes=a,b,c, -time-passes, -funroll=N, -finline-threshold=N
+    // 以及前端选项 -flex-lexer
+    assert(argc >= 5);
     auto mode = argv[1];
     auto input = argv[2];
     auto output = argv[4];
+
+    for (int i = 5; i < argc; i++) {
+        if (strcmp(argv[i], "-flex-lexer") == 0) {
+            UseFlexLexer(true);
+        } else
+        if (!ParseOptOption(argv[i])) {
+            printf("unknown option %s\n", argv[i]);
+            assert(0);
+        }
+    }
     
     if (strcmp(mode, "-koopa") == 0) {
         front_main(input, output);
+        // 中端对IR进行优化
+        if (OptEnabled()) opt_main(output, output);
     } 
+    else if (strcmp(mode, "-dump-ast") == 0) {
+        // 只做语法分析, 输出 AST
+        front_dump_ast(input, output);
+    }
+    else if (strcmp(mode, "-lex") == 0) {
+        // 只做词法分析, 输出 token 的个数与耗时, 用于比较两种 scanner
+        auto start = std::chrono::steady_clock::now();
+        int tokens = CountTokens(input);
+        std::chrono::duration<double, std::milli> time = std::chrono::steady_clock::now() - start;
+        FILE *fout = fopen(output, "w");
+        assert(fout);
+        fprintf(fout, "tokens: %d\ntime: %.3f ms\n", tokens, time.count());
+        fclose(fout);
+    }
     else if (strcmp(mode, "-riscv") == 0) {
         // Delay(2000000);
         const char CFile[] = "./test/task.c";
@@ -43,6 +79,10 @@ int main(int argc, const char *argv[]) {
 
         // 前端读入input文件，生成IR树，放到IRFile文件中
         front_main(input, IRFile);
+        // 前端生成的常量数组等只读数据由后端放入 .rodata
+        backReadOnlyGlobals = BaseAST::ReadOnlyGlobals();
+        // 中端对IRFile中的IR进行优化, 结果写回IRFile
+        if (OptEnabled()) opt_main(IRFile, IRFile);
         // 后端读入IRFile文件，解析IR树，生成RISCV，放到output文件中
         back_main(IRFile, output);
     }
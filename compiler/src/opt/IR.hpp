@@ -0,0 +1,468 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <cstdlib>
+#include <cassert>
+
+/**************** 中端 IR ****************/
+// 前端输出的文本 KoopaIR 在内存中的表示
+// 各个优化遍在其上进行变换, 最后再输出为文本 KoopaIR, 交给后端处理
+
+// 操作数统一用字符串表示: 整数常量 "10" / 局部符号 "%x" / 全局符号 "@x"
+inline bool IsConstOperand(const std::string &operand) {
+    return !operand.empty() && (isdigit(operand[0]) || operand[0] == '-');
+}
+
+inline bool IsSymbolOperand(const std::string &operand) {
+    return !operand.empty() && (operand[0] == '%' || operand[0] == '@');
+}
+
+// 指令
+class Inst {
+public:
+    enum Kind {
+        kAlloc,         // dest = alloc op
+        kLoad,          // dest = load args[0]
+        kStore,         // store args[0], args[1]
+        kGetPtr,        // dest = getptr args[0], args[1]
+        kGetElemPtr,    // dest = getelemptr args[0], args[1]
+        kBinary,        // dest = op args[0], args[1]
+        kBranch,        // br args[0], targets[0], targets[1]
+        kJump,          // jump targets[0]
+        kCall,          // [dest =] call op(args...)
+        kReturn         // ret [args[0]]
+    };
+
+    Kind kind;
+    std::string dest;                   // 指令结果的名称, 没有结果时为空
+    std::string op;                     // kBinary 为运算符, kAlloc 为分配的类型, kCall 为被调用的函数
+    std::vector<std::string> args;      // 操作数
+    std::vector<std::string> targets;   // 跳转的目标基本块
+
+    bool IsTerminator() const {
+        return kind == kBranch || kind == kJump || kind == kReturn;
+    }
+
+    // 是否有副作用 (不能随意删除或移动)
+    bool HasSideEffect() const {
+        return kind == kStore || kind == kCall || IsTerminator();
+    }
+
+    // 将使用到的操作数按照 rename 进行替换
+    void RenameUses(const std::map<std::string, std::string> &rename) {
+        for (auto &arg : args) {
+            auto it = rename.find(arg);
+            if (it != rename.end()) arg = it->second;
+        }
+    }
+
+    // 将跳转目标按照 rename 进行替换
+    void RenameTargets(const std::map<std::string, std::string> &rename) {
+        for (auto &target : targets) {
+            auto it = rename.find(target);
+            if (it != rename.end()) target = it->second;
+        }
+    }
+
+    void Print(std::string &buffer) const {
+        buffer += "\t";
+        if (!dest.empty()) buffer += dest + " = ";
+        switch (kind) {
+            case kAlloc: buffer += "alloc " + op; break;
+            case kLoad: buffer += "load " + args[0]; break;
+            case kStore: buffer += "store " + args[0] + ", " + args[1]; break;
+            case kGetPtr: buffer += "getptr " + args[0] + ", " + args[1]; break;
+            case kGetElemPtr: buffer += "getelemptr " + args[0] + ", " + args[1]; break;
+            case kBinary: buffer += op + " " + args[0] + ", " + args[1]; break;
+            case kBranch: buffer += "br " + args[0] + ", " + targets[0] + ", " + targets[1]; break;
+            case kJump: buffer += "jump " + targets[0]; break;
+            case kCall: {
+                buffer += "call " + op + "(";
+                for (size_t i = 0; i < args.size(); i++) {
+                    if (i != 0) buffer += ", ";
+                    buffer += args[i];
+                }
+                buffer += ")";
+                break;
+            }
+            case kReturn: buffer += args.empty() ? "ret" : "ret " + args[0]; break;
+        }
+        buffer += "\n";
+    }
+};
+
+// 基本块
+class BasicBlock {
+public:
+    std::string name;               // %label
+    std::vector<Inst> insts;
+
+    // 基本块的最后一条指令一定是 br/jump/ret
+    Inst &Terminator() { return insts.back(); }
+    const Inst &Terminator() const { return insts.back(); }
+
+    std::vector<std::string> Successors() const {
+        if (insts.empty()) return {};
+        return insts.back().targets;
+    }
+
+    void Print(std::string &buffer) const {
+        buffer += name + ":\n";
+        for (auto &inst : insts) inst.Print(buffer);
+    }
+};
+
+// 函数 (包括函数声明)
+class Function {
+public:
+    std::string name;                                           // @name
+    std::vector<std::pair<std::string, std::string> > params;   // (参数名, 类型), 函数声明的参数名为空
+    std::string retType;                                        // 返回值类型, void 为空
+    bool isDecl = false;
+    std::vector<BasicBlock> bbs;
+
+    // 基本块名 => 基本块在 bbs 中的下标
+    std::map<std::string, int> BlockIndex() const {
+        std::map<std::string, int> index;
+        for (size_t i = 0; i < bbs.size(); i++) index[bbs[i].name] = i;
+        return index;
+    }
+
+    // 统计函数的指令条数, 作为函数大小的估计
+    int InstCount() const {
+        int count = 0;
+        for (auto &bb : bbs) count += bb.insts.size();
+        return count;
+    }
+
+    void Print(std::string &buffer) const {
+        buffer += (isDecl ? "decl " : "fun ") + name + "(";
+        for (size_t i = 0; i < params.size(); i++) {
+            if (i != 0) buffer += ", ";
+            buffer += isDecl ? params[i].second : params[i].first + ": " + params[i].second;
+        }
+        buffer += ")";
+        if (!retType.empty()) buffer += ": " + retType;
+        if (isDecl) {
+            buffer += "\n";
+            return;
+        }
+        buffer += " {\n";
+        for (auto &bb : bbs) bb.Print(buffer);
+        buffer += "}\n";
+    }
+};
+
+// 全局变量
+class GlobalVar {
+public:
+    std::string name;   // @name
+    std::string type;
+    std::string init;   // zeroinit / 整数 / {...}
+
+    void Print(std::string &buffer) const {
+        buffer += "global " + name + " = alloc " + type + ", " + init + "\n";
+    }
+};
+
+// 整个程序
+class Module {
+public:
+    std::vector<GlobalVar> globals;
+    std::vector<Function> funcs;
+
+    Function *GetFunction(const std::string &name) {
+        for (auto &func : funcs) {
+            if (func.name == name) return &func;
+        }
+        return nullptr;
+    }
+
+    // 生成一个新的, 在整个程序中唯一的名称前缀, 如 "unroll3_"
+    // 后端会把基本块名直接作为汇编标号, 因此复制出来的基本块必须在全局范围内唯一
+    std::string NewTag(const std::string &prefix) {
+        return prefix + std::to_string(tagCount++) + "_";
+    }
+
+    // 整个程序的指令条数
+    int InstCount() const {
+        int count = 0;
+        for (auto &func : funcs) count += func.InstCount();
+        return count;
+    }
+
+    void Parse(const std::string &text);
+
+    void Print(std::string &buffer) const {
+        for (auto &func : funcs) {
+            if (func.isDecl) func.Print(buffer);
+        }
+        for (auto &global : globals) global.Print(buffer);
+        for (auto &func : funcs) {
+            if (!func.isDecl) func.Print(buffer);
+        }
+    }
+
+private:
+    int tagCount = 0;
+};
+
+// 给符号加上前缀 tag, 得到新的符号: %5 => %tag5, @x_1 => @tagx_1
+inline std::string TagSymbol(const std::string &symbol, const std::string &tag) {
+    return symbol.substr(0, 1) + tag + symbol.substr(1);
+}
+
+/**************** 文本 KoopaIR 的解析 ****************/
+
+class IRParser {
+public:
+    IRParser(const std::string &text) : text(text), pos(0) {}
+
+    void ParseModule(Module &module) {
+        while (true) {
+            SkipSpace();
+            if (pos >= text.size()) break;
+            std::string word = ParseWord();
+            if (word == "decl") {
+                module.funcs.push_back(ParseFunction(true));
+            } else
+            if (word == "fun") {
+                module.funcs.push_back(ParseFunction(false));
+            } else
+            if (word == "global") {
+                module.globals.push_back(ParseGlobal());
+            } else {
+                Error("unknown top-level item " + word);
+            }
+        }
+    }
+
+private:
+    const std::string &text;
+    size_t pos;
+
+    void Error(const std::string &msg) {
+        std::cerr << "IRParser: " << msg << " at " << pos << std::endl;
+        assert(0);
+    }
+
+    // 跳过空白符, newline 为 false 时不跳过换行符
+    void SkipSpace(bool newline = true) {
+        while (pos < text.size()) {
+            char ch = text[pos];
+            if (ch == ' ' || ch == '\t' || ch == '\r' || (newline && ch == '\n')) {
+                pos++;
+            } else
+            if (newline && ch == '/' && pos + 1 < text.size() && text[pos + 1] == '/') {
+                while (pos < text.size() && text[pos] != '\n') pos++;
+            } else {
+                break;
+            }
+        }
+    }
+
+    char Peek() {
+        SkipSpace();
+        return pos < text.size() ? text[pos] : '\0';
+    }
+
+    void Expect(char ch) {
+        if (Peek() != ch) Error(std::string("expect '") + ch + "'");
+        pos++;
+    }
+
+    bool IsNameChar(char ch) {
+        return isalnum(ch) || ch == '_';
+    }
+
+    std::string ParseWord() {
+        SkipSpace();
+        size_t beg = pos;
+        while (pos < text.size() && IsNameChar(text[pos])) pos++;
+        return text.substr(beg, pos - beg);
+    }
+
+    std::string ParseSymbol() {
+        char ch = Peek();
+        if (ch != '%' && ch != '@') Error("expect symbol");
+        size_t beg = pos++;
+        while (pos < text.size() && IsNameChar(text[pos])) pos++;
+        return text.substr(beg, pos - beg);
+    }
+
+    // 操作数: 整数或符号
+    std::string ParseValue() {
+        char ch = Peek();
+        if (ch == '%' || ch == '@') return ParseSymbol();
+        size_t beg = pos;
+        if (ch == '-') pos++;
+        while (pos < text.size() && isdigit(text[pos])) pos++;
+        if (beg == pos) Error("expect value");
+        return text.substr(beg, pos - beg);
+    }
+
+    std::string ParseType() {
+        char ch = Peek();
+        if (ch == '*') {
+            pos++;
+            return "*" + ParseType();
+        }
+        if (ch == '[') {
+            pos++;
+            std::string base = ParseType();
+            Expect(',');
+            std::string len = ParseValue();
+            Expect(']');
+            return "[" + base + ", " + len + "]";
+        }
+        std::string word = ParseWord();
+        if (word != "i32") Error("unknown type " + word);
+        return word;
+    }
+
+    // 全局变量的初始值: zeroinit / 整数 / {...}
+    std::string ParseInit() {
+        char ch = Peek();
+        if (ch == '{') {
+            pos++;
+            std::string init = "{";
+            while (Peek() != '}') {
+                if (init != "{") {
+                    Expect(',');
+                    init += ", ";
+                }
+                init += ParseInit();
+            }
+            pos++;
+            return init + "}";
+        }
+        if (isalpha(ch)) return ParseWord();
+        return ParseValue();
+    }
+
+    GlobalVar ParseGlobal() {
+        GlobalVar global;
+        global.name = ParseSymbol();
+        Expect('=');
+        if (ParseWord() != "alloc") Error("expect alloc");
+        global.type = ParseType();
+        Expect(',');
+        global.init = ParseInit();
+        return global;
+    }
+
+    Function ParseFunction(bool isDecl) {
+        Function func;
+        func.isDecl = isDecl;
+        func.name = ParseSymbol();
+        Expect('(');
+        while (Peek() != ')') {
+            if (!func.params.empty()) Expect(',');
+            std::string name;
+            if (!isDecl) {
+                name = ParseSymbol();
+                Expect(':');
+            }
+            func.params.push_back(std::make_pair(name, ParseType()));
+        }
+        pos++;
+        if (Peek() == ':') {
+            pos++;
+            func.retType = ParseType();
+        }
+        if (isDecl) return func;
+
+        Expect('{');
+        while (Peek() != '}') {
+            // 基本块的标号
+            BasicBlock bb;
+            bb.name = ParseSymbol();
+            Expect(':');
+            // 基本块中的指令, 直到下一个标号或函数结尾
+            while (true) {
+                char ch = Peek();
+                if (ch == '}') break;
+                if (ch == '%') {
+                    size_t save = pos;
+                    ParseSymbol();
+                    bool isLabel = Peek() == ':';
+                    pos = save;
+                    if (isLabel) break;
+                }
+                bb.insts.push_back(ParseInst());
+            }
+            func.bbs.push_back(bb);
+        }
+        pos++;
+        return func;
+    }
+
+    Inst ParseInst() {
+        Inst inst;
+        char ch = Peek();
+        if (ch == '%' || ch == '@') {
+            inst.dest = ParseSymbol();
+            Expect('=');
+        }
+        std::string word = ParseWord();
+        if (word == "alloc") {
+            inst.kind = Inst::kAlloc;
+            inst.op = ParseType();
+        } else
+        if (word == "load") {
+            inst.kind = Inst::kLoad;
+            inst.args.push_back(ParseValue());
+        } else
+        if (word == "store" || word == "getptr" || word == "getelemptr") {
+            inst.kind = word == "store" ? Inst::kStore : word == "getptr" ? Inst::kGetPtr : Inst::kGetElemPtr;
+            inst.args.push_back(ParseValue());
+            Expect(',');
+            inst.args.push_back(ParseValue());
+        } else
+        if (word == "br") {
+            inst.kind = Inst::kBranch;
+            inst.args.push_back(ParseValue());
+            Expect(',');
+            inst.targets.push_back(ParseSymbol());
+            Expect(',');
+            inst.targets.push_back(ParseSymbol());
+        } else
+        if (word == "jump") {
+            inst.kind = Inst::kJump;
+            inst.targets.push_back(ParseSymbol());
+        } else
+        if (word == "call") {
+            inst.kind = Inst::kCall;
+            inst.op = ParseSymbol();
+            Expect('(');
+            while (Peek() != ')') {
+                if (!inst.args.empty()) Expect(',');
+                inst.args.push_back(ParseValue());
+            }
+            pos++;
+        } else
+        if (word == "ret") {
+            inst.kind = Inst::kReturn;
+            // 返回值必须和 ret 在同一行, 否则下一行的标号会被当作返回值
+            SkipSpace(false);
+            if (pos < text.size() && text[pos] != '\n' && text[pos] != '}') {
+                inst.args.push_back(ParseValue());
+            }
+        } else {
+            inst.kind = Inst::kBinary;
+            inst.op = word;
+            inst.args.push_back(ParseValue());
+            Expect(',');
+            inst.args.push_back(ParseValue());
+        }
+        return inst;
+    }
+};
+
+inline void Module::Parse(const std::string &text) {
+    IRParser parser(text);
+    parser.ParseModule(*this);
+}
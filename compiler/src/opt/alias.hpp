@@ -0,0 +1,148 @@
+#pragma once
+#include "IR.hpp"
+#include "analysis.hpp"
+
+/**************** 别名分析 ****************/
+
+// 两个指针之间的关系
+enum AliasResult {
+    kNoAlias,       // 一定指向不同的位置
+    kMayAlias,      // 可能指向同一个位置
+    kMustAlias,     // 一定指向同一个位置
+};
+
+// 指针指向的位置: 根对象 + 一串 getptr/getelemptr 的下标
+class MemLocation {
+public:
+    enum RootKind {
+        kGlobal,        // 全局变量 @x
+        kLocal,         // 局部变量 (alloc)
+        kUnknown,       // 数组参数等从栈中读取出来的指针, 可能指向调用者的局部数组或者全局数组
+    };
+    RootKind kind;
+    std::string root;
+    std::vector<std::pair<Inst::Kind, std::string> > path;
+};
+
+// 基于根对象与下标的别名分析
+// 从栈中读取出来的指针 (例如数组参数 %x_fParam 中保存的指针) 只知道不会指向标量全局变量, 以及地址没有逃逸的局部变量
+class AliasAnalysis {
+public:
+    AliasAnalysis(const Module &module, const Function &func, const std::map<std::string, ModRefInfo> &modRef)
+        : modRef(modRef) {
+        for (auto &global : module.globals) globals[global.name] = global.type;
+        for (auto &param : func.params) paramTypes[param.first] = param.second;
+        for (auto &bb : func.bbs) {
+            for (auto &inst : bb.insts) {
+                if (!inst.dest.empty()) defs[inst.dest] = inst;
+            }
+        }
+        // 地址被存入内存 (内联之后的参数) 或者传给其他函数的局部变量, 可能被读取出来的指针指向
+        for (auto &bb : func.bbs) {
+            for (auto &inst : bb.insts) {
+                std::vector<std::string> values;
+                if (inst.kind == Inst::kStore) values.push_back(inst.args[0]);
+                if (inst.kind == Inst::kCall) values = inst.args;
+                for (auto &value : values) {
+                    if (!IsPointer(value)) continue;
+                    MemLocation loc = Locate(value);
+                    if (loc.kind == MemLocation::kLocal) escaped.insert(loc.root);
+                }
+            }
+        }
+    }
+
+    // 沿 getptr/getelemptr 找到指针的根对象
+    MemLocation Locate(const std::string &ptr) const {
+        MemLocation loc;
+        std::string now = ptr;
+        while (true) {
+            auto it = defs.find(now);
+            if (it == defs.end() || (it->second.kind != Inst::kGetPtr && it->second.kind != Inst::kGetElemPtr)) break;
+            loc.path.push_back(std::make_pair(it->second.kind, it->second.args[1]));
+            now = it->second.args[0];
+        }
+        std::reverse(loc.path.begin(), loc.path.end());
+        loc.root = now;
+        auto it = defs.find(now);
+        if (globals.count(now)) {
+            loc.kind = MemLocation::kGlobal;
+        } else
+        if (it != defs.end() && it->second.kind == Inst::kAlloc) {
+            loc.kind = MemLocation::kLocal;
+        } else {
+            loc.kind = MemLocation::kUnknown;
+        }
+        return loc;
+    }
+
+    // 值是否是指针 (而不是整数)
+    bool IsPointer(const std::string &value) const {
+        if (paramTypes.count(value)) return paramTypes.at(value)[0] == '*';
+        auto it = defs.find(value);
+        if (it == defs.end()) return false;
+        if (it->second.kind == Inst::kGetPtr || it->second.kind == Inst::kGetElemPtr) return true;
+        if (it->second.kind != Inst::kLoad) return false;
+        auto src = defs.find(it->second.args[0]);
+        return src != defs.end() && src->second.kind == Inst::kAlloc && src->second.op[0] == '*';
+    }
+
+    // 两个位置的根对象是否可能相同
+    bool MayShareRoot(const MemLocation &a, const MemLocation &b) const {
+        if (a.kind == MemLocation::kUnknown && b.kind == MemLocation::kUnknown) return true;
+        if (a.kind == MemLocation::kUnknown) return MayShareRoot(b, a);
+        if (b.kind == MemLocation::kUnknown) {
+            // 读取出来的指针不会指向地址没有逃逸的局部变量, 也不会指向标量全局变量 (SysY 不能取标量的地址)
+            if (a.kind == MemLocation::kLocal) return escaped.count(a.root) != 0;
+            return globals.at(a.root) != "i32";
+        }
+        return a.root == b.root;
+    }
+
+    AliasResult Alias(const std::string &p, const std::string &q) const {
+        if (p == q) return kMustAlias;
+        MemLocation a = Locate(p), b = Locate(q);
+        if (a.root != b.root) return MayShareRoot(a, b) ? kMayAlias : kNoAlias;
+        if (a.path.size() != b.path.size()) return kMayAlias;
+        for (size_t i = 0; i < a.path.size(); i++) {
+            if (a.path[i].first != b.path[i].first) return kMayAlias;
+        }
+        // 结构相同时, 某一层的下标是不同的常量就一定不重叠 (假设下标不越界), 但 getptr 可以越出元素的范围:
+        // 这一层是 getptr 时要求之前的下标完全相同, 之后的层中不能再有 getptr
+        int lastGetPtr = -1;
+        for (size_t i = 0; i < a.path.size(); i++) {
+            if (a.path[i].first == Inst::kGetPtr) lastGetPtr = i;
+        }
+        bool same = true;
+        for (size_t i = 0; i < a.path.size(); i++) {
+            const std::string &x = a.path[i].second, &y = b.path[i].second;
+            bool differ = IsConstOperand(x) && IsConstOperand(y) && atoi(x.c_str()) != atoi(y.c_str());
+            if (differ && (int)i >= lastGetPtr && (same || a.path[i].first == Inst::kGetElemPtr)) return kNoAlias;
+            if (x != y) same = false;
+        }
+        return same ? kMustAlias : kMayAlias;
+    }
+
+    // 调用指令 call 是否可能读 (write 为 false) 或写 (write 为 true) ptr 指向的位置
+    bool CallMayAccess(const Inst &call, const std::string &ptr, bool write) const {
+        MemLocation loc = Locate(ptr);
+        for (auto &arg : call.args) {
+            if (IsPointer(arg) && MayShareRoot(Locate(arg), loc)) return true;
+        }
+        auto it = modRef.find(call.op);
+        // 库函数只会访问通过参数传入的数组
+        if (it == modRef.end()) return false;
+        if (loc.kind == MemLocation::kGlobal) {
+            return write ? it->second.Mods(loc.root) : (it->second.Mods(loc.root) || it->second.Refs(loc.root));
+        }
+        // 传入的指针可能指向被调用函数访问的全局数组
+        return loc.kind == MemLocation::kUnknown;
+    }
+
+private:
+    const std::map<std::string, ModRefInfo> &modRef;
+    std::map<std::string, std::string> globals;       // 全局变量 => 类型
+    std::map<std::string, std::string> paramTypes;    // 参数 => 类型
+    std::map<std::string, Inst> defs;                 // 符号 => 定义它的指令
+    std::set<std::string> escaped;                    // 地址逃逸的局部变量
+};
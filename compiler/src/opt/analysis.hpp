@@ -0,0 +1,460 @@
+#pragma once
+#include <algorithm>
+#include "IR.hpp"
+
+/**************** 控制流分析 ****************/
+
+// 函数的控制流图: 前驱/后继, 逆后序, 支配树
+// 基本块均用其在 func.bbs 中的下标表示, 从入口不可达的基本块 rpoIndex 为 -1
+class CFGInfo {
+public:
+    std::vector<std::vector<int> > succs;
+    std::vector<std::vector<int> > preds;
+    std::vector<int> rpo;           // 可达基本块的逆后序
+    std::vector<int> rpoIndex;      // 基本块在逆后序中的位置
+    std::vector<int> idom;          // 直接支配者, 入口的直接支配者为自身
+
+    CFGInfo(const Function &func) {
+        int n = func.bbs.size();
+        auto index = func.BlockIndex();
+        succs.resize(n);
+        preds.resize(n);
+        for (int i = 0; i < n; i++) {
+            for (auto &target : func.bbs[i].Successors()) {
+                int j = index.at(target);
+                succs[i].push_back(j);
+                preds[j].push_back(i);
+            }
+        }
+
+        // 逆后序
+        rpoIndex.assign(n, -1);
+        if (n > 0) {
+            std::vector<bool> visited(n, false);
+            std::vector<std::pair<int, size_t> > stack;
+            stack.push_back(std::make_pair(0, 0));
+            visited[0] = true;
+            while (!stack.empty()) {
+                int bb = stack.back().first;
+                size_t &next = stack.back().second;
+                if (next < succs[bb].size()) {
+                    int succ = succs[bb][next++];
+                    if (!visited[succ]) {
+                        visited[succ] = true;
+                        stack.push_back(std::make_pair(succ, 0));
+                    }
+                } else {
+                    rpo.push_back(bb);
+                    stack.pop_back();
+                }
+            }
+            std::reverse(rpo.begin(), rpo.end());
+        }
+        for (size_t i = 0; i < rpo.size(); i++) rpoIndex[rpo[i]] = i;
+
+        // 支配树, 使用 Cooper-Harvey-Kennedy 迭代算法
+        idom.assign(n, -1);
+        if (n > 0) idom[0] = 0;
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            for (size_t i = 1; i < rpo.size(); i++) {
+                int bb = rpo[i];
+                int newIdom = -1;
+                for (int pred : preds[bb]) {
+                    if (idom[pred] == -1) continue;
+                    newIdom = newIdom == -1 ? pred : Intersect(pred, newIdom);
+                }
+                if (idom[bb] != newIdom) {
+                    idom[bb] = newIdom;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    bool IsReachable(int bb) const {
+        return rpoIndex[bb] != -1;
+    }
+
+    // a 是否支配 b
+    bool Dominates(int a, int b) const {
+        if (!IsReachable(a) || !IsReachable(b)) return false;
+        while (b != a && b != 0) b = idom[b];
+        return b == a;
+    }
+
+private:
+    int Intersect(int a, int b) const {
+        while (a != b) {
+            while (rpoIndex[a] > rpoIndex[b]) a = idom[a];
+            while (rpoIndex[b] > rpoIndex[a]) b = idom[b];
+        }
+        return a;
+    }
+};
+
+// 自然循环
+class Loop {
+public:
+    int header;
+    std::vector<int> latches;   // 跳回 header 的基本块
+    std::set<int> blocks;       // 循环中的所有基本块 (包括 header)
+
+    bool Contains(int bb) const {
+        return blocks.count(bb) != 0;
+    }
+};
+
+// 找出函数中的所有自然循环, 同一个 header 的回边合并为一个循环
+// 结果按照循环大小从小到大排列, 内层循环在前
+inline std::vector<Loop> FindLoops(const CFGInfo &cfg) {
+    std::map<int, Loop> loops;
+    for (int bb : cfg.rpo) {
+        for (int succ : cfg.succs[bb]) {
+            if (!cfg.Dominates(succ, bb)) continue;
+            // bb -> succ 是回边
+            Loop &loop = loops[succ];
+            loop.header = succ;
+            loop.latches.push_back(bb);
+            loop.blocks.insert(succ);
+            std::vector<int> work;
+            if (loop.blocks.insert(bb).second) work.push_back(bb);
+            while (!work.empty()) {
+                int now = work.back();
+                work.pop_back();
+                for (int pred : cfg.preds[now]) {
+                    if (cfg.IsReachable(pred) && loop.blocks.insert(pred).second) work.push_back(pred);
+                }
+            }
+        }
+    }
+    std::vector<Loop> ret;
+    for (auto &item : loops) ret.push_back(item.second);
+    std::stable_sort(ret.begin(), ret.end(), [](const Loop &a, const Loop &b) {
+        return a.blocks.size() < b.blocks.size();
+    });
+    return ret;
+}
+
+// 循环是否是最内层循环 (不包含其他循环的 header)
+inline bool IsInnermostLoop(const Loop &loop, const std::vector<Loop> &loops) {
+    for (auto &other : loops) {
+        if (other.header != loop.header && loop.Contains(other.header)) return false;
+    }
+    return true;
+}
+
+// 计数循环, 形如:
+//   preheader: ... jump header
+//   header:    %iv = load @i; ...; %cond = lt %iv, bound; br %cond, body, exit
+//   body:      ... store (add (load @i), step), @i ...      (每次迭代恰好执行一次)
+//   latch:     jump header
+struct CountedLoop {
+    int preheader, header, latch, exit;
+    std::string body;            // 循环体的入口基本块
+    std::string ivar;            // 循环变量 @i
+    std::string ivLoad;          // header 中 load @i 的结果
+    std::string cmpOp;           // 循环变量在左侧时的比较运算符: lt/le/gt/ge
+    std::string bound;           // 循环的边界
+    int step;               // 每次迭代循环变量的增量
+    bool hasInit;           // 是否知道循环变量的初值
+    int init;
+};
+
+// 值在循环中是否不变
+inline bool IsLoopInvariant(const Function &func, const Loop &loop, const std::map<std::string, std::pair<int, int> > &defs,
+                            const std::set<std::string> &storedInLoop, bool hasCall, const std::string &value) {
+    if (!IsSymbolOperand(value)) return true;
+    auto it = defs.find(value);
+    if (it == defs.end() || !loop.Contains(it->second.first)) return true;  // 全局变量/函数参数/循环外定义的值
+    if (it->second.first != loop.header) return false;
+
+    const Inst &inst = func.bbs[it->second.first].insts[it->second.second];
+    if (inst.kind == Inst::kLoad) {
+        // 只考虑标量: 局部标量只能被直接 store 修改, 全局标量还可能在被调用的函数中修改
+        const std::string &src = inst.args[0];
+        if (storedInLoop.count(src)) return false;
+        if (src[0] == '@' && !defs.count(src) && hasCall) return false;
+        auto def = defs.find(src);
+        if (def == defs.end()) return src[0] == '@';
+        const Inst &alloc = func.bbs[def->second.first].insts[def->second.second];
+        return alloc.kind == Inst::kAlloc && alloc.op == "i32";
+    }
+    if (inst.kind == Inst::kBinary) {
+        return IsLoopInvariant(func, loop, defs, storedInLoop, hasCall, inst.args[0]) &&
+               IsLoopInvariant(func, loop, defs, storedInLoop, hasCall, inst.args[1]);
+    }
+    return false;
+}
+
+// 判断循环是否为可以展开的计数循环
+inline bool AnalyzeCountedLoop(const Function &func, const CFGInfo &cfg, const Loop &loop, CountedLoop &info) {
+    int header = loop.header;
+    if (header == 0 || loop.latches.size() != 1) return false;
+    int latch = loop.latches[0];
+    if (func.bbs[latch].Terminator().kind != Inst::kJump) return false;
+
+    // 唯一的 preheader, 并且只跳转到 header
+    int preheader = -1;
+    for (int pred : cfg.preds[header]) {
+        if (loop.Contains(pred)) continue;
+        if (preheader != -1) return false;
+        preheader = pred;
+    }
+    if (preheader == -1 || func.bbs[preheader].Terminator().kind != Inst::kJump) return false;
+
+    // 只能从 header 跳出循环
+    const Inst &br = func.bbs[header].Terminator();
+    if (br.kind != Inst::kBranch) return false;
+    auto index = func.BlockIndex();
+    int body = index.at(br.targets[0]), exit = index.at(br.targets[1]);
+    if (!loop.Contains(body) || loop.Contains(exit) || body == header) return false;
+    if (cfg.preds[body].size() != 1) return false;
+    for (int bb : loop.blocks) {
+        if (bb == header) continue;
+        for (int succ : cfg.succs[bb]) {
+            if (!loop.Contains(succ)) return false;
+        }
+    }
+
+    // header 中只能有无副作用的指令
+    std::map<std::string, std::pair<int, int> > defs;
+    for (size_t i = 0; i < func.bbs.size(); i++) {
+        for (size_t j = 0; j < func.bbs[i].insts.size(); j++) {
+            auto &inst = func.bbs[i].insts[j];
+            if (!inst.dest.empty()) defs[inst.dest] = std::make_pair(i, j);
+        }
+    }
+    auto &headerInsts = func.bbs[header].insts;
+    for (size_t i = 0; i + 1 < headerInsts.size(); i++) {
+        auto kind = headerInsts[i].kind;
+        if (kind != Inst::kLoad && kind != Inst::kBinary && kind != Inst::kGetPtr && kind != Inst::kGetElemPtr) return false;
+    }
+
+    // 循环中被直接 store 的符号, 以及是否有函数调用
+    std::map<std::string, int> storeCount;
+    bool hasCall = false;
+    for (int bb : loop.blocks) {
+        for (auto &inst : func.bbs[bb].insts) {
+            if (inst.kind == Inst::kStore) storeCount[inst.args[1]]++;
+            if (inst.kind == Inst::kCall) hasCall = true;
+        }
+    }
+    std::set<std::string> storedInLoop;
+    for (auto &item : storeCount) storedInLoop.insert(item.first);
+
+    // 循环条件: 一侧为 load @i, 另一侧在循环中不变
+    auto cond = defs.find(br.args[0]);
+    if (cond == defs.end() || cond->second.first != header) return false;
+    const Inst &cmp = headerInsts[cond->second.second];
+    if (cmp.kind != Inst::kBinary) return false;
+    static const std::map<std::string, std::string> swapOp = {{"lt", "gt"}, {"le", "ge"}, {"gt", "lt"}, {"ge", "le"}};
+    if (!swapOp.count(cmp.op)) return false;
+
+    bool found = false;
+    for (int side = 0; side < 2 && !found; side++) {
+        const std::string &ivLoad = cmp.args[side], &bound = cmp.args[1 - side];
+        auto def = defs.find(ivLoad);
+        if (def == defs.end() || def->second.first != header) continue;
+        const Inst &load = headerInsts[def->second.second];
+        if (load.kind != Inst::kLoad) continue;
+        // 循环变量必须是局部标量, 并且在循环中只被 store 一次
+        const std::string &ivar = load.args[0];
+        auto alloc = defs.find(ivar);
+        if (alloc == defs.end()) continue;
+        const Inst &allocInst = func.bbs[alloc->second.first].insts[alloc->second.second];
+        if (allocInst.kind != Inst::kAlloc || allocInst.op != "i32" || storeCount[ivar] != 1) continue;
+        if (!IsLoopInvariant(func, loop, defs, storedInLoop, hasCall, bound)) continue;
+
+        // 找到 store (add (load @i), step), @i
+        for (int bb : loop.blocks) {
+            auto &insts = func.bbs[bb].insts;
+            for (size_t j = 0; j < insts.size(); j++) {
+                if (insts[j].kind != Inst::kStore || insts[j].args[1] != ivar) continue;
+                // store 所在的基本块必须在每次迭代中都执行
+                if (!cfg.Dominates(bb, latch)) return false;
+                auto inc = defs.find(insts[j].args[0]);
+                if (inc == defs.end() || inc->second.first != bb || inc->second.second > (int)j) return false;
+                const Inst &incInst = insts[inc->second.second];
+                if (incInst.kind != Inst::kBinary || (incInst.op != "add" && incInst.op != "sub")) return false;
+                int constSide = IsConstOperand(incInst.args[1]) ? 1 : IsConstOperand(incInst.args[0]) ? 0 : -1;
+                if (constSide == -1 || (incInst.op == "sub" && constSide == 0)) return false;
+                auto old = defs.find(incInst.args[1 - constSide]);
+                if (old == defs.end() || old->second.first != bb || old->second.second > inc->second.second) return false;
+                const Inst &oldInst = insts[old->second.second];
+                if (oldInst.kind != Inst::kLoad || oldInst.args[0] != ivar) return false;
+
+                info.step = atoi(incInst.args[constSide].c_str()) * (incInst.op == "sub" ? -1 : 1);
+                found = true;
+            }
+        }
+        if (!found) return false;
+        info.ivar = ivar;
+        info.ivLoad = ivLoad;
+        info.bound = bound;
+        info.cmpOp = side == 0 ? cmp.op : swapOp.at(cmp.op);
+    }
+    if (!found || info.step == 0) return false;
+    // 循环变量的变化方向必须趋向于退出循环
+    bool increasing = info.cmpOp == "lt" || info.cmpOp == "le";
+    if (increasing != (info.step > 0)) return false;
+
+    info.preheader = preheader;
+    info.header = header;
+    info.latch = latch;
+    info.exit = exit;
+    info.body = func.bbs[body].name;
+
+    // 在 preheader (及其唯一前驱) 中查找循环变量的常量初值
+    info.hasInit = false;
+    int bb = preheader;
+    for (int depth = 0; depth < 4 && bb != -1; depth++) {
+        auto &insts = func.bbs[bb].insts;
+        for (auto it = insts.rbegin(); it != insts.rend(); it++) {
+            if (it->kind == Inst::kStore && it->args[1] == info.ivar) {
+                if (!IsConstOperand(it->args[0])) return true;
+                info.hasInit = true;
+                info.init = atoi(it->args[0].c_str());
+                return true;
+            }
+        }
+        bb = cfg.preds[bb].size() == 1 ? cfg.preds[bb][0] : -1;
+    }
+    return true;
+}
+
+// 计算完全展开的迭代次数, 无法确定时返回 -1
+inline long long GetTripCount(const CountedLoop &info) {
+    if (!info.hasInit || !IsConstOperand(info.bound)) return -1;
+    long long init = info.init, bound = atoll(info.bound.c_str()), step = info.step;
+    if (info.cmpOp == "lt") return init >= bound ? 0 : (bound - init + step - 1) / step;
+    if (info.cmpOp == "le") return init > bound ? 0 : (bound - init) / step + 1;
+    if (info.cmpOp == "gt") return init <= bound ? 0 : (init - bound - step - 1) / -step;
+    if (info.cmpOp == "ge") return init < bound ? 0 : (init - bound) / -step + 1;
+    return -1;
+}
+
+/**************** 常用的变换工具 ****************/
+
+// 把所有 alloc 指令移动到入口基本块的开头
+// 后端为每条 alloc 静态分配栈空间, 循环中的 alloc 每次得到的都是同一块空间, 因此移动不改变语义
+// 移动之后, 复制基本块时不会复制出新的 alloc
+inline void HoistAllocs(Function &func) {
+    if (func.bbs.empty()) return;
+    std::vector<Inst> allocs;
+    for (size_t i = 0; i < func.bbs.size(); i++) {
+        auto &insts = func.bbs[i].insts;
+        std::vector<Inst> rest;
+        for (auto &inst : insts) {
+            if (inst.kind == Inst::kAlloc) {
+                allocs.push_back(inst);
+            } else {
+                rest.push_back(inst);
+            }
+        }
+        insts = rest;
+    }
+    auto &entry = func.bbs[0].insts;
+    entry.insert(entry.begin(), allocs.begin(), allocs.end());
+}
+
+// 复制 blocks 中的基本块: 基本块名和其中定义的符号都加上前缀 tag
+// rename 中预先放入的映射 (例如跳出循环的目标) 优先于默认的重命名
+inline std::vector<BasicBlock> CloneBlocks(const Function &func, const std::vector<int> &blocks,
+                                           const std::string &tag, std::map<std::string, std::string> rename) {
+    for (int bb : blocks) {
+        auto &block = func.bbs[bb];
+        if (!rename.count(block.name)) rename[block.name] = TagSymbol(block.name, tag);
+        for (auto &inst : block.insts) {
+            if (!inst.dest.empty() && !rename.count(inst.dest)) rename[inst.dest] = TagSymbol(inst.dest, tag);
+        }
+    }
+    std::vector<BasicBlock> ret;
+    for (int bb : blocks) {
+        BasicBlock block = func.bbs[bb];
+        block.name = rename[block.name];
+        for (auto &inst : block.insts) {
+            if (!inst.dest.empty()) inst.dest = rename[inst.dest];
+            inst.RenameUses(rename);
+            inst.RenameTargets(rename);
+        }
+        ret.push_back(block);
+    }
+    return ret;
+}
+
+// 按照逆后序重新排列基本块, 并删除不可达的基本块
+// 后端按照基本块的排列顺序生成代码, 并在第一次使用某个值时才为其分配位置
+// 逆后序保证了定义一定出现在使用之前
+inline void SortBlocks(Function &func) {
+    CFGInfo cfg(func);
+    std::vector<BasicBlock> bbs;
+    for (int bb : cfg.rpo) bbs.push_back(func.bbs[bb]);
+    func.bbs = bbs;
+}
+
+/**************** 过程间分析 ****************/
+
+// 函数对全局变量的读写摘要, 包括它直接或间接调用的函数中的读写
+// 标量全局变量只能通过 load/store 直接访问, 因此摘要是精确的
+// 全局数组的地址可能通过参数传给其他函数, 只要出现 getptr/getelemptr 就同时视为读和写
+class ModRefInfo {
+public:
+    std::set<std::string> mod, ref;
+
+    bool Mods(const std::string &global) const {
+        return mod.count(global) != 0;
+    }
+    bool Refs(const std::string &global) const {
+        return ref.count(global) != 0;
+    }
+};
+
+// 计算每个函数的读写摘要, 函数声明 (库函数) 不读写任何全局变量, 不在结果中
+inline std::map<std::string, ModRefInfo> ComputeModRef(const Module &module) {
+    std::set<std::string> globals;
+    for (auto &global : module.globals) globals.insert(global.name);
+
+    std::map<std::string, ModRefInfo> info;
+    std::map<std::string, std::set<std::string> > callees;
+    for (auto &func : module.funcs) {
+        if (func.isDecl) continue;
+        auto &now = info[func.name];
+        for (auto &bb : func.bbs) {
+            for (auto &inst : bb.insts) {
+                if (inst.kind == Inst::kLoad && globals.count(inst.args[0])) {
+                    now.ref.insert(inst.args[0]);
+                } else
+                if (inst.kind == Inst::kStore && globals.count(inst.args[1])) {
+                    now.mod.insert(inst.args[1]);
+                } else
+                if ((inst.kind == Inst::kGetPtr || inst.kind == Inst::kGetElemPtr) && globals.count(inst.args[0])) {
+                    now.mod.insert(inst.args[0]);
+                    now.ref.insert(inst.args[0]);
+                } else
+                if (inst.kind == Inst::kCall) {
+                    callees[func.name].insert(inst.op);
+                }
+            }
+        }
+    }
+
+    // 沿调用图传播到不动点, 递归调用也能收敛
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (auto &item : callees) {
+            auto &now = info[item.first];
+            size_t size = now.mod.size() + now.ref.size();
+            for (auto &callee : item.second) {
+                auto it = info.find(callee);
+                if (it == info.end() || it->first == item.first) continue;
+                now.mod.insert(it->second.mod.begin(), it->second.mod.end());
+                now.ref.insert(it->second.ref.begin(), it->second.ref.end());
+            }
+            if (now.mod.size() + now.ref.size() != size) changed = true;
+        }
+    }
+    return info;
+}
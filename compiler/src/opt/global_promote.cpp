@@ -0,0 +1,205 @@
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// 后端每条指令对应的大致 RISCV 指令条数, 用于估计提升的收益
+// 访问全局变量为 la + lw/sw, 访问局部变量为 li + add + lw/sw, 因此提升后每次访问多一条指令
+const int ACCESS_PENALTY = 1;
+// 基本块中已知局部变量的值时, load 可以直接删除 (la + lw + li + add + sw)
+const int FORWARD_GAIN = 5;
+// 局部变量与全局变量之间的一次同步 (load + store)
+const int SYNC_COST = 11;
+// 循环中的指令的权重
+const int LOOP_WEIGHT = 10;
+
+// 函数 func 中对全局变量 global 的访问方式
+struct GlobalUse {
+    bool load = false, store = false;
+};
+
+// 在函数 func 中把全局变量 global 提升为局部变量 slot 的方案
+class Promotion {
+public:
+    Promotion(Function &func, const map<string, ModRefInfo> &modRef, const string &global, const GlobalUse &use)
+        : func(func), modRef(modRef), global(global), use(use) {}
+
+    // 提升之前调用 callee 时, 需要先把局部变量写回全局变量
+    bool NeedWriteBack(const string &callee) const {
+        auto it = modRef.find(callee);
+        return use.store && it != modRef.end() && (it->second.Mods(global) || it->second.Refs(global));
+    }
+
+    // 调用 callee 之后, 需要重新读取全局变量
+    bool NeedReload(const string &callee) const {
+        auto it = modRef.find(callee);
+        return it != modRef.end() && it->second.Mods(global);
+    }
+
+    // 返回之前需要写回全局变量, main 返回之后程序结束, 不需要写回
+    bool NeedWriteBackAtReturn() const {
+        return use.store && func.name != "@main";
+    }
+
+    // 调用之后紧跟着返回时不需要同步, 保留尾调用
+    static bool IsCallBeforeReturn(const vector<Inst> &insts, size_t i) {
+        return insts[i].kind == Inst::kCall && i + 1 < insts.size() && insts[i + 1].kind == Inst::kReturn;
+    }
+
+    // 返回指令 insts[i] 之前是否需要写回: 紧挨着的调用之前已经写回时不需要
+    // 调用库函数等不需要写回的函数时, 返回之前仍然要写回
+    bool NeedWriteBackBeforeReturn(const vector<Inst> &insts, size_t i) const {
+        if (!NeedWriteBackAtReturn()) return false;
+        return !(i > 0 && IsCallBeforeReturn(insts, i - 1) && NeedWriteBack(insts[i - 1].op));
+    }
+
+    // 估计提升的收益 (减少的指令条数), 按照基本块是否在循环中加权
+    int EstimateGain(const CFGInfo &cfg, const vector<Loop> &loops) const {
+        int gain = -SYNC_COST;
+        for (int bb : cfg.rpo) {
+            int weight = 1;
+            for (auto &loop : loops) {
+                if (loop.Contains(bb)) weight = LOOP_WEIGHT;
+            }
+            auto &insts = func.bbs[bb].insts;
+            bool known = false;
+            for (size_t i = 0; i < insts.size(); i++) {
+                auto &inst = insts[i];
+                if (inst.kind == Inst::kLoad && inst.args[0] == global) {
+                    gain += known ? FORWARD_GAIN * weight : -ACCESS_PENALTY * weight;
+                    known = true;
+                } else
+                if (inst.kind == Inst::kStore && inst.args[1] == global) {
+                    gain -= ACCESS_PENALTY * weight;
+                    known = inst.args[0][0] != '@';
+                } else
+                if (inst.kind == Inst::kCall) {
+                    if (NeedWriteBack(inst.op)) gain -= SYNC_COST * weight;
+                    if (NeedReload(inst.op) && !IsCallBeforeReturn(insts, i)) {
+                        gain -= SYNC_COST * weight;
+                        known = true;
+                    }
+                } else
+                if (inst.kind == Inst::kReturn && NeedWriteBackBeforeReturn(insts, i)) {
+                    gain -= SYNC_COST * weight;
+                }
+            }
+        }
+        return gain;
+    }
+
+    // 进行提升: 入口读取全局变量, 访问全部改为访问局部变量, 在调用与返回处同步
+    // 同一个基本块中已知局部变量的值时, load 直接替换为该值
+    void Apply(const string &tag) {
+        string slot = "%" + tag + global.substr(1);
+        int temps = 0;
+        auto newTemp = [&]() { return "%" + tag + to_string(temps++); };
+        auto load = [&](const string &dest, const string &src) {
+            Inst inst;
+            inst.kind = Inst::kLoad;
+            inst.dest = dest;
+            inst.args = {src};
+            return inst;
+        };
+        auto store = [&](const string &value, const string &dest) {
+            Inst inst;
+            inst.kind = Inst::kStore;
+            inst.args = {value, dest};
+            return inst;
+        };
+        auto sync = [&](vector<Inst> &insts, const string &src, const string &dest) {
+            string temp = newTemp();
+            insts.push_back(load(temp, src));
+            insts.push_back(store(temp, dest));
+            return temp;
+        };
+
+        map<string, string> replace;
+        for (size_t bb = 0; bb < func.bbs.size(); bb++) {
+            auto &old = func.bbs[bb].insts;
+            vector<Inst> insts;
+            string known;
+            if (bb == 0) {
+                Inst alloc;
+                alloc.kind = Inst::kAlloc;
+                alloc.dest = slot;
+                alloc.op = "i32";
+                insts.push_back(alloc);
+                size_t i = 0;
+                while (i < old.size() && old[i].kind == Inst::kAlloc) insts.push_back(old[i++]);
+                known = sync(insts, global, slot);
+                old.erase(old.begin(), old.begin() + i);
+            }
+            for (size_t i = 0; i < old.size(); i++) {
+                Inst inst = old[i];
+                // 先替换已删除的 load, 记录的 known 不会再指向被替换的值
+                inst.RenameUses(replace);
+                if (inst.kind == Inst::kLoad && inst.args[0] == global) {
+                    if (!known.empty()) {
+                        replace[inst.dest] = known;
+                        continue;
+                    }
+                    inst.args[0] = slot;
+                    known = inst.dest;
+                } else
+                if (inst.kind == Inst::kStore && inst.args[1] == global) {
+                    inst.args[1] = slot;
+                    // 函数参数只能在入口使用, 不能向后传递
+                    known = inst.args[0][0] == '@' ? "" : inst.args[0];
+                } else
+                if (inst.kind == Inst::kCall && !IsCallBeforeReturn(old, i)) {
+                    if (NeedWriteBack(inst.op)) sync(insts, slot, global);
+                    insts.push_back(inst);
+                    if (NeedReload(inst.op)) known = sync(insts, global, slot);
+                    continue;
+                } else
+                if (inst.kind == Inst::kCall) {
+                    if (NeedWriteBack(inst.op)) sync(insts, slot, global);
+                } else
+                if (inst.kind == Inst::kReturn && NeedWriteBackBeforeReturn(old, i)) {
+                    sync(insts, slot, global);
+                }
+                insts.push_back(inst);
+            }
+            func.bbs[bb].insts = insts;
+        }
+        // 循环中可能在定义之前使用
+        for (auto &bb : func.bbs) {
+            for (auto &inst : bb.insts) inst.RenameUses(replace);
+        }
+    }
+
+private:
+    Function &func;
+    const map<string, ModRefInfo> &modRef;
+    string global;
+    GlobalUse use;
+};
+
+void PromoteGlobals(Module &module) {
+    set<string> scalars;
+    for (auto &global : module.globals) {
+        if (global.type == "i32") scalars.insert(global.name);
+    }
+    auto modRef = ComputeModRef(module);
+
+    for (auto &func : module.funcs) {
+        if (func.isDecl || func.bbs.empty()) continue;
+        CFGInfo cfg(func);
+        // 入口基本块有前驱时无法在入口处读取全局变量
+        if (!cfg.preds[0].empty()) continue;
+        auto loops = FindLoops(cfg);
+
+        map<string, GlobalUse> uses;
+        for (auto &bb : func.bbs) {
+            for (auto &inst : bb.insts) {
+                if (inst.kind == Inst::kLoad && scalars.count(inst.args[0])) uses[inst.args[0]].load = true;
+                if (inst.kind == Inst::kStore && scalars.count(inst.args[1])) uses[inst.args[1]].store = true;
+            }
+        }
+        for (auto &item : uses) {
+            Promotion promotion(func, modRef, item.first, item.second);
+            if (promotion.EstimateGain(cfg, loops) <= 0) continue;
+            promotion.Apply(module.NewTag("promote"));
+        }
+    }
+}
@@ -0,0 +1,174 @@
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// 转换后两个分支的指令都要执行, 并且每个变量多 3~4 条选择指令, 总指令数通常会增加, 换来的是没有难以预测的跳转
+// 因此只在 -O3 中使用, 并且只转换很短的分支
+// 每个分支中提前执行的指令 (store 除外) 的最大条数
+const int IFCVT_MAX_INSTS = 4;
+// 最多需要选择的变量个数, 每个变量的选择需要 3 条指令
+const int IFCVT_MAX_SELECTS = 2;
+
+// 条件跳转的一个分支: 只有一个前驱, 以 jump 结尾, 只读写标量变量, 不调用函数, 不做除法
+// 执行之后各个标量变量中的值
+struct IfSide {
+    vector<Inst> insts;             // 提前执行的指令 (已删除 store, 读取本分支写入的变量的 load 已替换为写入的值)
+    map<string, string> stores;     // 变量 => 分支结束时的值
+};
+
+class IfConverter {
+public:
+    IfConverter(Module &module, Function &func) : module(module), func(func) {
+        for (auto &global : module.globals) {
+            if (global.type == "i32") scalars.insert(global.name);
+        }
+        for (auto &bb : func.bbs) {
+            for (auto &inst : bb.insts) {
+                if (inst.kind == Inst::kAlloc && inst.op == "i32") scalars.insert(inst.dest);
+                if (inst.kind == Inst::kBinary) compares[inst.dest] = IsCompare(inst.op);
+            }
+        }
+    }
+
+    // 找到一个可以转换的条件跳转并转换, 没有时返回 false
+    bool ConvertOne() {
+        CFGInfo cfg(func);
+        index = func.BlockIndex();
+        for (int bb : cfg.rpo) {
+            const Inst &term = func.bbs[bb].Terminator();
+            if (term.kind != Inst::kBranch) continue;
+            int t = index.at(term.targets[0]), f = index.at(term.targets[1]);
+            if (t == f) continue;
+
+            // 菱形: 两个分支跳转到同一个基本块; 三角形: 一个分支跳转到另一个目标
+            int thenBB = -1, elseBB = -1, join = -1;
+            if (IsSideBlock(cfg, bb, t) && IsSideBlock(cfg, bb, f) && JumpTarget(t) == JumpTarget(f)) {
+                thenBB = t, elseBB = f, join = JumpTarget(t);
+            } else
+            if (IsSideBlock(cfg, bb, t) && JumpTarget(t) == f) {
+                thenBB = t, join = f;
+            } else
+            if (IsSideBlock(cfg, bb, f) && JumpTarget(f) == t) {
+                elseBB = f, join = t;
+            } else {
+                continue;
+            }
+            if (join == bb) continue;
+
+            IfSide thenSide, elseSide;
+            if (thenBB != -1 && !Speculate(thenBB, thenSide)) continue;
+            if (elseBB != -1 && !Speculate(elseBB, elseSide)) continue;
+            set<string> slots;
+            for (auto &item : thenSide.stores) slots.insert(item.first);
+            for (auto &item : elseSide.stores) slots.insert(item.first);
+            if (slots.size() > (size_t)IFCVT_MAX_SELECTS) continue;
+
+            Apply(bb, join, thenSide, elseSide, slots);
+            return true;
+        }
+        return false;
+    }
+
+private:
+    Module &module;
+    Function &func;
+    set<string> scalars;            // 标量变量 (局部变量与全局变量)
+    map<string, bool> compares;     // 二元运算的结果 => 是否是比较运算 (结果只能是 0/1)
+    map<string, int> index;         // 基本块名 => 下标
+
+    static bool IsCompare(const string &op) {
+        return op == "eq" || op == "ne" || op == "lt" || op == "gt" || op == "le" || op == "ge";
+    }
+
+    int JumpTarget(int bb) const {
+        return index.at(func.bbs[bb].Terminator().targets[0]);
+    }
+
+    // bb 是否是 from 的条件跳转中可以提前执行的分支
+    bool IsSideBlock(const CFGInfo &cfg, int from, int bb) const {
+        return bb != 0 && bb != from && cfg.preds[bb].size() == 1 && func.bbs[bb].Terminator().kind == Inst::kJump;
+    }
+
+    // 检查分支能否无条件执行, 并整理出需要提前执行的指令与写入的值
+    bool Speculate(int bb, IfSide &side) const {
+        map<string, string> rename;
+        int count = 0;
+        auto &insts = func.bbs[bb].insts;
+        for (size_t i = 0; i + 1 < insts.size(); i++) {
+            Inst inst = insts[i];
+            inst.RenameUses(rename);
+            if (inst.kind == Inst::kLoad && side.stores.count(inst.args[0])) {
+                rename[inst.dest] = side.stores[inst.args[0]];
+                continue;
+            }
+            if (inst.kind == Inst::kStore && scalars.count(inst.args[1])) {
+                // 函数参数只能在入口使用
+                if (inst.args[0][0] == '@') return false;
+                side.stores[inst.args[1]] = inst.args[0];
+                continue;
+            }
+            bool safe = (inst.kind == Inst::kLoad && scalars.count(inst.args[0])) ||
+                        (inst.kind == Inst::kBinary && inst.op != "div" && inst.op != "mod");
+            if (!safe) return false;
+            side.insts.push_back(inst);
+            if (++count > IFCVT_MAX_INSTS) return false;
+        }
+        return true;
+    }
+
+    // 把 bb 的条件跳转替换为两个分支的指令加上按掩码选择的结果, 再无条件跳转到 join
+    //   mask = 0 - (cond != 0)
+    //   x = else ^ ((then ^ else) & mask)
+    void Apply(int bb, int join, const IfSide &thenSide, const IfSide &elseSide, const set<string> &slots) {
+        string tag = module.NewTag("ifcvt");
+        int temps = 0;
+        auto &insts = func.bbs[bb].insts;
+        Inst branch = insts.back();
+        insts.pop_back();
+        auto emit = [&](Inst::Kind kind, const string &op, const vector<string> &args) {
+            Inst inst;
+            inst.kind = kind;
+            inst.op = op;
+            inst.args = args;
+            if (kind != Inst::kStore) inst.dest = "%" + tag + to_string(temps++);
+            insts.push_back(inst);
+            return inst.dest;
+        };
+
+        insts.insert(insts.end(), thenSide.insts.begin(), thenSide.insts.end());
+        insts.insert(insts.end(), elseSide.insts.begin(), elseSide.insts.end());
+        // 只在一个分支中写入的变量, 另一个分支中的值为原来的值
+        map<string, string> old;
+        for (auto &slot : slots) {
+            if (!thenSide.stores.count(slot) || !elseSide.stores.count(slot)) old[slot] = emit(Inst::kLoad, "", {slot});
+        }
+        string cond = branch.args[0];
+        if (!compares.count(cond) || !compares[cond]) cond = emit(Inst::kBinary, "ne", {cond, "0"});
+        string mask = emit(Inst::kBinary, "sub", {"0", cond});
+        for (auto &slot : slots) {
+            string thenValue = thenSide.stores.count(slot) ? thenSide.stores.at(slot) : old[slot];
+            string elseValue = elseSide.stores.count(slot) ? elseSide.stores.at(slot) : old[slot];
+            string value = thenValue;
+            if (thenValue != elseValue) {
+                string diff = emit(Inst::kBinary, "xor", {thenValue, elseValue});
+                string masked = emit(Inst::kBinary, "and", {diff, mask});
+                value = emit(Inst::kBinary, "xor", {elseValue, masked});
+            }
+            emit(Inst::kStore, "", {value, slot});
+        }
+
+        Inst jump;
+        jump.kind = Inst::kJump;
+        jump.targets = {func.bbs[join].name};
+        insts.push_back(jump);
+        // 两个分支不再可达, 由 SortBlocks 删除
+        SortBlocks(func);
+    }
+};
+
+void IfConvert(Module &module) {
+    for (auto &func : module.funcs) {
+        if (func.isDecl || func.bbs.empty()) continue;
+        while (IfConverter(module, func).ConvertOne()) {}
+    }
+}
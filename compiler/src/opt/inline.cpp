@@ -0,0 +1,215 @@
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// 一次函数调用的基础开销 (建立/销毁栈帧, 保存/恢复 a0 和 ra), 以指令条数计
+const int INLINE_CALL_COST = 8;
+// 每个实参的开销; 实参为常量时, 内联后还可以进一步化简
+const int INLINE_ARG_COST = 1;
+const int INLINE_CONST_ARG_BONUS = 2;
+// 内联后调用者的最大指令条数
+const int INLINE_MAX_CALLER_SIZE = 4000;
+
+/**************** 调用图 ****************/
+
+// 函数名 => 调用的 (有定义的) 函数
+static map<string, set<string> > BuildCallGraph(Module &module) {
+    map<string, set<string> > callees;
+    for (auto &func : module.funcs) {
+        if (func.isDecl) continue;
+        callees[func.name];
+        for (auto &bb : func.bbs) {
+            for (auto &inst : bb.insts) {
+                if (inst.kind != Inst::kCall) continue;
+                Function *callee = module.GetFunction(inst.op);
+                if (callee != nullptr && !callee->isDecl) callees[func.name].insert(inst.op);
+            }
+        }
+    }
+    return callees;
+}
+
+// Tarjan 算法求强连通分量, 得到的分量顺序即为自底向上的顺序 (被调用者在前)
+class SCCFinder {
+public:
+    vector<vector<string> > sccs;
+
+    SCCFinder(const map<string, set<string> > &graph) : graph(graph) {
+        for (auto &item : graph) {
+            if (!index.count(item.first)) Visit(item.first);
+        }
+    }
+
+private:
+    const map<string, set<string> > &graph;
+    map<string, int> index, lowlink;
+    set<string> onStack;
+    vector<string> stack;
+    int count = 0;
+
+    void Visit(const string &func) {
+        index[func] = lowlink[func] = count++;
+        stack.push_back(func);
+        onStack.insert(func);
+        for (auto &callee : graph.at(func)) {
+            if (!index.count(callee)) {
+                Visit(callee);
+                lowlink[func] = min(lowlink[func], lowlink[callee]);
+            } else
+            if (onStack.count(callee)) {
+                lowlink[func] = min(lowlink[func], index[callee]);
+            }
+        }
+        if (lowlink[func] == index[func]) {
+            vector<string> scc;
+            string now;
+            do {
+                now = stack.back();
+                stack.pop_back();
+                onStack.erase(now);
+                scc.push_back(now);
+            } while (now != func);
+            sccs.push_back(scc);
+        }
+    }
+};
+
+/**************** 内联 ****************/
+
+// 内联的代价: 被调用函数的大小减去内联带来的收益, 不超过阈值时内联
+static int InlineCost(const Function &callee, const Inst &call) {
+    int cost = callee.InstCount() - INLINE_CALL_COST;
+    for (auto &arg : call.args) {
+        cost -= INLINE_ARG_COST;
+        if (IsConstOperand(arg)) cost -= INLINE_CONST_ARG_BONUS;
+    }
+    return cost;
+}
+
+// 把 caller.bbs[bbIndex].insts[instIndex] 处的调用替换为被调用函数的函数体
+// 调用所在的基本块在调用处拆分, 调用之后的指令放入新的基本块 cont, 返回 cont 的下标
+static int InlineCall(Module &module, Function &caller, int bbIndex, int instIndex, const Function &callee) {
+    string tag = module.NewTag("inline");
+    Inst call = caller.bbs[bbIndex].insts[instIndex];
+
+    // 形参替换为实参
+    map<string, string> rename;
+    for (size_t i = 0; i < callee.params.size(); i++) rename[callee.params[i].first] = call.args[i];
+    vector<int> blocks;
+    for (size_t i = 0; i < callee.bbs.size(); i++) blocks.push_back(i);
+    vector<BasicBlock> body = CloneBlocks(callee, blocks, tag, rename);
+
+    BasicBlock cont;
+    cont.name = "%" + tag + "cont";
+    auto &insts = caller.bbs[bbIndex].insts;
+    cont.insts.assign(insts.begin() + instIndex + 1, insts.end());
+    insts.erase(insts.begin() + instIndex, insts.end());
+    Inst jump;
+    jump.kind = Inst::kJump;
+    jump.targets.push_back(body[0].name);
+    insts.push_back(jump);
+
+    // ret 替换为跳转到 cont, 返回值只有一个来源时直接使用, 否则通过栈上的临时变量传递
+    vector<Inst *> rets;
+    for (auto &bb : body) {
+        if (bb.Terminator().kind == Inst::kReturn) rets.push_back(&bb.Terminator());
+    }
+    string slot = "%" + tag + "ret";
+    if (!call.dest.empty() && rets.size() > 1) {
+        Inst alloc;
+        alloc.kind = Inst::kAlloc;
+        alloc.dest = slot;
+        alloc.op = "i32";
+        caller.bbs[0].insts.insert(caller.bbs[0].insts.begin(), alloc);
+        Inst load;
+        load.kind = Inst::kLoad;
+        load.dest = call.dest;
+        load.args.push_back(slot);
+        cont.insts.insert(cont.insts.begin(), load);
+    }
+    string result;
+    for (auto ret : rets) {
+        if (!call.dest.empty()) {
+            if (rets.size() > 1) {
+                Inst store;
+                store.kind = Inst::kStore;
+                store.args = {ret->args[0], slot};
+                // ret 是基本块的最后一条指令, 在其之前插入 store
+                for (auto &bb : body) {
+                    if (&bb.Terminator() == ret) {
+                        bb.insts.insert(bb.insts.end() - 1, store);
+                        ret = &bb.Terminator();
+                        break;
+                    }
+                }
+            } else {
+                result = ret->args[0];
+            }
+        }
+        ret->kind = Inst::kJump;
+        ret->args.clear();
+        ret->targets = {cont.name};
+    }
+    if (!call.dest.empty() && rets.size() == 1) {
+        map<string, string> replace = {{call.dest, result}};
+        for (auto &bb : caller.bbs) {
+            for (auto &inst : bb.insts) inst.RenameUses(replace);
+        }
+        for (auto &inst : cont.insts) inst.RenameUses(replace);
+    }
+
+    body.push_back(cont);
+    caller.bbs.insert(caller.bbs.begin() + bbIndex + 1, body.begin(), body.end());
+    return bbIndex + body.size();
+}
+
+// 在 caller 中内联满足代价要求的调用
+static void InlineCallsIn(Module &module, Function &caller, const set<string> &sameSCC, int threshold) {
+    // 只扫描 caller 原有的指令, 被内联进来的函数体已经在处理被调用函数时优化过了
+    for (size_t bb = 0; bb < caller.bbs.size(); bb++) {
+        for (size_t i = 0; i < caller.bbs[bb].insts.size(); i++) {
+            const Inst &inst = caller.bbs[bb].insts[i];
+            if (inst.kind != Inst::kCall || sameSCC.count(inst.op)) continue;
+            Function *callee = module.GetFunction(inst.op);
+            if (callee == nullptr || callee->isDecl || callee->bbs.empty()) continue;
+            if (InlineCost(*callee, inst) > threshold) continue;
+            if (caller.InstCount() + callee->InstCount() > INLINE_MAX_CALLER_SIZE) continue;
+
+            // InlineCall 会改变 caller.bbs, 之后从 cont 的开头继续扫描
+            bb = InlineCall(module, caller, bb, i, *callee);
+            i = -1;
+        }
+    }
+    HoistAllocs(caller);
+    SortBlocks(caller);
+}
+
+// 删除不会被 main 调用到的函数
+static void RemoveDeadFunctions(Module &module) {
+    auto callees = BuildCallGraph(module);
+    set<string> alive;
+    vector<string> work = {"@main"};
+    while (!work.empty()) {
+        string now = work.back();
+        work.pop_back();
+        if (!callees.count(now) || !alive.insert(now).second) continue;
+        for (auto &callee : callees[now]) work.push_back(callee);
+    }
+    vector<Function> funcs;
+    for (auto &func : module.funcs) {
+        if (func.isDecl || alive.count(func.name)) funcs.push_back(func);
+    }
+    module.funcs = funcs;
+}
+
+void Inline(Module &module, int threshold) {
+    auto callees = BuildCallGraph(module);
+    SCCFinder finder(callees);
+    for (auto &scc : finder.sccs) {
+        set<string> sameSCC(scc.begin(), scc.end());
+        for (auto &name : scc) {
+            InlineCallsIn(module, *module.GetFunction(name), sameSCC, threshold);
+        }
+    }
+    if (module.GetFunction("@main") != nullptr) RemoveDeadFunctions(module);
+}
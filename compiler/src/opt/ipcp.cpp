@@ -0,0 +1,241 @@
+#include <climits>
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// 特化的函数的最大指令条数
+const int SPECIALIZE_MAX_SIZE = 200;
+// 同一组常量实参的调用点的总权重不少于该值时进行特化, 循环中的调用点权重为 LOOP_CALL_WEIGHT
+const int SPECIALIZE_MIN_WEIGHT = 2;
+const int LOOP_CALL_WEIGHT = 10;
+// 每个函数最多的特化版本数
+const int SPECIALIZE_MAX_COUNT = 2;
+
+/**************** 常量折叠 ****************/
+
+// 计算两个常量的二元运算, 不能在编译期计算 (除以 0) 时返回 false
+static bool EvalBinary(const string &op, int a, int b, int &result) {
+    unsigned ua = a, ub = b;
+    if (op == "add") result = ua + ub;
+    else if (op == "sub") result = ua - ub;
+    else if (op == "mul") result = ua * ub;
+    else if (op == "div" || op == "mod") {
+        if (b == 0 || (a == INT_MIN && b == -1)) return false;
+        result = op == "div" ? a / b : a % b;
+    }
+    else if (op == "and") result = a & b;
+    else if (op == "or") result = a | b;
+    else if (op == "xor") result = a ^ b;
+    else if (op == "shl") result = ua << (b & 31);
+    else if (op == "shr") result = ua >> (b & 31);
+    else if (op == "sar") result = a >> (b & 31);
+    else if (op == "eq") result = a == b;
+    else if (op == "ne") result = a != b;
+    else if (op == "lt") result = a < b;
+    else if (op == "gt") result = a > b;
+    else if (op == "le") result = a <= b;
+    else if (op == "ge") result = a >= b;
+    else return false;
+    return true;
+}
+
+// 操作数都是常量的二元运算直接替换为结果
+static bool FoldConstants(Function &func) {
+    map<string, string> replace;
+    for (auto &bb : func.bbs) {
+        vector<Inst> insts;
+        for (auto &inst : bb.insts) {
+            inst.RenameUses(replace);
+            int result;
+            if (inst.kind == Inst::kBinary && IsConstOperand(inst.args[0]) && IsConstOperand(inst.args[1]) &&
+                EvalBinary(inst.op, atoi(inst.args[0].c_str()), atoi(inst.args[1].c_str()), result)) {
+                replace[inst.dest] = to_string(result);
+                continue;
+            }
+            insts.push_back(inst);
+        }
+        bb.insts = insts;
+    }
+    if (replace.empty()) return false;
+    // 基本块按照逆后序排列, 但循环中可能在定义之前使用
+    for (auto &bb : func.bbs) {
+        for (auto &inst : bb.insts) inst.RenameUses(replace);
+    }
+    return true;
+}
+
+// 只被 store 过一次常量, 并且只被 load 的局部变量 (例如传入常量的参数): load 直接替换为该常量
+static bool PropagateConstantSlots(Function &func) {
+    CFGInfo cfg(func);
+    // 局部变量 => (store 的位置, 存入的值), 不满足条件的局部变量值为空
+    map<string, pair<pair<int, int>, string> > slots;
+    set<string> rejected;
+    for (size_t bb = 0; bb < func.bbs.size(); bb++) {
+        auto &insts = func.bbs[bb].insts;
+        for (size_t i = 0; i < insts.size(); i++) {
+            auto &inst = insts[i];
+            if (inst.kind == Inst::kAlloc && inst.op == "i32") slots[inst.dest];
+            if (inst.kind == Inst::kStore) {
+                if (slots.count(inst.args[1]) && slots[inst.args[1]].second.empty() && IsConstOperand(inst.args[0])) {
+                    slots[inst.args[1]] = make_pair(make_pair(bb, i), inst.args[0]);
+                } else {
+                    rejected.insert(inst.args[1]);
+                }
+                rejected.insert(inst.args[0]);
+            } else
+            if (inst.kind != Inst::kLoad) {
+                // 除了 load/store 以外的使用 (例如作为函数的实参) 都可能修改局部变量
+                for (auto &arg : inst.args) rejected.insert(arg);
+            }
+        }
+    }
+
+    // 所有的 load 都必须在 store 之后
+    map<string, string> replace;
+    for (size_t bb = 0; bb < func.bbs.size(); bb++) {
+        auto &insts = func.bbs[bb].insts;
+        for (size_t i = 0; i < insts.size(); i++) {
+            auto &inst = insts[i];
+            if (inst.kind != Inst::kLoad) continue;
+            auto it = slots.find(inst.args[0]);
+            if (it == slots.end() || rejected.count(inst.args[0]) || it->second.second.empty()) continue;
+            int storeBB = it->second.first.first, storeIndex = it->second.first.second;
+            bool dominated = storeBB == (int)bb ? storeIndex < (int)i : cfg.Dominates(storeBB, bb);
+            if (dominated) replace[inst.dest] = it->second.second;
+        }
+    }
+    if (replace.empty()) return false;
+    for (auto &bb : func.bbs) {
+        vector<Inst> insts;
+        for (auto &inst : bb.insts) {
+            if (replace.count(inst.dest)) continue;
+            inst.RenameUses(replace);
+            insts.push_back(inst);
+        }
+        bb.insts = insts;
+    }
+    return true;
+}
+
+// 把常量实参代入函数 func
+static void PropagateArguments(Function &func, const map<int, string> &consts) {
+    map<string, string> replace;
+    for (auto &item : consts) replace[func.params[item.first].first] = item.second;
+    for (auto &bb : func.bbs) {
+        for (auto &inst : bb.insts) inst.RenameUses(replace);
+    }
+    bool changed = true;
+    while (changed) {
+        changed = PropagateConstantSlots(func);
+        changed |= FoldConstants(func);
+    }
+}
+
+/**************** 过程间常量传播 ****************/
+
+// 调用点
+struct CallSite {
+    string caller;
+    int bb, inst;
+    int weight;                 // 循环中的调用点权重更高
+    map<int, string> consts;    // 参数下标 => 常量实参
+};
+
+// 收集所有调用 callee 的调用点
+static vector<CallSite> CollectCallSites(Module &module, const string &callee) {
+    vector<CallSite> sites;
+    for (auto &func : module.funcs) {
+        if (func.isDecl || func.bbs.empty()) continue;
+        CFGInfo cfg(func);
+        auto loops = FindLoops(cfg);
+        for (size_t bb = 0; bb < func.bbs.size(); bb++) {
+            auto &insts = func.bbs[bb].insts;
+            for (size_t i = 0; i < insts.size(); i++) {
+                if (insts[i].kind != Inst::kCall || insts[i].op != callee) continue;
+                CallSite site;
+                site.caller = func.name;
+                site.bb = bb;
+                site.inst = i;
+                site.weight = 1;
+                for (auto &loop : loops) {
+                    if (loop.Contains(bb)) site.weight = LOOP_CALL_WEIGHT;
+                }
+                for (size_t k = 0; k < insts[i].args.size(); k++) {
+                    if (IsConstOperand(insts[i].args[k])) site.consts[k] = insts[i].args[k];
+                }
+                sites.push_back(site);
+            }
+        }
+    }
+    return sites;
+}
+
+// 处理函数 name: 所有调用点传入同一个常量的参数直接代入; 否则为常见的常量实参组合生成特化版本
+static void SpecializeFunction(Module &module, const string &name) {
+    auto sites = CollectCallSites(module, name);
+    if (sites.empty()) return;
+
+    // 所有调用点都相同的常量实参
+    map<int, string> common = sites[0].consts;
+    for (auto &site : sites) {
+        for (auto it = common.begin(); it != common.end();) {
+            auto found = site.consts.find(it->first);
+            if (found == site.consts.end() || found->second != it->second) {
+                it = common.erase(it);
+            } else {
+                it++;
+            }
+        }
+    }
+    if (!common.empty()) PropagateArguments(*module.GetFunction(name), common);
+
+    // 其余的常量实参组合, 按照调用点的总权重选择
+    map<map<int, string>, int> weights;
+    for (auto &site : sites) {
+        map<int, string> consts;
+        for (auto &item : site.consts) {
+            if (!common.count(item.first)) consts.insert(item);
+        }
+        if (!consts.empty()) weights[consts] += site.weight;
+    }
+    vector<pair<int, map<int, string> > > candidates;
+    for (auto &item : weights) {
+        if (item.second >= SPECIALIZE_MIN_WEIGHT) candidates.push_back(make_pair(item.second, item.first));
+    }
+    sort(candidates.begin(), candidates.end(), [](const pair<int, map<int, string> > &a, const pair<int, map<int, string> > &b) {
+        return a.first > b.first;
+    });
+    if (candidates.size() > SPECIALIZE_MAX_COUNT) candidates.resize(SPECIALIZE_MAX_COUNT);
+    if (module.GetFunction(name)->InstCount() > SPECIALIZE_MAX_SIZE) return;
+
+    for (auto &candidate : candidates) {
+        // 复制函数, 基本块名作为汇编标号, 必须在整个程序中唯一
+        const Function &func = *module.GetFunction(name);
+        string tag = module.NewTag("spec");
+        Function clone = func;
+        clone.name = "@" + tag + name.substr(1);
+        vector<int> blocks;
+        for (size_t i = 0; i < func.bbs.size(); i++) blocks.push_back(i);
+        clone.bbs = CloneBlocks(func, blocks, tag, {});
+        PropagateArguments(clone, candidate.second);
+
+        // 常量实参组合相同的调用点改为调用特化版本
+        for (auto &site : sites) {
+            bool match = true;
+            for (auto &item : candidate.second) {
+                auto found = site.consts.find(item.first);
+                if (found == site.consts.end() || found->second != item.second) match = false;
+            }
+            if (match) module.GetFunction(site.caller)->bbs[site.bb].insts[site.inst].op = clone.name;
+        }
+        module.funcs.push_back(clone);
+    }
+}
+
+void IPConstProp(Module &module) {
+    vector<string> names;
+    for (auto &func : module.funcs) {
+        if (!func.isDecl && !func.bbs.empty() && func.name != "@main") names.push_back(func.name);
+    }
+    for (auto &name : names) SpecializeFunction(module, name);
+}
@@ -0,0 +1,149 @@
+#include <functional>
+#include "passes.hpp"
+#include "alias.hpp"
+using namespace std;
+
+// 冗余 load 消除: 已知某个位置的值 (之前 store 进去或 load 出来) 时, load 直接使用该值
+// 在基本块内进行, 只有一个前驱的基本块沿用前驱结束时的结果
+static bool EliminateRedundantLoads(Function &func, const AliasAnalysis &aa) {
+    CFGInfo cfg(func);
+    // 每个基本块结束时已知的 (指针, 值)
+    vector<vector<pair<string, string> > > out(func.bbs.size());
+    map<string, string> replace;
+    for (int bb : cfg.rpo) {
+        vector<pair<string, string> > avail;
+        if (cfg.preds[bb].size() == 1 && cfg.rpoIndex[cfg.preds[bb][0]] < cfg.rpoIndex[bb]) {
+            avail = out[cfg.preds[bb][0]];
+        }
+        vector<Inst> insts;
+        for (auto inst : func.bbs[bb].insts) {
+            inst.RenameUses(replace);
+            if (inst.kind == Inst::kLoad) {
+                string known;
+                for (auto &item : avail) {
+                    if (aa.Alias(item.first, inst.args[0]) == kMustAlias) known = item.second;
+                }
+                if (!known.empty()) {
+                    replace[inst.dest] = known;
+                    continue;
+                }
+                avail.push_back(make_pair(inst.args[0], inst.dest));
+            } else
+            if (inst.kind == Inst::kStore) {
+                vector<pair<string, string> > rest;
+                for (auto &item : avail) {
+                    if (aa.Alias(item.first, inst.args[1]) == kNoAlias) rest.push_back(item);
+                }
+                avail = rest;
+                // 函数参数只能在入口使用, 不能向后传递
+                if (inst.args[0][0] != '@') avail.push_back(make_pair(inst.args[1], inst.args[0]));
+            } else
+            if (inst.kind == Inst::kCall) {
+                vector<pair<string, string> > rest;
+                for (auto &item : avail) {
+                    if (!aa.CallMayAccess(inst, item.first, true)) rest.push_back(item);
+                }
+                avail = rest;
+            }
+            insts.push_back(inst);
+        }
+        func.bbs[bb].insts = insts;
+        out[bb] = avail;
+    }
+    if (replace.empty()) return false;
+    for (auto &bb : func.bbs) {
+        for (auto &inst : bb.insts) inst.RenameUses(replace);
+    }
+    return true;
+}
+
+// 死 store 消除: 基本块内被之后的 store 完全覆盖, 且中间没有被读取的 store
+// 以及返回之前还没有被读取的, 对局部变量的 store
+static bool EliminateDeadStores(Function &func, const AliasAnalysis &aa) {
+    bool changed = false;
+    for (auto &bb : func.bbs) {
+        auto &insts = bb.insts;
+        vector<bool> dead(insts.size(), false);
+        vector<int> pending;
+        auto filter = [&](function<bool(const string &)> read) {
+            vector<int> rest;
+            for (int j : pending) {
+                if (!read(insts[j].args[1])) rest.push_back(j);
+            }
+            pending = rest;
+        };
+        for (size_t i = 0; i < insts.size(); i++) {
+            auto &inst = insts[i];
+            if (inst.kind == Inst::kLoad) {
+                filter([&](const string &ptr) { return aa.Alias(ptr, inst.args[0]) != kNoAlias; });
+            } else
+            if (inst.kind == Inst::kStore) {
+                for (int j : pending) {
+                    if (aa.Alias(insts[j].args[1], inst.args[1]) == kMustAlias) dead[j] = true;
+                }
+                filter([&](const string &ptr) { return aa.Alias(ptr, inst.args[1]) != kNoAlias; });
+                pending.push_back(i);
+            } else
+            if (inst.kind == Inst::kCall) {
+                filter([&](const string &ptr) { return aa.CallMayAccess(inst, ptr, false); });
+            } else
+            if (inst.kind == Inst::kReturn) {
+                for (int j : pending) {
+                    if (aa.Locate(insts[j].args[1]).kind == MemLocation::kLocal) dead[j] = true;
+                }
+            }
+        }
+        vector<Inst> rest;
+        for (size_t i = 0; i < insts.size(); i++) {
+            if (dead[i]) {
+                changed = true;
+            } else {
+                rest.push_back(insts[i]);
+            }
+        }
+        insts = rest;
+    }
+    return changed;
+}
+
+// 只被 store, 从来没有被读取的局部变量, 删除它和所有对它的 store
+static bool RemoveDeadSlots(Function &func) {
+    set<string> slots;
+    for (auto &bb : func.bbs) {
+        for (auto &inst : bb.insts) {
+            if (inst.kind == Inst::kAlloc) slots.insert(inst.dest);
+        }
+    }
+    for (auto &bb : func.bbs) {
+        for (auto &inst : bb.insts) {
+            for (size_t i = 0; i < inst.args.size(); i++) {
+                if (inst.kind == Inst::kStore && i == 1) continue;
+                slots.erase(inst.args[i]);
+            }
+        }
+    }
+    if (slots.empty()) return false;
+    for (auto &bb : func.bbs) {
+        vector<Inst> insts;
+        for (auto &inst : bb.insts) {
+            if (inst.kind == Inst::kAlloc && slots.count(inst.dest)) continue;
+            if (inst.kind == Inst::kStore && slots.count(inst.args[1])) continue;
+            insts.push_back(inst);
+        }
+        bb.insts = insts;
+    }
+    return true;
+}
+
+void LoadStoreOpt(Module &module) {
+    auto modRef = ComputeModRef(module);
+    for (auto &func : module.funcs) {
+        if (func.isDecl || func.bbs.empty()) continue;
+        bool changed = true;
+        while (changed) {
+            changed = EliminateRedundantLoads(func, AliasAnalysis(module, func, modRef));
+            changed |= EliminateDeadStores(func, AliasAnalysis(module, func, modRef));
+            changed |= RemoveDeadSlots(func);
+        }
+    }
+}
@@ -0,0 +1,248 @@
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// 运行时库函数, 由后端在程序用到时生成
+//   __memset_i32(dst, value, count)    dst[0..count) = value
+//   __memcpy_i32(dst, src, count)      按下标从小到大逐个 dst[i] = src[i], 与原循环的语义相同
+const string MEMSET_FUNC = "@__memset_i32";
+const string MEMCPY_FUNC = "@__memcpy_i32";
+// 迭代次数已知且少于该值的循环交给循环展开处理
+const int IDIOM_MIN_TRIP = 8;
+
+// 逐个元素赋值/复制的循环, 形如:
+//   header: %iv = load @i; %cond = lt %iv, bound; br %cond, body, exit
+//   body:   store value, (getelemptr dst, (load @i))                      (memset)
+//           store (load (getelemptr src, (load @i))), (getelemptr dst, (load @i))   (memcpy)
+//           store (add (load @i), 1), @i; jump header
+struct LoopIdiom {
+    bool isCopy;
+    Inst dst, src;              // 循环体中计算元素地址的 getelemptr/getptr
+    string value;               // memset 存入的值
+    vector<Inst> invariants;    // 循环体中与循环无关的计算, 需要移动到 preheader 中
+};
+
+class IdiomMatcher {
+public:
+    IdiomMatcher(const Module &module, const Function &func, const Loop &loop, const CountedLoop &info)
+        : func(func), loop(loop), info(info) {
+        for (auto &global : module.globals) globals[global.name] = global.type;
+        for (auto &bb : func.bbs) {
+            for (auto &inst : bb.insts) {
+                if (inst.kind == Inst::kAlloc) allocs[inst.dest] = inst.op;
+            }
+        }
+        for (int bb : loop.blocks) {
+            for (auto &inst : func.bbs[bb].insts) {
+                if (!inst.dest.empty()) definedInLoop.insert(inst.dest);
+                if (inst.kind == Inst::kStore) storedInLoop.insert(inst.args[1]);
+            }
+        }
+    }
+
+    bool Match(LoopIdiom &idiom) {
+        if (loop.blocks.size() != 2 || info.step != 1 || (info.cmpOp != "lt" && info.cmpOp != "le")) return false;
+        auto index = func.BlockIndex();
+        int body = index.at(info.body);
+        if (body != info.latch) return false;
+
+        // 循环体中每个值的类别
+        enum Kind { kInvariant, kIndex, kNext, kElemPtr, kElemLoad };
+        map<string, Kind> kinds;
+        map<string, Inst> elemPtrs;
+        auto invariant = [&](const string &value) {
+            if (IsConstOperand(value)) return true;
+            // 函数参数只能在入口使用, 不能移动到其他位置
+            if (!definedInLoop.count(value)) return value[0] == '%' || globals.count(value) || allocs.count(value);
+            return kinds.count(value) && kinds[value] == kInvariant;
+        };
+        auto is = [&](const string &value, Kind kind) {
+            return kinds.count(value) && kinds[value] == kind;
+        };
+
+        bool stepped = false, stored = false;
+        auto &insts = func.bbs[body].insts;
+        for (size_t i = 0; i + 1 < insts.size(); i++) {
+            auto &inst = insts[i];
+            if (inst.kind == Inst::kLoad && inst.args[0] == info.ivar) {
+                if (stepped) return false;
+                kinds[inst.dest] = kIndex;
+            } else
+            if (inst.kind == Inst::kLoad && is(inst.args[0], kElemPtr)) {
+                if (stored) return false;
+                kinds[inst.dest] = kElemLoad;
+                idiom.src = elemPtrs[inst.args[0]];
+            } else
+            if (inst.kind == Inst::kLoad) {
+                // 循环中没有被修改的标量
+                const string &src = inst.args[0];
+                bool scalar = globals.count(src) ? globals[src] == "i32" : allocs.count(src) && allocs[src][0] != '[';
+                if (!scalar || storedInLoop.count(src)) return false;
+                kinds[inst.dest] = kInvariant;
+                idiom.invariants.push_back(inst);
+            } else
+            if (inst.kind == Inst::kBinary) {
+                if (invariant(inst.args[0]) && invariant(inst.args[1])) {
+                    kinds[inst.dest] = kInvariant;
+                    idiom.invariants.push_back(inst);
+                } else
+                if (inst.op == "add" && ((is(inst.args[0], kIndex) && inst.args[1] == "1") ||
+                                         (is(inst.args[1], kIndex) && inst.args[0] == "1"))) {
+                    kinds[inst.dest] = kNext;
+                } else {
+                    return false;
+                }
+            } else
+            if (inst.kind == Inst::kGetElemPtr || inst.kind == Inst::kGetPtr) {
+                if (!invariant(inst.args[0])) return false;
+                if (invariant(inst.args[1])) {
+                    kinds[inst.dest] = kInvariant;
+                    idiom.invariants.push_back(inst);
+                } else
+                if (is(inst.args[1], kIndex)) {
+                    kinds[inst.dest] = kElemPtr;
+                    elemPtrs[inst.dest] = inst;
+                } else {
+                    return false;
+                }
+            } else
+            if (inst.kind == Inst::kStore && inst.args[1] == info.ivar) {
+                if (stepped || !is(inst.args[0], kNext)) return false;
+                stepped = true;
+            } else
+            if (inst.kind == Inst::kStore && is(inst.args[1], kElemPtr)) {
+                if (stored) return false;
+                stored = true;
+                idiom.dst = elemPtrs[inst.args[1]];
+                if (is(inst.args[0], kElemLoad)) {
+                    idiom.isCopy = true;
+                } else
+                if (invariant(inst.args[0])) {
+                    idiom.isCopy = false;
+                    idiom.value = inst.args[0];
+                } else {
+                    return false;
+                }
+            } else {
+                return false;
+            }
+        }
+        return stepped && stored;
+    }
+
+private:
+    const Function &func;
+    const Loop &loop;
+    const CountedLoop &info;
+    map<string, string> globals;    // 全局变量 => 类型
+    map<string, string> allocs;     // 局部变量 => 类型
+    set<string> definedInLoop, storedInLoop;
+};
+
+// 把循环替换为 preheader 中对运行时库函数的调用
+static void ReplaceLoop(Module &module, Function &func, const Loop &loop, const CountedLoop &info, const LoopIdiom &idiom) {
+    string tag = module.NewTag("idiom");
+    auto &pre = func.bbs[info.preheader].insts;
+    Inst jump = pre.back();
+    pre.pop_back();
+
+    // header 中的计算 (循环变量的初值, 循环的边界) 与循环体中不变的计算复制到 preheader 中
+    map<string, string> rename;
+    auto copy = [&](Inst inst) {
+        inst.RenameUses(rename);
+        rename[inst.dest] = TagSymbol(inst.dest, tag);
+        inst.dest = rename[inst.dest];
+        pre.push_back(inst);
+    };
+    auto &header = func.bbs[info.header].insts;
+    for (size_t i = 0; i + 1 < header.size(); i++) copy(header[i]);
+    for (auto &inst : idiom.invariants) copy(inst);
+    auto value = [&](const string &name) {
+        return rename.count(name) ? rename[name] : name;
+    };
+
+    int temps = 0;
+    auto emit = [&](Inst::Kind kind, const string &op, const vector<string> &args) {
+        Inst inst;
+        inst.kind = kind;
+        inst.op = op;
+        inst.args = args;
+        if (kind != Inst::kStore && kind != Inst::kCall) inst.dest = "%" + tag + "tmp" + to_string(temps++);
+        pre.push_back(inst);
+        return inst.dest;
+    };
+    // 迭代次数 count = max(bound - start, 0), le 时为 max(bound - start + 1, 0)
+    string start = value(info.ivLoad);
+    string count = emit(Inst::kBinary, "sub", {value(info.bound), start});
+    if (info.cmpOp == "le") count = emit(Inst::kBinary, "add", {count, "1"});
+    string positive = emit(Inst::kBinary, "gt", {count, "0"});
+    count = emit(Inst::kBinary, "mul", {count, positive});
+
+    string dst = emit(idiom.dst.kind, "", {value(idiom.dst.args[0]), start});
+    if (idiom.isCopy) {
+        string src = emit(idiom.src.kind, "", {value(idiom.src.args[0]), start});
+        emit(Inst::kCall, MEMCPY_FUNC, {dst, src, count});
+    } else {
+        emit(Inst::kCall, MEMSET_FUNC, {dst, value(idiom.value), count});
+    }
+    // 循环变量在循环结束之后的值
+    string end = emit(Inst::kBinary, "add", {start, count});
+    emit(Inst::kStore, "", {end, info.ivar});
+
+    // 循环中定义的值不在循环之外使用时, 直接跳转到出口, 否则仍然经过 header (此时条件一定不成立)
+    set<string> defs;
+    for (int bb : loop.blocks) {
+        for (auto &inst : func.bbs[bb].insts) {
+            if (!inst.dest.empty()) defs.insert(inst.dest);
+        }
+    }
+    bool usedOutside = false;
+    for (size_t bb = 0; bb < func.bbs.size(); bb++) {
+        if (loop.Contains(bb)) continue;
+        for (auto &inst : func.bbs[bb].insts) {
+            for (auto &arg : inst.args) {
+                if (defs.count(arg)) usedOutside = true;
+            }
+        }
+    }
+    if (!usedOutside) jump.targets[0] = func.bbs[info.exit].name;
+    pre.push_back(jump);
+    SortBlocks(func);
+}
+
+// 在模块中加入运行时库函数的声明
+static void DeclareHelper(Module &module, const string &name, const string &secondType) {
+    if (module.GetFunction(name) != nullptr) return;
+    Function decl;
+    decl.name = name;
+    decl.isDecl = true;
+    decl.params = {{"", "*i32"}, {"", secondType}, {"", "i32"}};
+    module.funcs.insert(module.funcs.begin(), decl);
+}
+
+void LoopIdiomRecognize(Module &module) {
+    bool useMemset = false, useMemcpy = false;
+    for (auto &func : module.funcs) {
+        if (func.isDecl || func.bbs.empty()) continue;
+        // 每次替换之后重新分析控制流
+        bool changed = true;
+        while (changed) {
+            changed = false;
+            CFGInfo cfg(func);
+            for (auto &loop : FindLoops(cfg)) {
+                CountedLoop info;
+                LoopIdiom idiom;
+                if (!AnalyzeCountedLoop(func, cfg, loop, info)) continue;
+                long long trip = GetTripCount(info);
+                if (trip >= 0 && trip < IDIOM_MIN_TRIP) continue;
+                if (!IdiomMatcher(module, func, loop, info).Match(idiom)) continue;
+                ReplaceLoop(module, func, loop, info, idiom);
+                (idiom.isCopy ? useMemcpy : useMemset) = true;
+                changed = true;
+                break;
+            }
+        }
+    }
+    if (useMemset) DeclareHelper(module, MEMSET_FUNC, "i32");
+    if (useMemcpy) DeclareHelper(module, MEMCPY_FUNC, "*i32");
+}
@@ -0,0 +1,77 @@
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// 复制到所有 latch 中的 header 指令 (条件跳转除外) 的最大总条数
+const int ROTATE_MAX_SIZE = 16;
+
+// 循环旋转: 把在 header 中判断条件的循环改为在末尾判断条件
+//   原循环:  header: 计算条件; br cond, body, exit      latch: ...; jump header
+//   旋转后:  header: 计算条件; br cond, body, exit      (只从循环外进入, 作为第一次迭代前的判断)
+//            latch:  ...; 复制的 header 指令; br cond', body, exit
+// 每次迭代只执行 latch 末尾的一次条件跳转, 不再需要跳回 header 的 jump
+// 有以条件跳转回到 header 的 latch (如 continue) 时不旋转, 旋转后 header 仍然会在循环中执行, 收益很小
+// 返回所有的 latch, 不能旋转时返回空
+static vector<int> RotatableLatches(const Function &func, const CFGInfo &cfg, const Loop &loop) {
+    int header = loop.header;
+    if (header == 0) return {};
+    const BasicBlock &bb = func.bbs[header];
+    const Inst &br = bb.Terminator();
+    if (br.kind != Inst::kBranch) return {};
+    auto index = func.BlockIndex();
+    int t = index.at(br.targets[0]), f = index.at(br.targets[1]);
+    if (loop.Contains(t) == loop.Contains(f)) return {};
+
+    for (int latch : loop.latches) {
+        if (func.bbs[latch].Terminator().kind != Inst::kJump) return {};
+    }
+    int size = (bb.insts.size() - 1) * loop.latches.size();
+    if (size > ROTATE_MAX_SIZE) return {};
+
+    // header 中的值只在 header 中使用, 复制之后不需要合并两份定义
+    set<string> defs;
+    for (auto &inst : bb.insts) {
+        if (inst.kind == Inst::kAlloc) return {};
+        if (!inst.dest.empty()) defs.insert(inst.dest);
+    }
+    for (size_t i = 0; i < func.bbs.size(); i++) {
+        if ((int)i == header || !cfg.IsReachable(i)) continue;
+        for (auto &inst : func.bbs[i].insts) {
+            for (auto &arg : inst.args) {
+                if (defs.count(arg)) return {};
+            }
+        }
+    }
+    return loop.latches;
+}
+
+// 把 latch 末尾的 jump header 替换为 header 中指令的一份复制
+static void Rotate(Module &module, Function &func, const Loop &loop, const vector<int> &latches) {
+    const BasicBlock header = func.bbs[loop.header];
+    for (int latch : latches) {
+        string tag = module.NewTag("rotate");
+        auto &insts = func.bbs[latch].insts;
+        insts.pop_back();
+        map<string, string> rename;
+        for (auto &inst : header.insts) {
+            if (!inst.dest.empty()) rename[inst.dest] = TagSymbol(inst.dest, tag);
+        }
+        for (Inst inst : header.insts) {
+            if (!inst.dest.empty()) inst.dest = rename[inst.dest];
+            inst.RenameUses(rename);
+            insts.push_back(inst);
+        }
+    }
+}
+
+void LoopRotate(Module &module) {
+    for (auto &func : module.funcs) {
+        if (func.isDecl || func.bbs.empty()) continue;
+        // 旋转只改写 latch 的结尾, 基本块的下标不变, 每个循环只需判断一次
+        CFGInfo cfg(func);
+        for (auto &loop : FindLoops(cfg)) {
+            vector<int> latches = RotatableLatches(func, cfg, loop);
+            if (!latches.empty()) Rotate(module, func, loop, latches);
+        }
+    }
+}
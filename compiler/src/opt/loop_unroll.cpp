@@ -0,0 +1,182 @@
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// 完全展开的最大迭代次数
+const int FULL_UNROLL_MAX_TRIP = 16;
+// 完全展开后的最大指令条数
+const int FULL_UNROLL_MAX_SIZE = 256;
+// 部分展开后循环的最大指令条数
+const int PARTIAL_UNROLL_MAX_SIZE = 512;
+
+// header 中被循环体使用的值 (以及计算它们需要的值), 保持原来的顺序
+static vector<Inst> GetHeaderValuesUsedInBody(const Function &func, const Loop &loop, int header) {
+    auto &headerInsts = func.bbs[header].insts;
+    set<string> needed;
+    for (int bb : loop.blocks) {
+        if (bb == header) continue;
+        for (auto &inst : func.bbs[bb].insts) {
+            for (auto &arg : inst.args) needed.insert(arg);
+        }
+    }
+    for (auto it = headerInsts.rbegin(); it != headerInsts.rend(); it++) {
+        if (needed.count(it->dest)) {
+            for (auto &arg : it->args) needed.insert(arg);
+        }
+    }
+    vector<Inst> ret;
+    for (size_t i = 0; i + 1 < headerInsts.size(); i++) {
+        if (needed.count(headerInsts[i].dest)) ret.push_back(headerInsts[i]);
+    }
+    return ret;
+}
+
+// 复制一份循环体, 复制出的 latch 跳转到 next
+// 循环体中用到的 header 中的值, 在复制出的循环体入口处重新计算
+static vector<BasicBlock> CloneBody(Module &module, const Function &func, const Loop &loop, const CountedLoop &info,
+                                    const vector<Inst> &headerValues, const string &next) {
+    string tag = module.NewTag("unroll");
+    map<string, string> rename;
+    rename[func.bbs[info.header].name] = next;
+    vector<Inst> prelude = headerValues;
+    for (auto &inst : prelude) rename[inst.dest] = TagSymbol(inst.dest, tag);
+    for (auto &inst : prelude) {
+        inst.dest = rename[inst.dest];
+        inst.RenameUses(rename);
+    }
+
+    vector<int> blocks;
+    for (int bb : loop.blocks) {
+        if (bb != info.header) blocks.push_back(bb);
+    }
+    vector<BasicBlock> copies = CloneBlocks(func, blocks, tag, rename);
+    string bodyName = TagSymbol(info.body, tag);
+    for (auto &copy : copies) {
+        if (copy.name == bodyName) copy.insts.insert(copy.insts.begin(), prelude.begin(), prelude.end());
+    }
+    // 循环体入口放在最前面
+    stable_partition(copies.begin(), copies.end(), [&](const BasicBlock &bb) { return bb.name == bodyName; });
+    return copies;
+}
+
+// 完全展开: preheader => 第 1 份循环体 => ... => 第 trip 份循环体 => exit
+static void FullUnroll(Module &module, Function &func, const Loop &loop, const CountedLoop &info, int trip) {
+    vector<Inst> headerValues = GetHeaderValuesUsedInBody(func, loop, info.header);
+    string next = func.bbs[info.exit].name;
+    vector<BasicBlock> blocks;
+    for (int i = 0; i < trip; i++) {
+        vector<BasicBlock> copies = CloneBody(module, func, loop, info, headerValues, next);
+        next = copies[0].name;
+        blocks.insert(blocks.begin(), copies.begin(), copies.end());
+    }
+    func.bbs[info.preheader].Terminator().targets[0] = next;
+    func.bbs.insert(func.bbs.begin() + info.header, blocks.begin(), blocks.end());
+}
+
+// 部分展开:
+// 返回新的 header 的名称
+//   header_u: 计算 header 中的值; br (iv + (factor-1)*step) cmp bound, 第 1 份循环体, header
+//   第 1 份循环体 => ... => 第 factor 份循环体 => header_u
+//   header 以及原循环处理剩余不足 factor 次的迭代
+static string PartialUnroll(Module &module, Function &func, const Loop &loop, const CountedLoop &info, int factor) {
+    vector<Inst> headerValues = GetHeaderValuesUsedInBody(func, loop, info.header);
+    const BasicBlock &header = func.bbs[info.header];
+    string tag = module.NewTag("unroll");
+    string newHeaderName = TagSymbol(header.name, tag);
+
+    string next = newHeaderName;
+    vector<BasicBlock> blocks;
+    for (int i = 0; i < factor; i++) {
+        vector<BasicBlock> copies = CloneBody(module, func, loop, info, headerValues, next);
+        next = copies[0].name;
+        blocks.insert(blocks.begin(), copies.begin(), copies.end());
+    }
+
+    // 新的 header: 复制原 header 中除条件跳转外的指令, 再判断剩余迭代次数是否不少于 factor
+    BasicBlock newHeader;
+    newHeader.name = newHeaderName;
+    map<string, string> rename;
+    for (size_t i = 0; i + 1 < header.insts.size(); i++) {
+        Inst inst = header.insts[i];
+        if (inst.dest == header.Terminator().args[0]) continue;
+        rename[inst.dest] = TagSymbol(inst.dest, tag);
+        inst.dest = rename[inst.dest];
+        inst.RenameUses(rename);
+        newHeader.insts.push_back(inst);
+    }
+    auto renamed = [&](const string &value) { return rename.count(value) ? rename[value] : value; };
+    Inst add;
+    add.kind = Inst::kBinary;
+    add.dest = "%" + tag + "iv";
+    add.op = "add";
+    add.args = {renamed(info.ivLoad), to_string((factor - 1) * info.step)};
+    Inst cmp;
+    cmp.kind = Inst::kBinary;
+    cmp.dest = "%" + tag + "cond";
+    cmp.op = info.cmpOp;
+    cmp.args = {add.dest, renamed(info.bound)};
+    Inst br;
+    br.kind = Inst::kBranch;
+    br.args = {cmp.dest};
+    br.targets = {next, header.name};
+    newHeader.insts.push_back(add);
+    newHeader.insts.push_back(cmp);
+    newHeader.insts.push_back(br);
+    blocks.insert(blocks.begin(), newHeader);
+
+    func.bbs[info.preheader].Terminator().targets[0] = newHeaderName;
+    func.bbs.insert(func.bbs.begin() + info.header, blocks.begin(), blocks.end());
+    return newHeaderName;
+}
+
+// 找到一个可以展开的循环并展开, 没有找到时返回 false
+static bool UnrollOneLoop(Module &module, Function &func, int factor, set<string> &visited) {
+    CFGInfo cfg(func);
+    vector<Loop> loops = FindLoops(cfg);
+    for (auto &loop : loops) {
+        if (!IsInnermostLoop(loop, loops)) continue;
+        string headerName = func.bbs[loop.header].name;
+        if (visited.count(headerName)) continue;
+        visited.insert(headerName);
+
+        CountedLoop info;
+        if (!AnalyzeCountedLoop(func, cfg, loop, info)) continue;
+        // header 中的值在循环外被使用时, 不能去掉 header
+        set<string> headerDefs;
+        for (auto &inst : func.bbs[loop.header].insts) {
+            if (!inst.dest.empty()) headerDefs.insert(inst.dest);
+        }
+        bool usedOutside = false;
+        for (size_t bb = 0; bb < func.bbs.size(); bb++) {
+            if (loop.Contains(bb)) continue;
+            for (auto &inst : func.bbs[bb].insts) {
+                for (auto &arg : inst.args) usedOutside |= headerDefs.count(arg) != 0;
+            }
+        }
+
+        int size = 0;
+        for (int bb : loop.blocks) size += func.bbs[bb].insts.size();
+        long long trip = GetTripCount(info);
+        if (trip >= 0 && trip <= FULL_UNROLL_MAX_TRIP && trip * size <= FULL_UNROLL_MAX_SIZE && !usedOutside) {
+            FullUnroll(module, func, loop, info, trip);
+        } else
+        if (factor >= 2 && size * factor <= PARTIAL_UNROLL_MAX_SIZE && (trip < 0 || trip >= factor)) {
+            // 展开后的新循环不再展开
+            visited.insert(PartialUnroll(module, func, loop, info, factor));
+        } else {
+            continue;
+        }
+        SortBlocks(func);
+        return true;
+    }
+    return false;
+}
+
+void LoopUnroll(Module &module, int factor) {
+    for (auto &func : module.funcs) {
+        if (func.isDecl) continue;
+        HoistAllocs(func);
+        set<string> visited;
+        while (UnrollOneLoop(module, func, factor, visited));
+    }
+}
@@ -0,0 +1,33 @@
+#include "opt_main.hpp"
+
+int optUnrollFactor = 4;
+int optInlineThreshold = 50;
+
+bool ParseOptOption(const char option[]) {
+    return PassManager::Get().ParseOption(option);
+}
+
+bool OptEnabled() {
+    return PassManager::Get().HasIRPass();
+}
+
+void opt_main(const char input[], const char output[]){
+    // 从input中读取IR
+    ifstream fin(input);
+    std::istreambuf_iterator<char> beg(fin), end;
+    std::string IRText(beg, end);
+    fin.close();
+
+    // 解析文本IR
+    Module module;
+    module.Parse(IRText);
+
+    // 依次执行选择的优化遍
+    PassManager::Get().Run(module);
+
+    // 输出优化后的IR
+    std::string IRTree;
+    module.Print(IRTree);
+    ofstream fout(output);
+    fout << IRTree;
+}
@@ -0,0 +1,25 @@
+#pragma once
+#include <cassert>
+#include <cstdio>
+#include <iostream>
+#include <fstream>
+#include <string>
+#include "IR.hpp"
+#include "passes.hpp"
+#include "pass_manager.hpp"
+
+using namespace std;
+
+// 循环展开的倍数 (-funroll=N): 为 1 时只完全展开迭代次数较少的循环
+extern int optUnrollFactor;
+// 函数内联的阈值 (-finline-threshold=N): 内联代价不超过 N 的调用
+extern int optInlineThreshold;
+
+// 解析优化相关的命令行参数 (-O0~-O3, -passes=..., -time-passes 等), 不是优化相关的参数时返回 false
+bool ParseOptOption(const char option[]);
+
+// 是否开启了任意一个中端优化
+bool OptEnabled();
+
+// 中端读入input文件中的文本IR, 进行优化后输出到output文件中
+void opt_main(const char input[], const char output[]);
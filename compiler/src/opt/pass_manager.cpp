@@ -0,0 +1,123 @@
+#include <cassert>
+#include <cstdio>
+#include <chrono>
+#include "pass_manager.hpp"
+#include "passes.hpp"
+#include "opt_main.hpp"
+#include "../back/back_main.hpp"
+using namespace std;
+
+// 各个优化等级对应的优化遍序列, 中端与后端的优化遍可以混合出现
+static const map<string, string> PIPELINES = {
+    {"-O0", ""},
+    {"-O1", "simplify-cfg"},
+    {"-O2", "tail-recursion,ipcp,inline,sroa,loop-idiom,promote-globals,simplify-cfg,loop-rotate,load-store-opt,tail-call"},
+    {"-O3", "tail-recursion,ipcp,inline,sroa,loop-idiom,promote-globals,simplify-cfg,if-convert,unroll,simplify-cfg,loop-rotate,load-store-opt,tail-call"},
+};
+
+PassManager::PassManager() {
+    irPasses = {
+        {"simplify-cfg", [](Module &module) { SimplifyCFG(module); }},
+        {"tail-recursion", [](Module &module) { TailRecursionElim(module); }},
+        {"ipcp", [](Module &module) { IPConstProp(module); }},
+        {"inline", [](Module &module) { Inline(module, optInlineThreshold); }},
+        {"load-store-opt", [](Module &module) { LoadStoreOpt(module); }},
+        {"sroa", [](Module &module) { ScalarReplace(module); }},
+        {"loop-idiom", [](Module &module) { LoopIdiomRecognize(module); }},
+        {"promote-globals", [](Module &module) { PromoteGlobals(module); }},
+        {"unroll", [](Module &module) { LoopUnroll(module, optUnrollFactor); }},
+        {"if-convert", [](Module &module) { IfConvert(module); }},
+        {"loop-rotate", [](Module &module) { LoopRotate(module); }},
+    };
+    machinePasses = {
+        {"tail-call", &backTailCall},
+    };
+}
+
+const IRPass *PassManager::FindIRPass(const string &name) const {
+    for (auto &pass : irPasses) {
+        if (pass.name == name) return &pass;
+    }
+    return nullptr;
+}
+
+MachinePass *PassManager::FindMachinePass(const string &name) {
+    for (auto &pass : machinePasses) {
+        if (pass.name == name) return &pass;
+    }
+    return nullptr;
+}
+
+void PassManager::SetPipeline(const string &passes) {
+    pipeline.clear();
+    for (auto &pass : machinePasses) *pass.enable = false;
+
+    size_t start = 0;
+    while (start < passes.size()) {
+        size_t end = passes.find(',', start);
+        if (end == string::npos) end = passes.size();
+        string name = passes.substr(start, end - start);
+        start = end + 1;
+        if (name.empty()) continue;
+
+        if (FindIRPass(name) != nullptr) {
+            pipeline.push_back(name);
+        } else
+        if (FindMachinePass(name) != nullptr) {
+            *FindMachinePass(name)->enable = true;
+        } else {
+            printf("[PassManager] unknown pass %s\n", name.c_str());
+            assert(0);
+        }
+    }
+}
+
+bool PassManager::ParseOption(const string &option) {
+    if (PIPELINES.count(option)) {
+        SetPipeline(PIPELINES.at(option));
+    } else
+    if (option.compare(0, 8, "-passes=") == 0) {
+        SetPipeline(option.substr(8));
+    } else
+    if (option == "-time-passes") {
+        timePasses = true;
+    } else
+    if (option.compare(0, 9, "-funroll=") == 0) {
+        optUnrollFactor = atoi(option.c_str() + 9);
+    } else
+    if (option.compare(0, 19, "-finline-threshold=") == 0) {
+        optInlineThreshold = atoi(option.c_str() + 19);
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool PassManager::HasIRPass() const {
+    return !pipeline.empty();
+}
+
+void PassManager::Run(Module &module) {
+    if (timePasses) {
+        fprintf(stderr, "===------------------------------------------===\n");
+        fprintf(stderr, "        Pass execution timing report\n");
+        fprintf(stderr, "===------------------------------------------===\n");
+        fprintf(stderr, "  %10s  %8s  %8s  %7s  %s\n", "time(ms)", "before", "after", "delta", "pass");
+    }
+    double total = 0;
+    for (auto &name : pipeline) {
+        int before = module.InstCount();
+        auto start = chrono::steady_clock::now();
+        FindIRPass(name)->run(module);
+        auto end = chrono::steady_clock::now();
+        double ms = chrono::duration<double, milli>(end - start).count();
+        total += ms;
+        if (timePasses) {
+            int after = module.InstCount();
+            fprintf(stderr, "  %10.3f  %8d  %8d  %+7d  %s\n", ms, before, after, after - before, name.c_str());
+        }
+    }
+    if (timePasses) {
+        fprintf(stderr, "  %10.3f  %8s  %8d  %7s  %s\n", total, "", module.InstCount(), "", "total");
+    }
+}
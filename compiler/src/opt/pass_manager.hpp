@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include "IR.hpp"
+
+/**************** 优化遍管理 ****************/
+
+// 中端优化遍: 对整个程序的 IR 进行变换
+struct IRPass {
+    std::string name;
+    std::function<void(Module &)> run;
+};
+
+// 后端优化遍: 在生成 RISCV 时进行, 只需要打开对应的开关
+struct MachinePass {
+    std::string name;
+    bool *enable;
+};
+
+// 注册所有的优化遍, 根据 -O0/-O1/-O2/-O3 或者 -passes=a,b,c 组装出优化遍的序列并依次执行
+class PassManager {
+public:
+    static PassManager &Get() {
+        static PassManager manager;
+        return manager;
+    }
+
+    // 解析优化相关的命令行参数, 不是优化相关的参数时返回 false
+    //   -O0 / -O1 / -O2 / -O3      选择预设的优化遍序列
+    //   -passes=a,b,c              自定义优化遍序列
+    //   -time-passes               输出每个中端优化遍的耗时与 IR 大小的变化
+    //   -funroll=N                 循环展开的倍数
+    //   -finline-threshold=N       函数内联的阈值
+    bool ParseOption(const std::string &option);
+
+    // 是否有需要执行的中端优化遍
+    bool HasIRPass() const;
+
+    // 依次执行序列中的中端优化遍
+    void Run(Module &module);
+
+private:
+    std::vector<IRPass> irPasses;
+    std::vector<MachinePass> machinePasses;
+    std::vector<std::string> pipeline;      // 中端优化遍的序列
+    bool timePasses = false;
+
+    PassManager();
+    void SetPipeline(const std::string &passes);
+    const IRPass *FindIRPass(const std::string &name) const;
+    MachinePass *FindMachinePass(const std::string &name);
+};
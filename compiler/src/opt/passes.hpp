@@ -0,0 +1,42 @@
+#pragma once
+#include "IR.hpp"
+
+/**************** 中端优化遍 ****************/
+
+// 循环展开: 迭代次数较少的计数循环完全展开, 其余计数循环按 factor 部分展开, 并保留原循环处理剩余的迭代
+void LoopUnroll(Module &module, int factor);
+
+// 控制流图化简: 折叠常量条件跳转, 穿过只有 jump 的基本块, 删除不可达的基本块, 合并只有唯一前驱/后继的基本块
+void SimplifyCFG(Module &module);
+
+// 尾递归消除: 自递归的尾调用改写为把实参存入参数的栈空间, 再跳回函数体的开头
+void TailRecursionElim(Module &module);
+
+// 函数内联: 按调用图自底向上处理, 内联代价 (被调用函数大小减去调用开销等收益) 不超过 threshold 的调用
+// 同一个强连通分量中的 (递归) 调用不内联, 内联后删除 main 不再调用到的函数
+void Inline(Module &module, int threshold);
+
+// 过程间常量传播: 所有调用点都传入同一个常量的参数直接代入函数体
+// 常量实参组合在调用点 (按是否在循环中加权) 中足够常见时, 复制出该组合的特化版本并改写这些调用点
+void IPConstProp(Module &module);
+
+// 全局变量提升: 根据各个函数对全局变量的读写摘要, 把函数中频繁访问的标量全局变量提升为局部变量
+// 入口处读取, 在调用会读写它的函数前后以及返回前与全局变量同步; 同一个基本块中重复的 load 直接使用已知的值
+void PromoteGlobals(Module &module);
+
+// load/store 优化: 基于别名分析 (alias.hpp) 消除冗余的 load 与被覆盖的 store, 删除只写不读的局部变量
+void LoadStoreOpt(Module &module);
+
+// 标量替换: 元素个数较少, 并且只用常量下标访问的局部数组, 拆分为每个元素一个局部变量
+void ScalarReplace(Module &module);
+
+// 循环惯用法识别: 逐个元素赋值为同一个值/逐个元素复制的计数循环, 替换为对运行时库函数 __memset_i32/__memcpy_i32 的调用
+// 运行时库函数由后端生成
+void LoopIdiomRecognize(Module &module);
+
+// if 转换: 只读写标量变量的短小的菱形/三角形条件分支, 改为无条件执行两个分支, 再用比较结果生成的掩码选择写入的值
+void IfConvert(Module &module);
+
+// 循环旋转: 在 header 中判断条件的循环, 把 header 复制到每个跳回 header 的基本块末尾, 改为在循环末尾判断条件
+// 原 header 只在进入循环前执行一次, 每次迭代少执行一次跳转
+void LoopRotate(Module &module);
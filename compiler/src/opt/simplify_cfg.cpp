@@ -0,0 +1,104 @@
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// 条件为常量, 或者两个目标相同的条件跳转, 改为无条件跳转
+static bool FoldConstantBranches(Function &func) {
+    bool changed = false;
+    for (auto &bb : func.bbs) {
+        Inst &term = bb.Terminator();
+        if (term.kind != Inst::kBranch) continue;
+        string target;
+        if (IsConstOperand(term.args[0])) {
+            target = atoi(term.args[0].c_str()) != 0 ? term.targets[0] : term.targets[1];
+        } else
+        if (term.targets[0] == term.targets[1]) {
+            target = term.targets[0];
+        } else {
+            continue;
+        }
+        term.kind = Inst::kJump;
+        term.args.clear();
+        term.targets = {target};
+        changed = true;
+    }
+    return changed;
+}
+
+// 只有一条 jump 的基本块 (入口基本块除外), 跳转到它的地方直接跳转到它的目标
+static bool ThreadJumps(Function &func) {
+    // 空基本块 => 最终的跳转目标
+    map<string, string> forward;
+    for (size_t i = 1; i < func.bbs.size(); i++) {
+        auto &bb = func.bbs[i];
+        if (bb.insts.size() == 1 && bb.insts[0].kind == Inst::kJump && bb.insts[0].targets[0] != bb.name) {
+            forward[bb.name] = bb.insts[0].targets[0];
+        }
+    }
+    // 沿着空基本块组成的链找到最终目标, 链成环时保持不变
+    map<string, string> rename;
+    for (auto &item : forward) {
+        string target = item.second;
+        set<string> visited = {item.first};
+        while (forward.count(target) && visited.insert(target).second) target = forward[target];
+        if (!forward.count(target)) rename[item.first] = target;
+    }
+    bool changed = false;
+    for (auto &bb : func.bbs) {
+        Inst &term = bb.Terminator();
+        for (auto &target : term.targets) {
+            auto it = rename.find(target);
+            if (it != rename.end()) {
+                target = it->second;
+                changed = true;
+            }
+        }
+    }
+    return changed;
+}
+
+// A 以 jump B 结尾, 并且 B 只有 A 一个前驱时, 把 B 合并到 A 中
+static bool MergeBlocks(Function &func) {
+    bool changed = false;
+    CFGInfo cfg(func);
+    vector<bool> removed(func.bbs.size(), false);
+    for (int a : cfg.rpo) {
+        if (removed[a]) continue;
+        while (func.bbs[a].Terminator().kind == Inst::kJump) {
+            int b = cfg.succs[a][0];
+            if (b == 0 || b == a || cfg.preds[b].size() != 1) break;
+            auto &insts = func.bbs[a].insts;
+            insts.pop_back();
+            insts.insert(insts.end(), func.bbs[b].insts.begin(), func.bbs[b].insts.end());
+            cfg.succs[a] = cfg.succs[b];
+            for (int succ : cfg.succs[b]) {
+                for (auto &pred : cfg.preds[succ]) {
+                    if (pred == b) pred = a;
+                }
+            }
+            removed[b] = true;
+            changed = true;
+        }
+    }
+    vector<BasicBlock> bbs;
+    for (size_t i = 0; i < func.bbs.size(); i++) {
+        if (!removed[i]) bbs.push_back(func.bbs[i]);
+    }
+    func.bbs = bbs;
+    return changed;
+}
+
+void SimplifyCFG(Module &module) {
+    for (auto &func : module.funcs) {
+        if (func.isDecl || func.bbs.empty()) continue;
+        bool changed = true;
+        while (changed) {
+            changed = FoldConstantBranches(func);
+            changed |= ThreadJumps(func);
+            // 删除不可达的基本块
+            SortBlocks(func);
+            changed |= MergeBlocks(func);
+        }
+        SortBlocks(func);
+    }
+}
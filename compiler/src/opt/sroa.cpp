@@ -0,0 +1,121 @@
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// 拆分的数组的最大元素个数
+const int SROA_MAX_ELEMS = 16;
+
+// 数组类型的各维长度, 从外到内, 如 "[[i32, 3], 2]" => {2, 3}, 不是数组时为空
+static vector<int> ArrayDims(string type) {
+    vector<int> dims;
+    while (type[0] == '[') {
+        size_t comma = type.rfind(',');
+        dims.push_back(atoi(type.c_str() + comma + 1));
+        type = type.substr(1, comma - 1);
+    }
+    return dims;
+}
+
+// 把数组 alloc 拆分为每个元素一个 alloc i32
+// 要求数组只通过下标全是常量的 getelemptr 访问, 并且得到的元素指针只被 load/store 使用
+class ArraySplitter {
+public:
+    ArraySplitter(Function &func) : func(func) {
+        for (auto &bb : func.bbs) {
+            for (auto &inst : bb.insts) {
+                for (size_t k = 0; k < inst.args.size(); k++) uses[inst.args[k]].push_back(make_pair(&inst, k));
+            }
+        }
+    }
+
+    // 检查数组 alloc 能否拆分, 能拆分时记录每个元素指针对应的元素下标
+    bool Check(const Inst &alloc) {
+        dims = ArrayDims(alloc.op);
+        if (dims.empty()) return false;
+        int count = 1;
+        for (int dim : dims) count *= dim;
+        if (count > SROA_MAX_ELEMS) return false;
+        chain.clear();
+        elems.clear();
+        return Visit(alloc.dest, 0, 0);
+    }
+
+    // 拆分: 元素指针替换为新的 alloc, 删除原来的 alloc 和 getelemptr
+    void Apply(const string &array, const string &tag) {
+        map<string, string> replace;
+        set<int> used;
+        for (auto &item : elems) {
+            string scalar = "%" + tag + array.substr(1) + "_" + to_string(item.second);
+            replace[item.first] = scalar;
+            used.insert(item.second);
+        }
+        for (auto &bb : func.bbs) {
+            vector<Inst> insts;
+            for (auto &inst : bb.insts) {
+                if (inst.dest == array) {
+                    for (int index : used) {
+                        Inst scalar;
+                        scalar.kind = Inst::kAlloc;
+                        scalar.dest = "%" + tag + array.substr(1) + "_" + to_string(index);
+                        scalar.op = "i32";
+                        insts.push_back(scalar);
+                    }
+                    continue;
+                }
+                if (chain.count(inst.dest)) continue;
+                inst.RenameUses(replace);
+                insts.push_back(inst);
+            }
+            bb.insts = insts;
+        }
+    }
+
+private:
+    Function &func;
+    map<string, vector<pair<Inst *, size_t> > > uses;
+    vector<int> dims;
+    set<string> chain;              // 数组上的所有 getelemptr
+    map<string, int> elems;         // 元素指针 => 展平后的元素下标
+
+    // ptr 指向数组的第 level 维, 展平后的起始下标为 base
+    bool Visit(const string &ptr, size_t level, int base) {
+        if (!uses.count(ptr)) return true;
+        for (auto &use : uses[ptr]) {
+            Inst &inst = *use.first;
+            if (level == dims.size()) {
+                // 元素指针只能作为 load/store 的地址
+                bool isAddress = (inst.kind == Inst::kLoad) || (inst.kind == Inst::kStore && use.second == 1);
+                if (!isAddress) return false;
+                elems[ptr] = base;
+                continue;
+            }
+            if (inst.kind != Inst::kGetElemPtr || use.second != 0 || !IsConstOperand(inst.args[1])) return false;
+            int index = atoi(inst.args[1].c_str());
+            if (index < 0 || index >= dims[level]) return false;
+            int stride = 1;
+            for (size_t i = level + 1; i < dims.size(); i++) stride *= dims[i];
+            chain.insert(inst.dest);
+            if (!Visit(inst.dest, level + 1, base + index * stride)) return false;
+        }
+        return true;
+    }
+};
+
+void ScalarReplace(Module &module) {
+    for (auto &func : module.funcs) {
+        if (func.isDecl || func.bbs.empty()) continue;
+        // 每次拆分之后重新收集使用关系
+        while (true) {
+            ArraySplitter splitter(func);
+            string array;
+            // 第一个能拆分的数组, 此时 splitter 中保留着它的检查结果
+            for (auto &bb : func.bbs) {
+                for (auto &inst : bb.insts) {
+                    if (array.empty() && inst.kind == Inst::kAlloc && splitter.Check(inst)) array = inst.dest;
+                }
+            }
+            if (array.empty()) break;
+            splitter.Apply(array, module.NewTag("sroa"));
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#include "passes.hpp"
+#include "analysis.hpp"
+using namespace std;
+
+// bb.insts[i] 是否是尾调用: 调用之后 (可能经过若干只有 jump 的基本块) 直接返回调用的结果
+// void 函数中, 调用之后直接 ret 也是尾调用
+static bool IsTailCall(const Function &func, const BasicBlock &bb, size_t i) {
+    const Inst &call = bb.insts[i];
+    if (call.kind != Inst::kCall || i + 2 != bb.insts.size()) return false;
+    auto index = func.BlockIndex();
+    const Inst *next = &bb.insts[i + 1];
+    set<string> visited;
+    while (next->kind == Inst::kJump) {
+        if (!visited.insert(next->targets[0]).second) return false;
+        const BasicBlock &target = func.bbs[index.at(next->targets[0])];
+        if (target.insts.size() != 1) return false;
+        next = &target.insts[0];
+    }
+    if (next->kind != Inst::kReturn) return false;
+    if (next->args.empty()) return func.retType.empty();
+    return !call.dest.empty() && next->args[0] == call.dest;
+}
+
+// value 是否可能指向当前函数的栈帧 (局部数组)
+// SysY 中指针只能来自全局数组, 局部数组, 或者保存在栈上的数组参数
+// paramSlots 为只保存过函数参数的局部变量, 从其他局部变量 load 出的指针 (如内联之后的参数) 可能指向当前栈帧
+static bool PointsIntoFrame(const map<string, const Inst *> &defs, const set<string> &paramSlots, string value) {
+    while (true) {
+        if (IsConstOperand(value)) return false;
+        auto it = defs.find(value);
+        if (it == defs.end()) return value[0] != '@';     // 全局变量或者函数参数
+        const Inst *def = it->second;
+        if (def->kind == Inst::kGetPtr || def->kind == Inst::kGetElemPtr) {
+            value = def->args[0];
+        } else {
+            return def->kind != Inst::kLoad || !paramSlots.count(def->args[0]);
+        }
+    }
+}
+
+// 把 func 中的自递归尾调用改写为循环
+static void EliminateTailRecursion(Module &module, Function &func) {
+    HoistAllocs(func);
+    auto &entry = func.bbs[0].insts;
+
+    // 入口基本块中, alloc 之后紧接着把参数保存到栈上: store @x_, %x_fParam
+    set<string> params;
+    for (auto &param : func.params) params.insert(param.first);
+    map<string, string> slot;
+    size_t prefix = 0;
+    while (prefix < entry.size() && entry[prefix].kind == Inst::kAlloc) prefix++;
+    while (prefix < entry.size() && entry[prefix].kind == Inst::kStore && params.count(entry[prefix].args[0])) {
+        slot[entry[prefix].args[0]] = entry[prefix].args[1];
+        prefix++;
+    }
+    if (slot.size() != params.size()) return;
+
+    // 参数只能在保存到栈上时使用, 否则循环之后读到的仍是第一次调用时的参数
+    map<string, const Inst *> defs;
+    int paramUses = 0;
+    for (auto &bb : func.bbs) {
+        for (auto &inst : bb.insts) {
+            if (!inst.dest.empty()) defs[inst.dest] = &inst;
+            for (auto &arg : inst.args) paramUses += params.count(arg);
+        }
+    }
+    if (paramUses != (int)params.size()) return;
+
+    // 只被 store 过函数参数的局部变量
+    map<string, bool> onlyParams;
+    for (auto &bb : func.bbs) {
+        for (auto &inst : bb.insts) {
+            if (inst.kind != Inst::kStore) continue;
+            auto it = onlyParams.find(inst.args[1]);
+            onlyParams[inst.args[1]] = params.count(inst.args[0]) && (it == onlyParams.end() || it->second);
+        }
+    }
+    set<string> paramSlots;
+    for (auto &item : onlyParams) {
+        if (item.second) paramSlots.insert(item.first);
+    }
+
+    // 找出所有的自递归尾调用; 实参不能指向当前栈帧, 因为循环的下一轮会复用这些局部数组
+    vector<pair<int, int> > sites;
+    for (size_t bb = 0; bb < func.bbs.size(); bb++) {
+        auto &insts = func.bbs[bb].insts;
+        for (size_t i = 0; i < insts.size(); i++) {
+            if (insts[i].op != func.name || !IsTailCall(func, func.bbs[bb], i)) continue;
+            bool safe = true;
+            for (size_t k = 0; k < insts[i].args.size(); k++) {
+                const string &arg = insts[i].args[k];
+                if (params.count(arg)) safe = false;
+                if (func.params[k].second[0] == '*' && PointsIntoFrame(defs, paramSlots, arg)) safe = false;
+            }
+            if (safe) sites.push_back(make_pair(bb, i));
+        }
+    }
+    if (sites.empty()) return;
+
+    // 入口基本块拆分为: alloc 和保存参数的部分 / 函数体的开始 (循环头)
+    BasicBlock header;
+    header.name = "%" + module.NewTag("tailrec") + "entry";
+    header.insts.assign(entry.begin() + prefix, entry.end());
+    entry.erase(entry.begin() + prefix, entry.end());
+    Inst jump;
+    jump.kind = Inst::kJump;
+    jump.targets.push_back(header.name);
+    entry.push_back(jump);
+
+    // 尾调用改写为: 把实参存入参数的栈空间, 然后跳转到循环头
+    for (auto &site : sites) {
+        // 位于入口基本块中的尾调用此时已经被移动到循环头中
+        auto &insts = site.first == 0 ? header.insts : func.bbs[site.first].insts;
+        int i = site.first == 0 ? site.second - prefix : site.second;
+        Inst call = insts[i];
+        insts.erase(insts.begin() + i, insts.end());
+        for (size_t k = 0; k < call.args.size(); k++) {
+            Inst store;
+            store.kind = Inst::kStore;
+            store.args = {call.args[k], slot[func.params[k].first]};
+            insts.push_back(store);
+        }
+        insts.push_back(jump);
+    }
+    func.bbs.insert(func.bbs.begin() + 1, header);
+    SortBlocks(func);
+}
+
+void TailRecursionElim(Module &module) {
+    for (auto &func : module.funcs) {
+        if (!func.isDecl && !func.bbs.empty()) EliminateTailRecursion(module, func);
+    }
+}
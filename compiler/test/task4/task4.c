@@ -0,0 +1,105 @@
+int grid[3][4] = {1, 2, 3, 4, {5}, {6, 7}};
+int cube[2][3][4] = {{{1}, {2, 3}}, {4, 5, 6, 7, {8}}};
+int sparse[64] = {0, 0, 0, 9, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 7};
+int empty[5][5] = {};
+// 与前端生成的只读数组前缀相同的用户变量, 仍然可以写入
+int __const_count;
+
+int ReadInt() {
+	int ch = getch();
+	while ((ch > '9' || ch < '0') && ch != '-') {
+		ch = getch();
+	}
+	int ans = 0;
+	int flag = 1;
+	if (ch == '-') {
+		flag = -1;
+		ch = getch();
+	}
+	while (ch >= '0' && ch <= '9') {
+		ans = ans * 10 + ch - '0';
+		ch = getch();
+	}
+	return ans * flag;
+}
+
+void PrintInt(int x) {
+	if (x < 0) {
+		putch('-');
+		x = -x;
+	}
+	if (x >= 10) {
+		PrintInt(x / 10);
+	}
+	putch(x % 10 + '0');
+}
+
+// 输出 a 的前 n 个元素, 以空格分隔
+void PrintArray(int a[], int n) {
+	int i = 0;
+	while (i < n) {
+		if (i > 0) {
+			putch(' ');
+		}
+		PrintInt(a[i]);
+		i = i + 1;
+	}
+	putch('\n');
+	__const_count = __const_count + n;
+}
+
+int main() {
+	int x = ReadInt();
+	int y = ReadInt();
+
+	// 不超过 16 个元素的局部数组: 逐个 store
+	int small[2][3] = {{x}, y, x + y};
+	// 超过 16 个元素, 非 0 常量较多: 从只读模板复制后再 store 运行时的值
+	int table[4][5] = {1, 2, 3, 4, 5, {6, x}, {7, 8, 9}, {y, 10, 11, 12, 13}};
+	// 超过 16 个元素, 非 0 常量较少: 清零后再 store
+	int few[3][8] = {{0, x}, {}, {0, 0, y, 1}};
+	int zero[40] = {};
+
+	PrintArray(grid[0], 4);
+	PrintArray(grid[1], 4);
+	PrintArray(grid[2], 4);
+	int i = 0;
+	while (i < 2) {
+		int j = 0;
+		while (j < 3) {
+			PrintArray(cube[i][j], 4);
+			j = j + 1;
+		}
+		i = i + 1;
+	}
+	PrintInt(sparse[3] + sparse[63] * 10 + sparse[32] + empty[4][4]);
+	putch('\n');
+
+	PrintArray(small[0], 3);
+	PrintArray(small[1], 3);
+	i = 0;
+	while (i < 4) {
+		PrintArray(table[i], 5);
+		i = i + 1;
+	}
+	i = 0;
+	while (i < 3) {
+		PrintArray(few[i], 8);
+		i = i + 1;
+	}
+
+	int sum = 0;
+	i = 0;
+	while (i < 40) {
+		sum = sum + zero[i];
+		i = i + 1;
+	}
+	// 写入之后再读取, 确认局部数组没有共享模板
+	table[0][0] = table[0][0] + x;
+	int again[4][5] = {1, 2, 3, 4, 5, {6, y}};
+	PrintInt(sum + table[0][0] * 100 + again[0][0] + again[1][1] * 10);
+	putch('\n');
+	PrintInt(__const_count);
+	putch('\n');
+	return 0;
+}
@@ -0,0 +1,107 @@
+const int days[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+const int primes[2][5] = {{2, 3, 5, 7, 11}, {13, 17, 19, 23}};
+const int weight[4] = {1, 10, 100, 1000};
+// 下标都是常量时在编译时求值, 可以用于常量定义与数组长度
+const int LEAP = days[1] + 1;
+int buffer[primes[0][3] + primes[1][3]];
+
+int ReadInt() {
+	int ch = getch();
+	while ((ch > '9' || ch < '0') && ch != '-') {
+		ch = getch();
+	}
+	int ans = 0;
+	int flag = 1;
+	if (ch == '-') {
+		flag = -1;
+		ch = getch();
+	}
+	while (ch >= '0' && ch <= '9') {
+		ans = ans * 10 + ch - '0';
+		ch = getch();
+	}
+	return ans * flag;
+}
+
+void PrintInt(int x) {
+	if (x < 0) {
+		putch('-');
+		x = -x;
+	}
+	if (x >= 10) {
+		PrintInt(x / 10);
+	}
+	putch(x % 10 + '0');
+}
+
+// 常量数组作为实参传入
+int Sum(int a[], int n) {
+	int i = 0;
+	int sum = 0;
+	while (i < n) {
+		sum = sum + a[i];
+		i = i + 1;
+	}
+	return sum;
+}
+
+// 一年中的第几天
+int DayOfYear(int month, int day, int leap) {
+	int i = 0;
+	int ans = day;
+	while (i < month - 1) {
+		ans = ans + days[i];
+		if (i == 1 && leap) {
+			ans = ans + 1;
+		}
+		i = i + 1;
+	}
+	return ans;
+}
+
+int main() {
+	int n = ReadInt();
+	PrintInt(LEAP);
+	putch(' ');
+	PrintInt(primes[1][4]);
+	putch(' ');
+	PrintInt(Sum(buffer, 30));
+	putch('\n');
+
+	PrintInt(Sum(days, 12));
+	putch(' ');
+	PrintInt(Sum(primes[1], 5));
+	putch('\n');
+
+	while (n > 0) {
+		int month = ReadInt();
+		int day = ReadInt();
+		int leap = ReadInt();
+		PrintInt(DayOfYear(month, day, leap));
+		putch(' ');
+		// 运行时的下标从 .rodata 中读取
+		PrintInt(primes[(month - 1) / 6][month % 5]);
+		putch('\n');
+		n = n - 1;
+	}
+
+	int total = 0;
+	{
+		// 局部常量数组遮蔽全局的 weight
+		const int weight[3] = {7, 8, 9};
+		int i = 0;
+		while (i < 3) {
+			total = total + weight[i] * weight[2];
+			i = i + 1;
+		}
+		total = total + Sum(weight, 3) * weight[0];
+	}
+	int i = 0;
+	while (i < 4) {
+		total = total + weight[i];
+		i = i + 1;
+	}
+	PrintInt(total + weight[3] + Sum(weight, 4));
+	putch('\n');
+	return 0;
+}
@@ -0,0 +1,89 @@
+// 内联之后, 调用者的局部数组经过被内联函数的参数栈空间传给尾调用
+// 尾调用不能在释放栈帧之后再使用这个数组
+
+int ReadInt() {
+	int ch = getch();
+	while ((ch > '9' || ch < '0') && ch != '-') {
+		ch = getch();
+	}
+	int ans = 0;
+	int flag = 1;
+	if (ch == '-') {
+		flag = -1;
+		ch = getch();
+	}
+	while (ch >= '0' && ch <= '9') {
+		ans = ans * 10 + ch - '0';
+		ch = getch();
+	}
+	return ans * flag;
+}
+
+void PrintInt(int x) {
+	if (x < 0) {
+		putch('-');
+		x = -x;
+	}
+	if (x >= 10) {
+		PrintInt(x / 10);
+	}
+	putch(x % 10 + '0');
+}
+
+// 较大的函数, 不会被内联, 使用自己的局部数组覆盖调用者释放的栈空间
+int g(int a[], int k) {
+	int tmp[120];
+	int i = 0;
+	while (i < 120) {
+		tmp[i] = i * k + 1;
+		i = i + 1;
+	}
+	int sum = 0;
+	i = 0;
+	while (i < 40) {
+		sum = sum + a[i] * tmp[i + k];
+		if (sum > 1000000) {
+			sum = sum - 999983;
+		}
+		i = i + 1;
+	}
+	i = 0;
+	while (i < 120) {
+		if (tmp[i] % 3 == 0) {
+			sum = sum + tmp[i] / 3;
+		} else {
+			sum = sum - tmp[i] % 3;
+		}
+		i = i + 1;
+	}
+	return sum;
+}
+
+// 较小的函数, 会被内联到 h 中
+int f(int a[], int n) {
+	int k = n % 7 + 3;
+	return g(a, k);
+}
+
+int h(int n) {
+	int arr[40];
+	int i = 0;
+	while (i < 40) {
+		arr[i] = (i * n + 7) % 101;
+		i = i + 1;
+	}
+	return f(arr, n);
+}
+
+int main() {
+	int n = ReadInt();
+	while (n > 0) {
+		PrintInt(h(ReadInt()));
+		n = n - 1;
+		if (n > 0) {
+			putch(' ');
+		}
+	}
+	putch('\n');
+	return 0;
+}